@@ -0,0 +1,722 @@
+#include "benchmark_functions.h"
+#include "log_duration.h"
+#include "corpus_reader.h"
+#include "write_ahead_log.h"
+#include "result_cursors.h"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <set>
+#include <iostream>
+#include <thread>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define HAS_MALLINFO2
+#endif
+
+#if defined(__linux__)
+#include <unistd.h>
+#define HAS_PROC_STATM
+#endif
+
+using namespace std::literals;
+
+std::string GenerateWord(std::mt19937& generator, int max_length)
+{
+    const int length = std::uniform_int_distribution(1, max_length)(generator);
+    std::string word;
+    word.reserve(length);
+    for(int i = 0; i < length; ++i)
+    {
+        word.push_back(std::uniform_int_distribution('a', 'z')(generator));
+    }
+
+    return word;
+}
+
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length)
+{
+    std::vector<std::string> words;
+    words.reserve(word_count);
+    for(int i = 0; i < word_count; ++i)
+    {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    return words;
+}
+
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, int word_count, double minus_prob)
+{
+    std::string query;
+    for(int i = 0; i < word_count; ++i)
+    {
+        if(!query.empty())
+        {
+            query.push_back(' ');
+        }
+        if(std::uniform_real_distribution<>(0, 1)(generator) < minus_prob)
+        {
+            query.push_back('-');
+        }
+        query += dictionary[std::uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+    }
+
+    return query;
+}
+
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary, int query_count, int max_word_count)
+{
+    std::vector<std::string> queries;
+    queries.reserve(query_count);
+    for(int i = 0; i < query_count; ++i)
+    {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+
+    return queries;
+}
+
+template <typename Ranker>
+void BenchmarkRanker(std::string_view mark, const SearchServer& search_server, const std::vector<std::string>& queries)
+{
+    LOG_DURATION(mark);
+
+    double total_relevance = 0.0;
+    for(const std::string& query : queries)
+    {
+        for(const Document& document : search_server.FindTopDocuments<Ranker>(query, [](int, DocumentStatus status, int) { return status == DocumentStatus::ACTUAL; }))
+        {
+            total_relevance += document.relevance;
+        }
+    }
+    std::cerr << mark << " total relevance: "sv << total_relevance << std::endl;
+}
+
+void BenchmarkRankers()
+{
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 10000, 70);
+    const auto queries = GenerateQueries(generator, dictionary, 500, 7);
+
+    SearchServer search_server(dictionary[0]);
+    for(size_t i = 0; i < documents.size(); ++i)
+    {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    BenchmarkRanker<TfIdfRanker>("TF-IDF"sv, search_server, queries);
+    BenchmarkRanker<Bm25Ranker>("BM25"sv, search_server, queries);
+    BenchmarkRanker<Bm25FRanker>("BM25F"sv, search_server, queries);
+}
+
+void BenchmarkMinusWords()
+{
+    std::mt19937 generator;
+
+    // Маленький словарь, чтобы минус-слова встречались в большой доле документов
+    const auto dictionary = GenerateDictionary(generator, 300, 6);
+    const auto documents = GenerateQueries(generator, dictionary, 10000, 70);
+
+    std::vector<std::string> queries;
+    for(int i = 0; i < 500; ++i)
+    {
+        queries.push_back(GenerateQuery(generator, dictionary, 8, 0.5));
+    }
+
+    SearchServer search_server;
+    for(size_t i = 0; i < documents.size(); ++i)
+    {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    {
+        LOG_DURATION("Minus words seq"sv);
+        size_t document_count = 0;
+        for(const std::string& query : queries)
+        {
+            document_count += search_server.FindTopDocuments(std::execution::seq, query).size();
+        }
+        std::cerr << "Minus words seq found: "sv << document_count << std::endl;
+    }
+
+    {
+        LOG_DURATION("Minus words par"sv);
+        size_t document_count = 0;
+        for(const std::string& query : queries)
+        {
+            document_count += search_server.FindTopDocuments(std::execution::par, query).size();
+        }
+        std::cerr << "Minus words par found: "sv << document_count << std::endl;
+    }
+}
+
+void BenchmarkMatchDocuments()
+{
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 10000, 70);
+    const auto queries = GenerateQueries(generator, dictionary, 200, 7);
+
+    SearchServer search_server;
+    for(size_t i = 0; i < documents.size(); ++i)
+    {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    // Подсветка: каждый запрос матчится с сотней документов
+    std::vector<int> document_ids(100);
+    std::iota(document_ids.begin(), document_ids.end(), 0);
+
+    {
+        LOG_DURATION("MatchDocument per document"sv);
+        size_t word_count = 0;
+        for(const std::string& query : queries)
+        {
+            for(const int document_id : document_ids)
+            {
+                word_count += std::get<0>(search_server.MatchDocument(query, document_id)).size();
+            }
+        }
+        std::cerr << "MatchDocument per document words: "sv << word_count << std::endl;
+    }
+
+    {
+        LOG_DURATION("MatchDocuments seq"sv);
+        size_t word_count = 0;
+        for(const std::string& query : queries)
+        {
+            for(const auto& [words, status] : search_server.MatchDocuments(std::execution::seq, query, document_ids))
+            {
+                word_count += words.size();
+            }
+        }
+        std::cerr << "MatchDocuments seq words: "sv << word_count << std::endl;
+    }
+
+    {
+        LOG_DURATION("MatchDocuments par"sv);
+        size_t word_count = 0;
+        for(const std::string& query : queries)
+        {
+            for(const auto& [words, status] : search_server.MatchDocuments(std::execution::par, query, document_ids))
+            {
+                word_count += words.size();
+            }
+        }
+        std::cerr << "MatchDocuments par words: "sv << word_count << std::endl;
+    }
+}
+
+// Байты кучи, занятые программой. Без glibc замер недоступен и возвращается 0
+size_t GetAllocatedHeapBytes()
+{
+#ifdef HAS_MALLINFO2
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+// Резидентная память процесса. Вне Linux замер недоступен и возвращается 0
+size_t GetResidentBytes()
+{
+#ifdef HAS_PROC_STATM
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    std::ifstream statm("/proc/self/statm");
+    statm >> total_pages >> resident_pages;
+    return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+void BenchmarkIndexMemory()
+{
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 20000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20000, 100);
+
+    const size_t heap_before = GetAllocatedHeapBytes();
+    {
+        SearchServer search_server;
+        search_server.SetPositionalIndexEnabled(false);
+        for(size_t i = 0; i < documents.size(); ++i)
+        {
+            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+
+        const size_t heap_after = GetAllocatedHeapBytes();
+        const MemoryStats memory_stats = search_server.GetMemoryStats();
+        std::cerr << "Index memory for "sv << documents.size() << " documents: "sv
+                  << (heap_after - heap_before) / (1024.0 * 1024.0) << " MB, accounted "sv
+                  << memory_stats.GetTotalBytes() / (1024.0 * 1024.0) << " MB "sv << memory_stats << std::endl;
+    }
+}
+
+void BenchmarkIndexAllocators()
+{
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 20000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20000, 100);
+    const auto queries = GenerateQueries(generator, dictionary, 1000, 5);
+
+    const std::array<std::pair<IndexAllocator, std::string_view>, 3> allocators = {{
+        {IndexAllocator::DEFAULT, "heap"sv},
+        {IndexAllocator::SLAB, "slab"sv},
+        {IndexAllocator::SLAB_HUGE_PAGES, "slab + huge pages"sv},
+    }};
+
+    for(const auto& [allocator, name] : allocators)
+    {
+        const size_t resident_before = GetResidentBytes();
+        {
+            SearchServer search_server;
+            search_server.SetIndexAllocator(allocator);
+
+            const auto build_start = std::chrono::steady_clock::now();
+            for(size_t i = 0; i < documents.size(); ++i)
+            {
+                search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+            }
+            const std::chrono::duration<double, std::milli> build_duration = std::chrono::steady_clock::now() - build_start;
+            const size_t resident_after = GetResidentBytes();
+
+            size_t found_count = 0;
+            const auto query_start = std::chrono::steady_clock::now();
+            for(const std::string& query : queries)
+            {
+                found_count += search_server.FindTopDocuments(std::execution::seq, query).size();
+            }
+            const std::chrono::duration<double, std::micro> query_duration = std::chrono::steady_clock::now() - query_start;
+
+            std::cerr << "Index allocator "sv << name << ": ingestion "sv << build_duration.count() << " ms, query "sv
+                      << query_duration.count() / queries.size() << " us, RSS +"sv << (resident_after - resident_before) / (1024.0 * 1024.0)
+                      << " MB (found "sv << found_count << ")"sv << std::endl;
+        }
+
+#ifdef HAS_MALLINFO2
+        // Свободная память кучи возвращается системе, иначе следующий индекс переиспользует её и прирост RSS занижается
+        malloc_trim(0);
+#endif
+    }
+}
+
+void BenchmarkCorpusLoading()
+{
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 20000, 10);
+    const auto texts = GenerateQueries(generator, dictionary, 50000, 100);
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path();
+    const std::array<std::pair<CorpusFormat, std::filesystem::path>, 2> corpora = {{
+        {CorpusFormat::TSV, directory / "search_server_benchmark_corpus.tsv"},
+        {CorpusFormat::JSONL, directory / "search_server_benchmark_corpus.jsonl"},
+    }};
+    {
+        std::ofstream tsv(corpora[0].second, std::ios::binary);
+        std::ofstream jsonl(corpora[1].second, std::ios::binary);
+        for(size_t i = 0; i < texts.size(); ++i)
+        {
+            tsv << i << "\tACTUAL\t1,2,3\t"sv << texts[i] << '\n';
+            jsonl << "{\"id\": "sv << i << ", \"status\": \"ACTUAL\", \"ratings\": [1, 2, 3], \"text\": \""sv << texts[i] << "\"}\n"sv;
+        }
+    }
+
+    for(const auto& [format, path] : corpora)
+    {
+        const double megabytes = std::filesystem::file_size(path) / (1024.0 * 1024.0);
+        const std::string_view name = format == CorpusFormat::TSV ? "TSV"sv : "JSONL"sv;
+
+        // Только разбор, без построения индекса
+        {
+            const auto start = std::chrono::steady_clock::now();
+            const MappedFile file(path.string());
+            CorpusReader reader(file.GetData(), format);
+            size_t document_count = 0;
+            for(CorpusBatch batch; reader.ReadBatch(batch);)
+            {
+                document_count += batch.documents.size();
+            }
+            const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+            std::cerr << "Corpus parsing "sv << name << ": "sv << megabytes / duration.count() << " MB/s ("sv << document_count << " documents)"sv << std::endl;
+        }
+
+        {
+            SearchServer search_server;
+            search_server.SetPositionalIndexEnabled(false);
+            const auto start = std::chrono::steady_clock::now();
+            const size_t document_count = LoadCorpus(search_server, path.string(), format);
+            const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+            std::cerr << "Corpus loading "sv << name << ": "sv << megabytes / duration.count() << " MB/s ("sv << document_count << " documents)"sv << std::endl;
+        }
+
+        std::filesystem::remove(path);
+    }
+}
+
+void BenchmarkWriteAheadLog()
+{
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 20000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 5000, 100);
+    const std::string path = (std::filesystem::temp_directory_path() / "search_server_benchmark.wal").string();
+
+    const auto build = [&documents](WriteAheadLog* wal) {
+        SearchServer search_server;
+        search_server.SetPositionalIndexEnabled(false);
+        const auto start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < documents.size(); ++i)
+        {
+            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+            if(wal != nullptr)
+            {
+                wal->LogAddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+            }
+        }
+        if(wal != nullptr)
+        {
+            wal->Sync();
+        }
+        const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+        return documents.size() / duration.count();
+    };
+
+    std::cerr << "Ingestion without log: "sv << build(nullptr) << " documents/s"sv << std::endl;
+    for(const size_t group_size : {size_t{1}, size_t{64}, size_t{1024}})
+    {
+        std::filesystem::remove(path);
+        WriteAheadLog wal(path, {group_size, 16 * 1024 * 1024});
+        const double rate = build(&wal);
+        std::cerr << "Ingestion with log, fsync per "sv << group_size << " records: "sv << rate << " documents/s ("sv << wal.GetSyncCount() << " fsyncs)"sv << std::endl;
+    }
+
+    SearchServer search_server;
+    search_server.SetPositionalIndexEnabled(false);
+    const auto start = std::chrono::steady_clock::now();
+    const WalReplayStats stats = ReplayWriteAheadLog(path, search_server);
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    std::cerr << "Log replay: "sv << stats.applied_records / duration.count() << " records/s, "sv
+              << stats.valid_bytes / (1024.0 * 1024.0) / duration.count() << " MB/s"sv << std::endl;
+    std::filesystem::remove(path);
+}
+
+void BenchmarkParallelIndexBuild()
+{
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 50000, 10);
+    const auto texts = GenerateQueries(generator, dictionary, 50000, 70);
+    std::vector<DocumentRecord> documents;
+    documents.reserve(texts.size());
+    for(size_t i = 0; i < texts.size(); ++i)
+    {
+        documents.push_back({static_cast<int>(i), DocumentStatus::ACTUAL, {1, 2, 3}, texts[i]});
+    }
+
+    const auto measure = [](const auto& build) {
+        SearchServer search_server;
+        // Параллельное построение включается явно, чтобы замерить и машины, где калибровка его отключает
+        search_server.SetExecutionThresholds({search_server.GetExecutionThresholds().parallel_posting_count, 0});
+        const auto start = std::chrono::steady_clock::now();
+        build(search_server);
+        const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+        return duration.count();
+    };
+
+    std::cerr << "Index build of "sv << documents.size() << " documents, "sv << std::thread::hardware_concurrency() << " hardware threads"sv << std::endl;
+    std::cerr << "AddDocuments: "sv << measure([&documents](SearchServer& search_server) { search_server.AddDocuments(documents); }) << " s"sv << std::endl;
+    double single_partition_time = 0.0;
+    for(const size_t partition_count : {size_t{1}, size_t{2}, size_t{4}, size_t{8}, size_t{16}})
+    {
+        const double time = measure([&documents, partition_count](SearchServer& search_server) { search_server.BuildIndex(documents, partition_count); });
+        single_partition_time = partition_count == 1 ? time : single_partition_time;
+        std::cerr << "BuildIndex, "sv << partition_count << " partitions: "sv << time << " s, speed-up "sv << single_partition_time / time << std::endl;
+    }
+}
+
+void BenchmarkStopWordLookup()
+{
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 20000, 10);
+    std::vector<std::string_view> stop_words;
+    for(size_t i = 0; i < dictionary.size(); i += 50)
+    {
+        stop_words.push_back(dictionary[i]);
+    }
+    // Примерно треть слов текста — стоп-слова, как в обычном тексте
+    std::vector<std::string_view> words(1000000);
+    for(std::string_view& word : words)
+    {
+        word = std::uniform_int_distribution(0, 2)(generator) == 0 ? stop_words[std::uniform_int_distribution<size_t>(0, stop_words.size() - 1)(generator)]
+                                                                 : std::string_view(dictionary[std::uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)]);
+    }
+
+    const std::set<std::string, std::less<>> stop_word_tree(stop_words.begin(), stop_words.end());
+    const StopWordSet stop_word_set(stop_words);
+    for(int repeat = 0; repeat < 2; ++repeat)
+    {
+        size_t tree_matches = 0;
+        {
+            LOG_DURATION("Stop word lookup, std::set"sv);
+            for(const std::string_view word : words)
+            {
+                tree_matches += stop_word_tree.count(word);
+            }
+        }
+        size_t set_matches = 0;
+        {
+            LOG_DURATION("Stop word lookup, perfect hash"sv);
+            for(const std::string_view word : words)
+            {
+                set_matches += stop_word_set.Contains(word);
+            }
+        }
+        std::cerr << stop_words.size() << " stop words, "sv << words.size() << " lookups, matches "sv << tree_matches << " and "sv << set_matches << std::endl;
+    }
+}
+
+void BenchmarkDeepPagination()
+{
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20000, 70);
+    const auto queries = GenerateQueries(generator, dictionary, 20, 3);
+    const size_t page_size = 10;
+    const size_t page_count = 50;
+
+    SearchServer search_server;
+    for(size_t i = 0; i < documents.size(); ++i)
+    {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    // Без курсора каждая страница требует выполнить запрос и отобрать все документы до её конца
+    size_t naive_documents = 0;
+    {
+        LOG_DURATION("Deep pagination, query per page"sv);
+        for(const std::string& query : queries)
+        {
+            for(size_t page = 1; page <= page_count; ++page)
+            {
+                const auto ranked = search_server.FindRankedDocuments(query, DocumentFilter{DocumentStatus::ACTUAL}, page * page_size);
+                naive_documents += ranked.size() - std::min(ranked.size(), (page - 1) * page_size);
+            }
+        }
+    }
+
+    size_t cursor_documents = 0;
+    {
+        LOG_DURATION("Deep pagination, cursor"sv);
+        ResultCursors cursors(search_server);
+        for(const std::string& query : queries)
+        {
+            ResultPage page = cursors.Open(query, page_size);
+            cursor_documents += page.documents.size();
+            for(size_t i = 1; i < page_count && !page.next_cursor.empty(); ++i)
+            {
+                page = cursors.Next(page.next_cursor, page_size);
+                cursor_documents += page.documents.size();
+            }
+            cursors.Close(page.next_cursor);
+        }
+    }
+    std::cerr << "Deep pagination documents: "sv << naive_documents << " query per page, "sv << cursor_documents << " cursor"sv << std::endl;
+}
+
+RankingDivergence CompareRankings(const std::vector<Document>& exact, const std::vector<Document>& approximate)
+{
+    if(exact.empty())
+    {
+        return {approximate.empty() ? 1.0 : 0.0, approximate.empty() ? 1.0 : 0.0};
+    }
+
+    // Оценкой документа служит его точная релевантность, документы вне точного топа считаются нерелевантными
+    const auto find_exact_relevance = [&exact](int document_id) {
+        for(const Document& document : exact)
+        {
+            if(document.id == document_id)
+            {
+                return document.relevance;
+            }
+        }
+        return 0.0;
+    };
+
+    double overlap = 0.0;
+    double dcg = 0.0;
+    double ideal_dcg = 0.0;
+    for(size_t i = 0; i < exact.size(); ++i)
+    {
+        ideal_dcg += exact[i].relevance / std::log2(i + 2.0);
+    }
+    for(size_t i = 0; i < approximate.size(); ++i)
+    {
+        const double relevance = find_exact_relevance(approximate[i].id);
+        overlap += relevance > 0.0;
+        dcg += relevance / std::log2(i + 2.0);
+    }
+
+    return {overlap / exact.size(), ideal_dcg > 0.0 ? dcg / ideal_dcg : 1.0};
+}
+
+void EvaluateTermFreqPrecision()
+{
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 10000, 70);
+    const auto queries = GenerateQueries(generator, dictionary, 500, 7);
+
+    const auto fill_server = [&documents](SearchServer& search_server, TermFreqPrecision precision) {
+        search_server.SetPositionalIndexEnabled(false);
+        search_server.SetTermFreqPrecision(precision);
+        for(size_t i = 0; i < documents.size(); ++i)
+        {
+            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {static_cast<int>(i % 7)});
+        }
+    };
+
+    size_t heap_before = GetAllocatedHeapBytes();
+    SearchServer exact_server;
+    fill_server(exact_server, TermFreqPrecision::EXACT);
+    std::cerr << "TF exact: index "sv << (GetAllocatedHeapBytes() - heap_before) / (1024.0 * 1024.0) << " MB"sv << std::endl;
+
+    for(const auto& [precision, mark] : {std::pair{TermFreqPrecision::FLOAT16, "float16"sv}, std::pair{TermFreqPrecision::UINT8, "uint8"sv}})
+    {
+        heap_before = GetAllocatedHeapBytes();
+        SearchServer search_server;
+        fill_server(search_server, precision);
+        const double index_megabytes = (GetAllocatedHeapBytes() - heap_before) / (1024.0 * 1024.0);
+
+        double overlap = 0.0;
+        double ndcg = 0.0;
+        for(const std::string& query : queries)
+        {
+            const RankingDivergence divergence = CompareRankings(exact_server.FindTopDocuments(query, DocumentFilter{}),
+                                                                 search_server.FindTopDocuments(query, DocumentFilter{}));
+            overlap += divergence.top_overlap;
+            ndcg += divergence.ndcg;
+        }
+
+        std::cerr << "TF "sv << mark << ": index "sv << index_megabytes << " MB, top-"sv << MAX_RESULT_DOCUMENT_COUNT
+                  << " overlap "sv << overlap / queries.size() << ", NDCG "sv << ndcg / queries.size() << std::endl;
+    }
+}
+
+void BenchmarkScoreKernel()
+{
+    std::mt19937 generator;
+
+    const int posting_count = 1 << 20;
+    const int repeat_count = 20;
+    std::vector<int> document_ids(posting_count);
+    std::vector<double> term_freqs(posting_count);
+    std::vector<uint16_t> half_term_freqs(posting_count);
+    for(int i = 0; i < posting_count; ++i)
+    {
+        document_ids[i] = i * 3;
+        term_freqs[i] = std::uniform_real_distribution(0.001, 1.0)(generator);
+        half_term_freqs[i] = EncodeFloat16(term_freqs[i]);
+    }
+
+    std::array<double, SCORE_KERNEL_CHUNK_SIZE> contributions;
+    for(int level = static_cast<int>(SimdLevel::SCALAR); level <= static_cast<int>(DetectSimdLevel()); ++level)
+    {
+        for(const bool is_half : {false, true})
+        {
+            ScoreBuffer scores(document_ids.back());
+
+            const auto start = std::chrono::steady_clock::now();
+            for(int repeat = 0; repeat < repeat_count; ++repeat)
+            {
+                for(size_t first = 0; first < document_ids.size(); first += SCORE_KERNEL_CHUNK_SIZE)
+                {
+                    if(is_half)
+                    {
+                        ScaleTermFreqs(static_cast<SimdLevel>(level), half_term_freqs.data() + first, SCORE_KERNEL_CHUNK_SIZE, 0.5, contributions.data());
+                    }
+                    else
+                    {
+                        ScaleTermFreqs(static_cast<SimdLevel>(level), term_freqs.data() + first, SCORE_KERNEL_CHUNK_SIZE, 0.5, contributions.data());
+                    }
+                    scores.Add(document_ids.data() + first, contributions.data(), SCORE_KERNEL_CHUNK_SIZE);
+                }
+            }
+            const std::chrono::duration<double, std::nano> duration = std::chrono::steady_clock::now() - start;
+
+            double checksum = 0.0;
+            scores.ForEach([&checksum](int, double score) {
+                checksum += score;
+            });
+
+            std::cerr << "Score kernel "sv << GetSimdLevelName(static_cast<SimdLevel>(level)) << (is_half ? ", float16 TF: "sv : ", double TF: "sv)
+                      << static_cast<double>(posting_count) * repeat_count / duration.count() << " postings/ns (checksum "sv << checksum << ")"sv << std::endl;
+        }
+    }
+}
+
+void BenchmarkTokenizer()
+{
+    std::mt19937 generator;
+
+    const std::vector<std::string> words = {"Кот"s, "пушистый"s, "ёж,"s, "«Модный»"s, "ошейник."s, "Cat"s, "city!"s, "и"s, "—"s, "tail\t"s};
+    std::string text;
+    while(text.size() < 64 * 1024 * 1024)
+    {
+        text += words[std::uniform_int_distribution<int>(0, words.size() - 1)(generator)];
+        text.push_back(' ');
+    }
+
+    for(const bool stemming_enabled : {false, true})
+    {
+        const Tokenizer tokenizer(stemming_enabled);
+        std::string buffer;
+
+        const auto start = std::chrono::steady_clock::now();
+        size_t word_count = 0;
+        for(std::string_view word : tokenizer.Tokenize(text, buffer))
+        {
+            word_count += !tokenizer.Stem(word).empty();
+        }
+        const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+        std::cerr << "Tokenizer"sv << (stemming_enabled ? " with stemming: "sv : ": "sv)
+                  << text.size() / duration.count() / (1024 * 1024) << " MB/s, "sv << word_count << " words"sv << std::endl;
+    }
+}
+
+void BenchmarkSearchServer()
+{
+    BenchmarkRankers();
+    BenchmarkMinusWords();
+    BenchmarkMatchDocuments();
+    BenchmarkIndexMemory();
+    BenchmarkIndexAllocators();
+    BenchmarkCorpusLoading();
+    BenchmarkWriteAheadLog();
+    BenchmarkParallelIndexBuild();
+    BenchmarkStopWordLookup();
+    BenchmarkDeepPagination();
+    EvaluateTermFreqPrecision();
+    BenchmarkScoreKernel();
+    BenchmarkTokenizer();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "search_server.h"
+
+std::string GenerateWord(std::mt19937& generator, int max_length);
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length);
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, int word_count, double minus_prob = 0);
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary, int query_count, int max_word_count);
+
+// Расхождение приближённого топа с точным: доля общих документов и NDCG с точной релевантностью в качестве оценки
+struct RankingDivergence
+{
+    double top_overlap;
+    double ndcg;
+};
+
+RankingDivergence CompareRankings(const std::vector<Document>& exact, const std::vector<Document>& approximate);
+
+void BenchmarkRankers();
+void BenchmarkMinusWords();
+void BenchmarkMatchDocuments();
+void BenchmarkIndexMemory();
+// Время построения индекса, средняя задержка запроса и прирост резидентной памяти для каждого аллокатора индекса
+void BenchmarkIndexAllocators();
+// Скорость чтения корпуса из файла в МБ/с: только разбор и разбор с построением индекса
+void BenchmarkCorpusLoading();
+// Скорость добавления документов без журнала и с журналом при разном размере группы fsync, скорость восстановления
+void BenchmarkWriteAheadLog();
+// Время построения индекса: AddDocuments и BuildIndex с разным числом частей, ускорение относительно одной части
+void BenchmarkParallelIndexBuild();
+// Проверка слов по множеству стоп-слов: std::set против фильтра Блума с минимальной совершенной хеш-функцией
+void BenchmarkStopWordLookup();
+// Время получения глубокой страницы: выполнение запроса для каждой страницы против курсора
+void BenchmarkDeepPagination();
+// Сравнивает память индекса и качество ранжирования при TF пониженной точности с точным TF
+void EvaluateTermFreqPrecision();
+// Пропускная способность ядра накопления релевантности для каждого доступного набора инструкций
+void BenchmarkScoreKernel();
+void BenchmarkTokenizer();
+
+// Функция BenchmarkSearchServer является точкой входа для запуска замеров производительности
+void BenchmarkSearchServer();
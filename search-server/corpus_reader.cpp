@@ -0,0 +1,527 @@
+#include "corpus_reader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <execution>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HAS_MMAP
+#endif
+
+using namespace std::literals;
+
+namespace
+{
+    struct CorpusPart
+    {
+        size_t begin;
+        size_t end;
+        std::vector<DocumentRecord> documents;
+        std::deque<std::string> unescaped_texts;
+    };
+
+    [[noreturn]] void ThrowMalformedRecord(std::string_view reason, size_t offset)
+    {
+        throw std::invalid_argument("Некорректная запись корпуса на смещении "s + std::to_string(offset) + ": "s + std::string(reason));
+    }
+
+    // Позиция после ближайшего перевода строки, начиная с position, или конец данных
+    size_t FindLineEnd(std::string_view data, size_t position)
+    {
+        const size_t line_end = data.find('\n', position);
+        return line_end == std::string_view::npos ? data.size() : line_end + 1;
+    }
+
+    bool IsJsonSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    int ParseInt(std::string_view text, size_t offset)
+    {
+        int value = 0;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if(error != std::errc() || end != text.data() + text.size() || text.empty())
+        {
+            ThrowMalformedRecord("ожидалось целое число, получено \""s + std::string(text) + "\""s, offset);
+        }
+
+        return value;
+    }
+
+    DocumentStatus ParseStatus(std::string_view name, size_t offset)
+    {
+        const std::optional<DocumentStatus> status = ParseDocumentStatus(name);
+        if(!status)
+        {
+            ThrowMalformedRecord("неизвестный статус \""s + std::string(name) + "\""s, offset);
+        }
+
+        return *status;
+    }
+
+    DocumentRecord ParseTsvRecord(std::string_view line, size_t offset)
+    {
+        std::string_view fields[3];
+        for(std::string_view& field : fields)
+        {
+            const size_t tab = line.find('\t');
+            if(tab == std::string_view::npos)
+            {
+                ThrowMalformedRecord("ожидалось четыре поля через табуляцию"sv, offset);
+            }
+            field = line.substr(0, tab);
+            line.remove_prefix(tab + 1);
+        }
+
+        DocumentRecord record;
+        record.id = ParseInt(fields[0], offset);
+        record.status = ParseStatus(fields[1], offset);
+        for(std::string_view ratings = fields[2]; !ratings.empty();)
+        {
+            const size_t separator = std::min(ratings.find(','), ratings.find(' '));
+            if(separator != 0)
+            {
+                record.ratings.push_back(ParseInt(ratings.substr(0, separator), offset));
+            }
+            ratings.remove_prefix(separator == std::string_view::npos ? ratings.size() : separator + 1);
+        }
+        record.text = line;
+
+        return record;
+    }
+
+    // Разбор одной строки JSONL. Строки без escape-последовательностей возвращаются как view в строку корпуса
+    class JsonRecordParser
+    {
+        public:
+            JsonRecordParser(std::string_view line, size_t offset, std::deque<std::string>& unescaped_texts)
+                : line_(line), offset_(offset), unescaped_texts_(unescaped_texts)
+            {
+            }
+
+            DocumentRecord Parse()
+            {
+                DocumentRecord record;
+                bool has_id = false;
+                bool has_text = false;
+
+                Expect('{');
+                for(bool first = true; !TrySkip('}'); first = false)
+                {
+                    if(!first)
+                    {
+                        Expect(',');
+                    }
+                    const std::string_view key = ParseString();
+                    Expect(':');
+
+                    if(key == "id"sv)
+                    {
+                        record.id = ParseNumber();
+                        has_id = true;
+                    }
+                    else if(key == "status"sv)
+                    {
+                        record.status = ParseStatus(ParseString(), offset_);
+                    }
+                    else if(key == "ratings"sv)
+                    {
+                        Expect('[');
+                        for(bool first_rating = true; !TrySkip(']'); first_rating = false)
+                        {
+                            if(!first_rating)
+                            {
+                                Expect(',');
+                            }
+                            record.ratings.push_back(ParseNumber());
+                        }
+                    }
+                    else if(key == "text"sv)
+                    {
+                        record.text = ParseString();
+                        has_text = true;
+                    }
+                    else
+                    {
+                        SkipValue();
+                    }
+                }
+
+                SkipSpaces();
+                if(position_ != line_.size())
+                {
+                    ThrowMalformedRecord("лишние символы после объекта"sv, offset_);
+                }
+                if(!has_id || !has_text)
+                {
+                    ThrowMalformedRecord("у записи нет поля id или text"sv, offset_);
+                }
+
+                return record;
+            }
+
+        private:
+            std::string_view line_;
+            size_t offset_;
+            std::deque<std::string>& unescaped_texts_;
+            size_t position_ = 0;
+
+            void SkipSpaces()
+            {
+                while(position_ < line_.size() && IsJsonSpace(line_[position_]))
+                {
+                    ++position_;
+                }
+            }
+
+            bool TrySkip(char c)
+            {
+                SkipSpaces();
+                if(position_ < line_.size() && line_[position_] == c)
+                {
+                    ++position_;
+                    return true;
+                }
+
+                return false;
+            }
+
+            void Expect(char c)
+            {
+                if(!TrySkip(c))
+                {
+                    ThrowMalformedRecord("ожидался символ '"s + c + "'"s, offset_);
+                }
+            }
+
+            int ParseNumber()
+            {
+                SkipSpaces();
+                const size_t begin = position_;
+                while(position_ < line_.size() && (line_[position_] == '-' || (line_[position_] >= '0' && line_[position_] <= '9')))
+                {
+                    ++position_;
+                }
+
+                return ParseInt(line_.substr(begin, position_ - begin), offset_);
+            }
+
+            // Позиция закрывающей кавычки строки, начинающейся после position_, и признак escape-последовательностей
+            std::pair<size_t, bool> FindStringEnd() const
+            {
+                bool has_escapes = false;
+                for(size_t i = position_; i < line_.size(); ++i)
+                {
+                    if(line_[i] == '\\')
+                    {
+                        has_escapes = true;
+                        ++i;
+                    }
+                    else if(line_[i] == '"')
+                    {
+                        return {i, has_escapes};
+                    }
+                }
+
+                ThrowMalformedRecord("незакрытая строка"sv, offset_);
+            }
+
+            std::string_view ParseString()
+            {
+                Expect('"');
+                const auto [end, has_escapes] = FindStringEnd();
+                const std::string_view raw = line_.substr(position_, end - position_);
+                position_ = end + 1;
+
+                if(!has_escapes)
+                {
+                    return raw;
+                }
+
+                return unescaped_texts_.emplace_back(Unescape(raw));
+            }
+
+            std::string Unescape(std::string_view raw) const
+            {
+                std::string text;
+                text.reserve(raw.size());
+                for(size_t i = 0; i < raw.size(); ++i)
+                {
+                    if(raw[i] != '\\')
+                    {
+                        text.push_back(raw[i]);
+                        continue;
+                    }
+
+                    switch(raw[++i])
+                    {
+                        case 'b': text.push_back('\b'); break;
+                        case 'f': text.push_back('\f'); break;
+                        case 'n': text.push_back('\n'); break;
+                        case 'r': text.push_back('\r'); break;
+                        case 't': text.push_back('\t'); break;
+                        case 'u':
+                        {
+                            uint32_t code_point = ParseHex(raw, i + 1);
+                            i += 4;
+                            // Символ вне BMP записывается суррогатной парой
+                            if(code_point >= 0xD800 && code_point < 0xDC00 && raw.substr(i + 1, 2) == "\\u"sv)
+                            {
+                                const uint32_t low = ParseHex(raw, i + 3);
+                                if(low >= 0xDC00 && low < 0xE000)
+                                {
+                                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                                    i += 6;
+                                }
+                            }
+                            AppendUtf8(code_point, text);
+                            break;
+                        }
+                        default:
+                            text.push_back(raw[i]);
+                    }
+                }
+
+                return text;
+            }
+
+            uint32_t ParseHex(std::string_view raw, size_t position) const
+            {
+                uint32_t value = 0;
+                const std::string_view digits = raw.substr(position, 4);
+                const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), value, 16);
+                if(digits.size() != 4 || error != std::errc() || end != digits.data() + digits.size())
+                {
+                    ThrowMalformedRecord("некорректная последовательность \\u"sv, offset_);
+                }
+
+                return value;
+            }
+
+            static void AppendUtf8(uint32_t code_point, std::string& text)
+            {
+                if(code_point < 0x80)
+                {
+                    text.push_back(static_cast<char>(code_point));
+                }
+                else if(code_point < 0x800)
+                {
+                    text.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+                    text.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+                }
+                else if(code_point < 0x10000)
+                {
+                    text.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+                    text.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+                    text.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+                }
+                else
+                {
+                    text.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+                    text.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+                    text.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+                    text.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+                }
+            }
+
+            // Значение неизвестного ключа: строка, вложенный объект или массив, число или литерал
+            void SkipValue()
+            {
+                SkipSpaces();
+                int depth = 0;
+                while(position_ < line_.size())
+                {
+                    const char c = line_[position_];
+                    if(c == '"')
+                    {
+                        ++position_;
+                        position_ = FindStringEnd().first + 1;
+                        if(depth == 0)
+                        {
+                            return;
+                        }
+                        continue;
+                    }
+                    if(c == '{' || c == '[')
+                    {
+                        ++depth;
+                    }
+                    else if(c == '}' || c == ']' || (c == ',' && depth == 0))
+                    {
+                        if(depth == 0)
+                        {
+                            return;
+                        }
+                        if(--depth == 0)
+                        {
+                            ++position_;
+                            return;
+                        }
+                    }
+                    ++position_;
+                }
+            }
+    };
+
+    void ParseCorpusPart(std::string_view data, CorpusFormat format, CorpusPart& part)
+    {
+        for(size_t line_begin = part.begin; line_begin < part.end;)
+        {
+            const size_t line_end = FindLineEnd(data, line_begin);
+            std::string_view line = data.substr(line_begin, std::min(line_end, part.end) - line_begin);
+            while(!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+            {
+                line.remove_suffix(1);
+            }
+
+            if(format == CorpusFormat::TSV)
+            {
+                if(!line.empty())
+                {
+                    part.documents.push_back(ParseTsvRecord(line, line_begin));
+                }
+            }
+            else if(std::any_of(line.begin(), line.end(), [](char c) { return !IsJsonSpace(c); }))
+            {
+                part.documents.push_back(JsonRecordParser(line, line_begin, part.unescaped_texts).Parse());
+            }
+
+            line_begin = line_end;
+        }
+    }
+}
+
+MappedFile::MappedFile(const std::string& path)
+{
+#ifdef HAS_MMAP
+    const int descriptor = open(path.c_str(), O_RDONLY);
+    struct stat file_stat;
+    if(descriptor < 0 || fstat(descriptor, &file_stat) != 0)
+    {
+        if(descriptor >= 0)
+        {
+            close(descriptor);
+        }
+        throw std::runtime_error("Не удалось открыть файл "s + path);
+    }
+
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if(size_ > 0)
+    {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if(data == MAP_FAILED)
+        {
+            close(descriptor);
+            throw std::runtime_error("Не удалось отобразить в память файл "s + path);
+        }
+        // Корпус читается один раз от начала к концу, ядру выгодно читать вперёд
+        madvise(data, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(data);
+    }
+    close(descriptor);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if(!file)
+    {
+        throw std::runtime_error("Не удалось открыть файл "s + path);
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef HAS_MMAP
+    if(data_ != nullptr)
+    {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+std::string_view MappedFile::GetData() const
+{
+    return {data_, size_};
+}
+
+CorpusReader::CorpusReader(std::string_view data, CorpusFormat format, size_t batch_size)
+    : data_(data), format_(format), batch_size_(std::max<size_t>(batch_size, 1))
+{
+}
+
+bool CorpusReader::ReadBatch(CorpusBatch& batch)
+{
+    batch.documents.clear();
+    batch.unescaped_texts.clear();
+    if(position_ >= data_.size())
+    {
+        return false;
+    }
+
+    const size_t batch_end = position_ + batch_size_ >= data_.size() ? data_.size() : FindLineEnd(data_, position_ + batch_size_ - 1);
+    const size_t part_size = std::max<size_t>((batch_end - position_) / CORPUS_BATCH_PART_COUNT, 1);
+
+    std::vector<CorpusPart> parts;
+    for(size_t part_begin = position_; part_begin < batch_end;)
+    {
+        const size_t part_end = std::min(batch_end, FindLineEnd(data_, part_begin + part_size - 1));
+        parts.push_back({part_begin, part_end, {}, {}});
+        part_begin = part_end;
+    }
+
+    const auto parse = [this](CorpusPart& part) {
+        ParseCorpusPart(data_, format_, part);
+    };
+    if(parts.size() > 1)
+    {
+        std::for_each(std::execution::par, parts.begin(), parts.end(), parse);
+    }
+    else
+    {
+        std::for_each(parts.begin(), parts.end(), parse);
+    }
+
+    for(CorpusPart& part : parts)
+    {
+        std::move(part.documents.begin(), part.documents.end(), std::back_inserter(batch.documents));
+        if(!part.unescaped_texts.empty())
+        {
+            batch.unescaped_texts.push_back(std::move(part.unescaped_texts));
+        }
+    }
+
+    position_ = batch_end;
+    return true;
+}
+
+size_t CorpusReader::GetBytesRead() const
+{
+    return position_;
+}
+
+size_t LoadCorpus(SearchServer& search_server, const std::string& path, CorpusFormat format)
+{
+    const MappedFile file(path);
+    CorpusReader reader(file.GetData(), format);
+
+    size_t document_count = 0;
+    CorpusBatch batch;
+    while(reader.ReadBatch(batch))
+    {
+        search_server.AddDocuments(batch.documents);
+        document_count += batch.documents.size();
+    }
+
+    return document_count;
+}
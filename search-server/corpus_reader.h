@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "document.h"
+#include "search_server.h"
+
+// Файл корпуса читается пакетами по CORPUS_BATCH_SIZE байт, пакет разбирается параллельно
+// в CORPUS_BATCH_PART_COUNT частях. Границы пакетов и частей сдвигаются к концу строки
+const size_t CORPUS_BATCH_SIZE = 16 * 1024 * 1024;
+const size_t CORPUS_BATCH_PART_COUNT = 16;
+
+// Форматы корпуса, по записи на строку:
+// TSV — id, статус, рейтинги через запятую или пробел и текст, разделённые табуляцией;
+// JSONL — объект {"id": 1, "status": "ACTUAL", "ratings": [1, 2], "text": "..."},
+// status и ratings необязательны, прочие ключи пропускаются.
+// Статус задаётся именем: ACTUAL, IRRELEVANT, BANNED или REMOVED. Пустые строки пропускаются
+enum class CorpusFormat
+{
+    TSV,
+    JSONL,
+};
+
+// Файл, отображённый в память только для чтения. Вне Linux файл читается в буфер целиком
+class MappedFile
+{
+    public:
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        std::string_view GetData() const;
+
+    private:
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+        std::string buffer_;
+};
+
+// Записи пакета. Тексты без экранирования указывают прямо в данные корпуса,
+// тексты JSONL с escape-последовательностями раскодируются в unescaped_texts
+struct CorpusBatch
+{
+    std::vector<DocumentRecord> documents;
+    std::vector<std::deque<std::string>> unescaped_texts;
+};
+
+// Потоковый разбор корпуса без копирования строк. Данные должны жить, пока используются записи пакетов.
+// Некорректная запись приводит к исключению invalid_argument со смещением строки в данных
+class CorpusReader
+{
+    public:
+        CorpusReader(std::string_view data, CorpusFormat format, size_t batch_size = CORPUS_BATCH_SIZE);
+
+        // Разбирает следующий пакет. Возвращает false, когда данные закончились
+        bool ReadBatch(CorpusBatch& batch);
+
+        size_t GetBytesRead() const;
+
+    private:
+        std::string_view data_;
+        CorpusFormat format_;
+        size_t batch_size_;
+        size_t position_ = 0;
+};
+
+// Загружает корпус из файла пакетами через SearchServer::AddDocuments. Возвращает число документов
+size_t LoadCorpus(SearchServer& search_server, const std::string& path, CorpusFormat format);
@@ -2,6 +2,34 @@
 
 using namespace std::literals;
 
+std::string_view GetDocumentStatusName(DocumentStatus status)
+{
+    switch(status)
+    {
+        case DocumentStatus::ACTUAL:
+            return "ACTUAL"sv;
+        case DocumentStatus::IRRELEVANT:
+            return "IRRELEVANT"sv;
+        case DocumentStatus::BANNED:
+            return "BANNED"sv;
+        default:
+            return "REMOVED"sv;
+    }
+}
+
+std::optional<DocumentStatus> ParseDocumentStatus(std::string_view name)
+{
+    for(const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED, DocumentStatus::REMOVED})
+    {
+        if(name == GetDocumentStatusName(status))
+        {
+            return status;
+        }
+    }
+
+    return std::nullopt;
+}
+
 Document::Document(int id_, double relevance_, int rating_) : id(id_), relevance(relevance_), rating(rating_)
 {
 }
@@ -15,3 +43,14 @@ std::ostream& operator<<(std::ostream& out, const Document& document)
     return out;
 }
 
+DocumentFilter::DocumentFilter(std::optional<DocumentStatus> status_, std::optional<int> min_rating_, std::optional<int> max_rating_)
+    : status(status_), min_rating(min_rating_), max_rating(max_rating_)
+{
+}
+
+bool DocumentFilter::operator()(int, DocumentStatus document_status, int rating) const
+{
+    return (!status || *status == document_status)
+        && (!min_rating || rating >= *min_rating)
+        && (!max_rating || rating <= *max_rating);
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <iostream>
+#include <optional>
+#include <string_view>
+#include <vector>
 
 enum class DocumentStatus
 {
@@ -10,6 +13,10 @@ enum class DocumentStatus
     REMOVED,
 };
 
+// Имя статуса совпадает с именем элемента перечисления: ACTUAL, IRRELEVANT, BANNED, REMOVED
+std::string_view GetDocumentStatusName(DocumentStatus status);
+std::optional<DocumentStatus> ParseDocumentStatus(std::string_view name);
+
 struct Document 
 {
     Document() = default;
@@ -22,3 +29,35 @@ struct Document
 };
 
 std::ostream& operator<<(std::ostream& out, const Document& document);
+
+// Результат поиска со сроком. is_complete равен false, если поиск остановлен по сроку или отмене
+// и документы ранжированы по части постингов
+struct SearchResult
+{
+    std::vector<Document> documents;
+    bool is_complete = true;
+};
+
+// Документ для пакетного добавления. Текст не копируется и должен жить до конца AddDocuments
+struct DocumentRecord
+{
+    int id = 0;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+    std::string_view text;
+};
+
+// Декларативный фильтр документов. FindTopDocuments распознаёт его и отбирает документы
+// по индексам статусов и рейтингов до подсчёта релевантности. Пустое поле не ограничивает выборку
+struct DocumentFilter
+{
+    DocumentFilter() = default;
+
+    DocumentFilter(std::optional<DocumentStatus> status_, std::optional<int> min_rating_ = std::nullopt, std::optional<int> max_rating_ = std::nullopt);
+
+    std::optional<DocumentStatus> status;
+    std::optional<int> min_rating;
+    std::optional<int> max_rating;
+
+    bool operator()(int document_id, DocumentStatus document_status, int rating) const;
+};
@@ -0,0 +1,117 @@
+#include "execution_thresholds.h"
+#include "forward_index.h"
+#include "score_kernel.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <execution>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const int CALIBRATION_REPEAT_COUNT = 16;
+    const size_t CALIBRATION_POSTING_COUNT = 16384;
+    const size_t CALIBRATION_DOCUMENT_COUNT = 1024;
+    const size_t MIN_PARALLEL_POSTING_COUNT = 4096;
+    const size_t MIN_PARALLEL_DOCUMENT_COUNT = 16;
+
+    // Лучшее время из нескольких запусков: калибровка не должна зависеть от случайных задержек
+    template <typename Function>
+    double MeasureBestNanoseconds(Function function)
+    {
+        double best = HUGE_VAL;
+        for(int repeat = 0; repeat < CALIBRATION_REPEAT_COUNT; ++repeat)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            const std::chrono::duration<double, std::nano> duration = std::chrono::steady_clock::now() - start;
+            best = std::min(best, duration.count());
+        }
+
+        return best;
+    }
+
+    double MeasureParallelOverhead(unsigned thread_count)
+    {
+        std::vector<uint64_t> parts(thread_count);
+        return MeasureBestNanoseconds([&parts]() {
+            std::for_each(std::execution::par, parts.begin(), parts.end(), [](uint64_t& part) {
+                ++part;
+            });
+        });
+    }
+
+    // Стоимость постинга: векторное ядро и прибавление к буферу релевантности, как при поиске
+    double MeasurePostingCost()
+    {
+        std::vector<int> document_ids(CALIBRATION_POSTING_COUNT);
+        std::vector<double> term_freqs(CALIBRATION_POSTING_COUNT, 0.25);
+        for(size_t i = 0; i < document_ids.size(); ++i)
+        {
+            document_ids[i] = static_cast<int>(i * 4);
+        }
+
+        std::array<double, SCORE_KERNEL_CHUNK_SIZE> contributions;
+        const double duration = MeasureBestNanoseconds([&]() {
+            ScoreBuffer scores(document_ids.back());
+            for(size_t first = 0; first < document_ids.size(); first += SCORE_KERNEL_CHUNK_SIZE)
+            {
+                ScaleTermFreqs(DetectSimdLevel(), term_freqs.data() + first, SCORE_KERNEL_CHUNK_SIZE, 0.5, contributions.data());
+                scores.Add(document_ids.data() + first, contributions.data(), SCORE_KERNEL_CHUNK_SIZE);
+            }
+        });
+
+        return duration / CALIBRATION_POSTING_COUNT;
+    }
+
+    // Стоимость матчинга документа: пересечение слов запроса с прямым индексом документа
+    double MeasureDocumentCost()
+    {
+        std::vector<uint32_t> document_term_ids(64);
+        std::iota(document_term_ids.begin(), document_term_ids.end(), 0);
+        const TermCounts terms = MakeTermCounts(document_term_ids);
+        const std::vector<uint32_t> query_term_ids = {3, 17, 40, 90};
+
+        size_t matched_count = 0;
+        const double duration = MeasureBestNanoseconds([&]() {
+            for(size_t i = 0; i < CALIBRATION_DOCUMENT_COUNT; ++i)
+            {
+                matched_count += IntersectTerms(query_term_ids, terms).size();
+            }
+        });
+
+        return matched_count == 0 ? duration : duration / CALIBRATION_DOCUMENT_COUNT;
+    }
+
+    size_t ComputeBreakEven(double overhead, double item_cost, size_t min_count)
+    {
+        // На P потоках экономия равна work * (1 - 1 / P) >= work / 2, поэтому запуск окупается при work >= 2 * overhead
+        const double break_even = 2.0 * overhead / std::max(item_cost, 1e-3);
+        return std::max(min_count, static_cast<size_t>(std::min(break_even, static_cast<double>(SIZE_MAX / 2))));
+    }
+}
+
+ExecutionThresholds CalibrateExecutionThresholds()
+{
+    const unsigned thread_count = std::thread::hardware_concurrency();
+    if(thread_count <= 1)
+    {
+        return {SIZE_MAX, SIZE_MAX};
+    }
+
+    const double overhead = MeasureParallelOverhead(thread_count);
+
+    return {ComputeBreakEven(overhead, MeasurePostingCost(), MIN_PARALLEL_POSTING_COUNT),
+            ComputeBreakEven(overhead, MeasureDocumentCost(), MIN_PARALLEL_DOCUMENT_COUNT)};
+}
+
+const ExecutionThresholds& GetCalibratedExecutionThresholds()
+{
+    static const ExecutionThresholds thresholds = CalibrateExecutionThresholds();
+    return thresholds;
+}
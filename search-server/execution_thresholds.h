@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+enum class ExecutionStrategy
+{
+    SEQUENTIAL,
+    PARALLEL,
+};
+
+// Объём работы, с которого параллельное выполнение окупает запуск потоков:
+// число обходимых постингов для поиска и удаления документа, число документов для пакетного матчинга
+struct ExecutionThresholds
+{
+    size_t parallel_posting_count;
+    size_t parallel_document_count;
+};
+
+// Пороги калибруются микробенчмарком при первом вызове, обычно при создании первого SearchServer.
+// На одном ядре параллельное выполнение не выбирается никогда
+const ExecutionThresholds& GetCalibratedExecutionThresholds();
+ExecutionThresholds CalibrateExecutionThresholds();
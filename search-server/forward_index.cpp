@@ -0,0 +1,137 @@
+#include "forward_index.h"
+#include "intersection.h"
+
+#include <algorithm>
+
+namespace
+{
+    bool IsLessTermId(const TermCount& term, uint32_t term_id)
+    {
+        return term.term_id < term_id;
+    }
+}
+
+TermCounts MakeTermCounts(std::vector<uint32_t> term_ids, std::pmr::memory_resource* resource)
+{
+    std::sort(term_ids.begin(), term_ids.end());
+
+    size_t unique_count = 0;
+    for(size_t i = 0; i < term_ids.size(); ++i)
+    {
+        unique_count += i == 0 || term_ids[i] != term_ids[i - 1];
+    }
+
+    TermCounts terms(resource);
+    terms.reserve(unique_count);
+    for(const uint32_t term_id : term_ids)
+    {
+        if(!terms.empty() && terms.back().term_id == term_id)
+        {
+            ++terms.back().count;
+        }
+        else
+        {
+            terms.push_back({term_id, 1});
+        }
+    }
+
+    return terms;
+}
+
+bool ContainsTerm(const TermCounts& terms, uint32_t term_id)
+{
+    const auto it = std::lower_bound(terms.begin(), terms.end(), term_id, IsLessTermId);
+    return it != terms.end() && it->term_id == term_id;
+}
+
+std::vector<uint32_t> IntersectTerms(const std::vector<uint32_t>& term_ids, const TermCounts& terms)
+{
+    std::vector<uint32_t> result;
+
+    if(terms.size() > term_ids.size() * GALLOPING_RATIO)
+    {
+        std::copy_if(term_ids.begin(), term_ids.end(), std::back_inserter(result), [&terms](uint32_t term_id) {
+            return ContainsTerm(terms, term_id);
+        });
+        return result;
+    }
+
+    auto term_it = terms.begin();
+    for(auto id_it = term_ids.begin(); id_it != term_ids.end() && term_it != terms.end();)
+    {
+        if(*id_it < term_it->term_id)
+        {
+            ++id_it;
+        }
+        else if(term_it->term_id < *id_it)
+        {
+            ++term_it;
+        }
+        else
+        {
+            result.push_back(*id_it);
+            ++id_it;
+            ++term_it;
+        }
+    }
+
+    return result;
+}
+
+WordFrequencies::Iterator::Iterator(const TermCount* position, const TermWords* term_words, double inv_length)
+    : position_(position), term_words_(term_words), inv_length_(inv_length)
+{
+}
+
+WordFrequencies::Iterator::value_type WordFrequencies::Iterator::operator*() const
+{
+    return {(*term_words_)[position_->term_id], position_->count * inv_length_};
+}
+
+WordFrequencies::Iterator& WordFrequencies::Iterator::operator++()
+{
+    ++position_;
+    return *this;
+}
+
+WordFrequencies::Iterator WordFrequencies::Iterator::operator++(int)
+{
+    Iterator previous = *this;
+    ++position_;
+    return previous;
+}
+
+bool WordFrequencies::Iterator::operator==(const Iterator& other) const
+{
+    return position_ == other.position_;
+}
+
+bool WordFrequencies::Iterator::operator!=(const Iterator& other) const
+{
+    return position_ != other.position_;
+}
+
+WordFrequencies::WordFrequencies(const TermCounts& terms, const TermWords& term_words, uint32_t document_length)
+    : begin_(terms.data()), end_(terms.data() + terms.size()), term_words_(&term_words), inv_length_(document_length == 0 ? 0.0 : 1.0 / document_length)
+{
+}
+
+WordFrequencies::Iterator WordFrequencies::begin() const
+{
+    return Iterator(begin_, term_words_, inv_length_);
+}
+
+WordFrequencies::Iterator WordFrequencies::end() const
+{
+    return Iterator(end_, term_words_, inv_length_);
+}
+
+size_t WordFrequencies::size() const
+{
+    return end_ - begin_;
+}
+
+bool WordFrequencies::empty() const
+{
+    return begin_ == end_;
+}
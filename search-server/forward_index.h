@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Запись прямого индекса: идентификатор слова и число его вхождений в документ.
+// Записи документа хранятся одним массивом, отсортированным по идентификатору слова.
+// TF восстанавливается как count / длина документа
+struct TermCount
+{
+    uint32_t term_id;
+    uint32_t count;
+};
+
+using TermCounts = std::pmr::vector<TermCount>;
+using TermWords = std::pmr::vector<std::string_view>;
+
+// Сворачивает идентификаторы слов документа в отсортированный массив записей в памяти resource
+TermCounts MakeTermCounts(std::vector<uint32_t> term_ids, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+bool ContainsTerm(const TermCounts& terms, uint32_t term_id);
+
+// Пересечение отсортированных идентификаторов слов со словами документа
+std::vector<uint32_t> IntersectTerms(const std::vector<uint32_t>& term_ids, const TermCounts& terms);
+
+// Частоты слов документа поверх прямого индекса. При обходе выдаются пары (слово, TF)
+// в порядке идентификаторов слов. Представление действительно до изменения индекса
+class WordFrequencies
+{
+    public:
+        class Iterator
+        {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = std::pair<std::string_view, double>;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = value_type;
+
+                Iterator(const TermCount* position, const TermWords* term_words, double inv_length);
+
+                value_type operator*() const;
+                Iterator& operator++();
+                Iterator operator++(int);
+
+                bool operator==(const Iterator& other) const;
+                bool operator!=(const Iterator& other) const;
+
+            private:
+                const TermCount* position_;
+                const TermWords* term_words_;
+                double inv_length_;
+        };
+
+        WordFrequencies() = default;
+        WordFrequencies(const TermCounts& terms, const TermWords& term_words, uint32_t document_length);
+
+        Iterator begin() const;
+        Iterator end() const;
+
+        size_t size() const;
+        bool empty() const;
+
+    private:
+        const TermCount* begin_ = nullptr;
+        const TermCount* end_ = nullptr;
+        const TermWords* term_words_ = nullptr;
+        double inv_length_ = 0.0;
+};
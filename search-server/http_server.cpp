@@ -0,0 +1,353 @@
+#include "http_server.h"
+
+#include <array>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define HAS_EPOLL
+#endif
+
+using namespace std::literals;
+
+#ifdef HAS_EPOLL
+
+namespace
+{
+    const size_t EPOLL_EVENT_COUNT = 256;
+    const size_t READ_CHUNK_SIZE = 64 * 1024;
+
+    // Разобранный запрос соединения или готовый ответ на запрос, который не удалось разобрать
+    struct PendingRequest
+    {
+        int socket;
+        HttpRequest request;
+        std::optional<HttpResponse> error;
+    };
+}
+
+HttpServer::HttpServer(SearchService& service, uint16_t port, const std::string& address) : service_(service)
+{
+    sockaddr_in socket_address{};
+    socket_address.sin_family = AF_INET;
+    socket_address.sin_port = htons(port);
+    if(inet_pton(AF_INET, address.c_str(), &socket_address.sin_addr) != 1)
+    {
+        throw std::invalid_argument("Некорректный адрес сервера "s + address);
+    }
+
+    listen_socket_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    const int enable = 1;
+    socklen_t address_length = sizeof(socket_address);
+    if(listen_socket_ < 0 || setsockopt(listen_socket_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) != 0
+       || bind(listen_socket_, reinterpret_cast<const sockaddr*>(&socket_address), sizeof(socket_address)) != 0
+       || listen(listen_socket_, SOMAXCONN) != 0
+       || getsockname(listen_socket_, reinterpret_cast<sockaddr*>(&socket_address), &address_length) != 0)
+    {
+        if(listen_socket_ >= 0)
+        {
+            close(listen_socket_);
+        }
+        throw std::runtime_error("Не удалось открыть порт "s + std::to_string(port) + " на адресе "s + address);
+    }
+    port_ = ntohs(socket_address.sin_port);
+
+    epoll_ = epoll_create1(EPOLL_CLOEXEC);
+    stop_event_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    for(const int descriptor : {listen_socket_, stop_event_})
+    {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = descriptor;
+        epoll_ctl(epoll_, EPOLL_CTL_ADD, descriptor, &event);
+    }
+}
+
+HttpServer::~HttpServer()
+{
+    for(const auto& [socket, _] : connections_)
+    {
+        close(socket);
+    }
+    close(stop_event_);
+    close(epoll_);
+    close(listen_socket_);
+}
+
+uint16_t HttpServer::GetPort() const
+{
+    return port_;
+}
+
+size_t HttpServer::GetHandledRequestCount() const
+{
+    return handled_request_count_.load(std::memory_order_relaxed);
+}
+
+size_t HttpServer::GetBatchCount() const
+{
+    return batch_count_.load(std::memory_order_relaxed);
+}
+
+void HttpServer::Run()
+{
+    std::array<epoll_event, EPOLL_EVENT_COUNT> events;
+    std::vector<int> readable_sockets;
+    std::vector<PendingRequest> pending_requests;
+    bool is_stopped = false;
+
+    while(!is_stopped)
+    {
+        const int event_count = epoll_wait(epoll_, events.data(), static_cast<int>(events.size()), -1);
+        if(event_count < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            throw std::runtime_error("Ошибка ожидания событий epoll"s);
+        }
+
+        readable_sockets.clear();
+        for(int i = 0; i < event_count; ++i)
+        {
+            const int descriptor = events[i].data.fd;
+            if(descriptor == stop_event_)
+            {
+                is_stopped = true;
+            }
+            else if(descriptor == listen_socket_)
+            {
+                AcceptConnections();
+            }
+            else if(const auto it = connections_.find(descriptor); it != connections_.end())
+            {
+                if(events[i].events & EPOLLOUT)
+                {
+                    FlushOutput(descriptor, it->second);
+                }
+                if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR) && connections_.count(descriptor) != 0)
+                {
+                    readable_sockets.push_back(descriptor);
+                }
+            }
+        }
+
+        // Все целиком пришедшие запросы всех соединений собираются в один пакет
+        pending_requests.clear();
+        for(const int socket : readable_sockets)
+        {
+            Connection& connection = connections_.at(socket);
+            if(!ReadInput(socket, connection))
+            {
+                connection.close_after_write = true;
+            }
+
+            size_t parsed_size = 0;
+            while(parsed_size < connection.input.size())
+            {
+                PendingRequest pending{socket, {}, std::nullopt};
+                try
+                {
+                    const size_t request_size = ParseHttpRequest(std::string_view(connection.input).substr(parsed_size), pending.request);
+                    if(request_size == 0)
+                    {
+                        break;
+                    }
+                    parsed_size += request_size;
+                }
+                catch(const std::invalid_argument&)
+                {
+                    pending.error = HttpResponse{400, "{\"error\": \"bad request\"}"s};
+                    pending.request.keep_alive = false;
+                    parsed_size = connection.input.size();
+                }
+
+                const bool keep_alive = pending.request.keep_alive;
+                pending_requests.push_back(std::move(pending));
+                if(!keep_alive)
+                {
+                    // Запросы после запроса без keep-alive не обрабатываются
+                    parsed_size = connection.input.size();
+                }
+            }
+            connection.input.erase(0, parsed_size);
+        }
+
+        std::vector<const HttpRequest*> batch;
+        for(const PendingRequest& pending : pending_requests)
+        {
+            if(!pending.error)
+            {
+                batch.push_back(&pending.request);
+            }
+        }
+        std::vector<HttpResponse> responses;
+        if(!batch.empty())
+        {
+            responses = service_.HandleBatch(batch);
+            handled_request_count_.fetch_add(batch.size(), std::memory_order_relaxed);
+            batch_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        size_t response_index = 0;
+        for(const PendingRequest& pending : pending_requests)
+        {
+            Connection& connection = connections_.at(pending.socket);
+            const HttpResponse& response = pending.error ? *pending.error : responses[response_index++];
+            connection.output += SerializeHttpResponse(response, pending.request.keep_alive);
+            if(!pending.request.keep_alive)
+            {
+                connection.close_after_write = true;
+            }
+        }
+
+        for(const int socket : readable_sockets)
+        {
+            if(const auto it = connections_.find(socket); it != connections_.end())
+            {
+                FlushOutput(socket, it->second);
+            }
+        }
+    }
+}
+
+void HttpServer::Stop()
+{
+    const uint64_t value = 1;
+    [[maybe_unused]] const ssize_t written = write(stop_event_, &value, sizeof(value));
+}
+
+void HttpServer::AcceptConnections()
+{
+    while(true)
+    {
+        const int socket = accept4(listen_socket_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(socket < 0)
+        {
+            return;
+        }
+
+        // Ответы на конвейер запросов уходят сразу, без задержки алгоритма Нейгла
+        const int enable = 1;
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = socket;
+        epoll_ctl(epoll_, EPOLL_CTL_ADD, socket, &event);
+        connections_[socket];
+    }
+}
+
+bool HttpServer::ReadInput(int socket, Connection& connection)
+{
+    while(true)
+    {
+        const size_t old_size = connection.input.size();
+        connection.input.resize(old_size + READ_CHUNK_SIZE);
+        const ssize_t read_size = read(socket, connection.input.data() + old_size, READ_CHUNK_SIZE);
+        connection.input.resize(old_size + std::max<ssize_t>(read_size, 0));
+
+        if(read_size == 0)
+        {
+            return false;
+        }
+        if(read_size < 0)
+        {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+    }
+}
+
+void HttpServer::FlushOutput(int socket, Connection& connection)
+{
+    while(connection.output_offset < connection.output.size())
+    {
+        const ssize_t written = send(socket, connection.output.data() + connection.output_offset,
+                                     connection.output.size() - connection.output_offset, MSG_NOSIGNAL);
+        if(written < 0)
+        {
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break;
+            }
+            CloseConnection(socket);
+            return;
+        }
+        connection.output_offset += written;
+    }
+
+    const bool is_flushed = connection.output_offset == connection.output.size();
+    if(is_flushed)
+    {
+        connection.output.clear();
+        connection.output_offset = 0;
+        if(connection.close_after_write)
+        {
+            CloseConnection(socket);
+            return;
+        }
+    }
+
+    // Недописанный ответ дописывается, когда сокет станет доступен для записи
+    if(is_flushed == connection.waits_for_write)
+    {
+        connection.waits_for_write = !is_flushed;
+        epoll_event event{};
+        event.events = is_flushed ? EPOLLIN : EPOLLIN | EPOLLOUT;
+        event.data.fd = socket;
+        epoll_ctl(epoll_, EPOLL_CTL_MOD, socket, &event);
+    }
+}
+
+void HttpServer::CloseConnection(int socket)
+{
+    epoll_ctl(epoll_, EPOLL_CTL_DEL, socket, nullptr);
+    close(socket);
+    connections_.erase(socket);
+}
+
+#else
+
+HttpServer::HttpServer(SearchService& service, uint16_t, const std::string&) : service_(service)
+{
+    throw std::runtime_error("HttpServer доступен только в Linux"s);
+}
+
+HttpServer::~HttpServer() = default;
+
+uint16_t HttpServer::GetPort() const
+{
+    return port_;
+}
+
+size_t HttpServer::GetHandledRequestCount() const
+{
+    return handled_request_count_;
+}
+
+size_t HttpServer::GetBatchCount() const
+{
+    return batch_count_;
+}
+
+void HttpServer::Run()
+{
+}
+
+void HttpServer::Stop()
+{
+}
+
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "search_service.h"
+
+// Однопоточный цикл событий epoll с неблокирующими сокетами поверх SearchService. Клиент может
+// отправлять запросы, не дожидаясь ответов: все целиком пришедшие за одно пробуждение запросы
+// всех соединений обрабатываются одним пакетом, ответы каждого соединения уходят в порядке запросов.
+// Доступен только в Linux
+class HttpServer
+{
+    public:
+        // Порт 0 выбирает свободный порт, его возвращает GetPort
+        HttpServer(SearchService& service, uint16_t port, const std::string& address = "127.0.0.1");
+        ~HttpServer();
+
+        HttpServer(const HttpServer&) = delete;
+        HttpServer& operator=(const HttpServer&) = delete;
+
+        uint16_t GetPort() const;
+        size_t GetHandledRequestCount() const;
+        size_t GetBatchCount() const;
+
+        // Обрабатывает соединения, пока не вызван Stop. Stop можно вызвать из другого потока
+        void Run();
+        void Stop();
+
+    private:
+        struct Connection
+        {
+            std::string input;
+            std::string output;
+            size_t output_offset = 0;
+            bool close_after_write = false;
+            bool waits_for_write = false;
+        };
+
+        SearchService& service_;
+        int listen_socket_ = -1;
+        int epoll_ = -1;
+        int stop_event_ = -1;
+        uint16_t port_ = 0;
+        std::unordered_map<int, Connection> connections_;
+        std::atomic<size_t> handled_request_count_ = 0;
+        std::atomic<size_t> batch_count_ = 0;
+
+        void AcceptConnections();
+        // Читает доступные данные. Возвращает false, если соединение закрыто клиентом
+        bool ReadInput(int socket, Connection& connection);
+        void FlushOutput(int socket, Connection& connection);
+        void CloseConnection(int socket);
+};
@@ -0,0 +1,144 @@
+#include "index_stats.h"
+
+#include <algorithm>
+
+using namespace std::literals;
+
+SpaceSavingSketch::SpaceSavingSketch(size_t capacity) : capacity_(capacity)
+{
+}
+
+void SpaceSavingSketch::Add(std::string_view item, uint64_t weight)
+{
+    if(capacity_ == 0)
+    {
+        return;
+    }
+    total_weight_ += weight;
+
+    auto it = counters_.find(item);
+    if(it != counters_.end())
+    {
+        counters_by_weight_.erase({it->second.weight, it->first});
+        it->second.weight += weight;
+    }
+    else if(counters_.size() < capacity_)
+    {
+        it = counters_.emplace(item, Counter{weight, 0}).first;
+    }
+    else
+    {
+        // Самый лёгкий счётчик переходит новому элементу вместе с весом, который становится погрешностью
+        const auto [min_weight, min_item] = *counters_by_weight_.begin();
+        counters_by_weight_.erase(counters_by_weight_.begin());
+        counters_.erase(counters_.find(min_item));
+        it = counters_.emplace(item, Counter{min_weight + weight, min_weight}).first;
+    }
+    counters_by_weight_.emplace(it->second.weight, it->first);
+}
+
+void SpaceSavingSketch::Merge(const SpaceSavingSketch& other)
+{
+    if(capacity_ == 0)
+    {
+        return;
+    }
+    total_weight_ += other.total_weight_;
+
+    const uint64_t missing_weight = GetMissingItemWeight();
+    const uint64_t other_missing_weight = other.GetMissingItemWeight();
+    std::map<std::string, Counter, std::less<>> merged;
+    for(const auto& [item, counter] : counters_)
+    {
+        merged.emplace(item, Counter{counter.weight + other_missing_weight, counter.error + other_missing_weight});
+    }
+    for(const auto& [item, counter] : other.counters_)
+    {
+        if(const auto it = merged.find(item); it != merged.end())
+        {
+            it->second.weight += counter.weight - other_missing_weight;
+            it->second.error += counter.error - other_missing_weight;
+        }
+        else
+        {
+            merged.emplace(item, Counter{counter.weight + missing_weight, counter.error + missing_weight});
+        }
+    }
+
+    // Остаются capacity_ самых тяжёлых счётчиков
+    std::vector<std::pair<uint64_t, std::string_view>> by_weight;
+    by_weight.reserve(merged.size());
+    for(const auto& [item, counter] : merged)
+    {
+        by_weight.emplace_back(counter.weight, item);
+    }
+    if(by_weight.size() > capacity_)
+    {
+        std::nth_element(by_weight.begin(), by_weight.begin() + capacity_, by_weight.end(), std::greater<>());
+        for(auto it = by_weight.begin() + capacity_; it != by_weight.end(); ++it)
+        {
+            merged.erase(merged.find(it->second));
+        }
+    }
+
+    counters_ = std::move(merged);
+    counters_by_weight_.clear();
+    for(const auto& [item, counter] : counters_)
+    {
+        counters_by_weight_.emplace(counter.weight, item);
+    }
+}
+
+std::vector<HeavyHitter> SpaceSavingSketch::GetTop(size_t count) const
+{
+    std::vector<HeavyHitter> result;
+    for(auto it = counters_by_weight_.rbegin(); it != counters_by_weight_.rend() && result.size() < count; ++it)
+    {
+        const Counter& counter = counters_.find(it->second)->second;
+        result.push_back({std::string(it->second), counter.weight, counter.error});
+    }
+
+    return result;
+}
+
+size_t SpaceSavingSketch::GetCapacity() const
+{
+    return capacity_;
+}
+
+uint64_t SpaceSavingSketch::GetTotalWeight() const
+{
+    return total_weight_;
+}
+
+uint64_t SpaceSavingSketch::GetMissingItemWeight() const
+{
+    return counters_.size() < capacity_ || counters_by_weight_.empty() ? 0 : counters_by_weight_.begin()->first;
+}
+
+std::ostream& operator<<(std::ostream& out, const IndexStats& stats)
+{
+    out << "{ documents = "sv << stats.document_count << ", vocabulary = "sv << stats.vocabulary_size
+        << ", live_terms = "sv << stats.live_term_count << ", postings = "sv << stats.posting_count << ", df_histogram = ["sv;
+    for(size_t i = 0; i < stats.document_frequency_histogram.size(); ++i)
+    {
+        out << (i > 0 ? ", "sv : ""sv) << stats.document_frequency_histogram[i];
+    }
+    out << "], heaviest_terms = ["sv;
+    for(size_t i = 0; i < stats.heaviest_terms.size(); ++i)
+    {
+        out << (i > 0 ? ", "sv : ""sv) << stats.heaviest_terms[i].word << ": "sv << stats.heaviest_terms[i].document_count;
+    }
+    out << "], costliest_query_terms = ["sv;
+    for(size_t i = 0; i < stats.costliest_query_terms.size(); ++i)
+    {
+        out << (i > 0 ? ", "sv : ""sv) << stats.costliest_query_terms[i].item << ": "sv << stats.costliest_query_terms[i].weight;
+    }
+    out << "], vocabulary_growth = ["sv;
+    for(size_t i = 0; i < stats.vocabulary_growth.size(); ++i)
+    {
+        out << (i > 0 ? ", "sv : ""sv) << stats.vocabulary_growth[i].added_document_count << ": "sv << stats.vocabulary_growth[i].vocabulary_size;
+    }
+
+    return out << "] }"sv;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Число счётчиков скетча слов запросов SearchServer. Поиск пишет в один из QUERY_TERM_SKETCH_SHARD_COUNT скетчей,
+// выбранный по потоку, а GetIndexStats сливает их
+const size_t QUERY_TERM_SKETCH_CAPACITY = 1024;
+const size_t QUERY_TERM_SKETCH_SHARD_COUNT = 8;
+// Точка роста словаря записывается каждые VOCABULARY_SAMPLE_INTERVAL добавленных документов.
+// Когда точек становится больше MAX_VOCABULARY_POINTS, каждая вторая выбрасывается, а интервал удваивается
+const uint64_t VOCABULARY_SAMPLE_INTERVAL = 1000;
+const size_t MAX_VOCABULARY_POINTS = 512;
+
+// Элемент с весом из скетча. Истинный вес лежит в [weight - error, weight]
+struct HeavyHitter
+{
+    std::string item;
+    uint64_t weight = 0;
+    uint64_t error = 0;
+};
+
+// Скетч Space-Saving: приближённые самые тяжёлые элементы потока в памяти на capacity счётчиков.
+// Новый элемент при заполненном скетче занимает счётчик самого лёгкого, наследуя его вес как погрешность,
+// поэтому любой элемент тяжелее total_weight / capacity гарантированно остаётся в скетче
+class SpaceSavingSketch
+{
+    public:
+        // Скетч нулевой ёмкости ничего не запоминает
+        explicit SpaceSavingSketch(size_t capacity);
+
+        // counters_by_weight_ указывает в ключи counters_, поэтому скетч перемещается, но не копируется
+        SpaceSavingSketch(const SpaceSavingSketch&) = delete;
+        SpaceSavingSketch& operator=(const SpaceSavingSketch&) = delete;
+        SpaceSavingSketch(SpaceSavingSketch&&) = default;
+        SpaceSavingSketch& operator=(SpaceSavingSketch&&) = default;
+
+        void Add(std::string_view item, uint64_t weight = 1);
+        // Добавляет поток другого скетча. Элемент, которого нет в заполненном скетче, мог иметь в нём вес
+        // до минимального счётчика, поэтому этот минимум прибавляется к его весу и погрешности.
+        // Гарантия total_weight / capacity сохраняется для объединённого потока
+        void Merge(const SpaceSavingSketch& other);
+        // Не больше count самых тяжёлых элементов по убыванию веса
+        std::vector<HeavyHitter> GetTop(size_t count) const;
+
+        size_t GetCapacity() const;
+        uint64_t GetTotalWeight() const;
+
+    private:
+        struct Counter
+        {
+            uint64_t weight;
+            uint64_t error;
+        };
+
+        size_t capacity_;
+        uint64_t total_weight_ = 0;
+        std::map<std::string, Counter, std::less<>> counters_;
+        // Счётчики по возрастанию веса, строки указывают в ключи counters_
+        std::set<std::pair<uint64_t, std::string_view>> counters_by_weight_;
+
+        uint64_t GetMissingItemWeight() const;
+};
+
+struct TermStats
+{
+    std::string word;
+    size_t document_count = 0;
+};
+
+// Размер словаря после added_document_count добавленных документов
+struct VocabularyPoint
+{
+    uint64_t added_document_count = 0;
+    size_t vocabulary_size = 0;
+    std::chrono::steady_clock::time_point time;
+};
+
+// Статистика индекса SearchServer, возвращается GetIndexStats
+struct IndexStats
+{
+    size_t document_count = 0;
+    // Все слова словаря, включая слова, все документы которых удалены
+    size_t vocabulary_size = 0;
+    size_t live_term_count = 0;
+    uint64_t posting_count = 0;
+    // document_frequency_histogram[i] — число слов, встречающихся в [2^i, 2^(i+1)) документах
+    std::vector<size_t> document_frequency_histogram;
+    // Слова с самыми длинными постингами в индексе
+    std::vector<TermStats> heaviest_terms;
+    // Слова запросов с наибольшей суммарной длиной обойдённых постингов, из скетча Space-Saving
+    std::vector<HeavyHitter> costliest_query_terms;
+    uint64_t total_query_posting_count = 0;
+    // Последняя точка соответствует моменту вызова GetIndexStats
+    std::vector<VocabularyPoint> vocabulary_growth;
+};
+
+std::ostream& operator<<(std::ostream& out, const IndexStats& stats);
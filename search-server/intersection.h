@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <iterator>
+
+// Если один список длиннее другого в GALLOPING_RATIO раз и более,
+// пересечение ищется экспоненциальным поиском по длинному списку
+const size_t GALLOPING_RATIO = 8;
+
+template <typename T>
+std::vector<T> IntersectSorted(const std::vector<T>& lhs, const std::vector<T>& rhs)
+{
+    const std::vector<T>& small = lhs.size() <= rhs.size() ? lhs : rhs;
+    const std::vector<T>& large = lhs.size() <= rhs.size() ? rhs : lhs;
+
+    std::vector<T> result;
+    result.reserve(small.size());
+
+    if(small.empty())
+    {
+        return result;
+    }
+
+    if(large.size() / small.size() < GALLOPING_RATIO)
+    {
+        std::set_intersection(small.begin(), small.end(), large.begin(), large.end(), std::back_inserter(result));
+        return result;
+    }
+
+    auto first = large.begin();
+    for(const T& value : small)
+    {
+        size_t step = 1;
+        auto last = first;
+        while(last != large.end() && *last < value)
+        {
+            first = last;
+            last = static_cast<size_t>(large.end() - last) > step ? last + step : large.end();
+            step *= 2;
+        }
+
+        first = std::lower_bound(first, last, value);
+        if(first == large.end())
+        {
+            break;
+        }
+        if(*first == value)
+        {
+            result.push_back(value);
+        }
+    }
+
+    return result;
+}
+
+template <typename T>
+std::vector<T> IntersectSorted(std::vector<std::vector<T>> lists)
+{
+    if(lists.empty())
+    {
+        return {};
+    }
+
+    std::sort(lists.begin(), lists.end(), [](const std::vector<T>& lhs, const std::vector<T>& rhs){
+        return lhs.size() < rhs.size();
+    });
+
+    std::vector<T> result = std::move(lists.front());
+    for(size_t i = 1; i < lists.size() && !result.empty(); ++i)
+    {
+        result = IntersectSorted(result, lists[i]);
+    }
+
+    return result;
+}
+
+template <typename T>
+std::vector<T> UniteSorted(const std::vector<T>& lhs, const std::vector<T>& rhs)
+{
+    std::vector<T> result;
+    result.reserve(lhs.size() + rhs.size());
+    std::set_union(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(result));
+
+    return result;
+}
@@ -0,0 +1,81 @@
+#include "memory_stats.h"
+
+#include <stdexcept>
+
+using namespace std::literals;
+
+CountingMemoryResource::CountingMemoryResource(std::pmr::memory_resource* upstream) : upstream_(upstream)
+{
+}
+
+size_t CountingMemoryResource::GetAllocatedBytes() const
+{
+    return allocated_bytes_.load(std::memory_order_relaxed);
+}
+
+size_t CountingMemoryResource::GetPeakAllocatedBytes() const
+{
+    return peak_allocated_bytes_.load(std::memory_order_relaxed);
+}
+
+size_t CountingMemoryResource::GetAllocationCount() const
+{
+    return allocation_count_.load(std::memory_order_relaxed);
+}
+
+void CountingMemoryResource::SetUpstream(std::pmr::memory_resource* upstream)
+{
+    if(GetAllocatedBytes() != 0)
+    {
+        throw std::logic_error("Источник памяти можно сменить только у пустого ресурса.");
+    }
+
+    upstream_ = upstream;
+}
+
+std::pmr::memory_resource* CountingMemoryResource::GetUpstream() const
+{
+    return upstream_;
+}
+
+void* CountingMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+    void* pointer = upstream_->allocate(bytes, alignment);
+
+    const size_t allocated = allocated_bytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    allocation_count_.fetch_add(1, std::memory_order_relaxed);
+
+    size_t peak = peak_allocated_bytes_.load(std::memory_order_relaxed);
+    while(allocated > peak && !peak_allocated_bytes_.compare_exchange_weak(peak, allocated, std::memory_order_relaxed))
+    {
+    }
+
+    return pointer;
+}
+
+void CountingMemoryResource::do_deallocate(void* pointer, size_t bytes, size_t alignment)
+{
+    upstream_->deallocate(pointer, bytes, alignment);
+    allocated_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+bool CountingMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+size_t MemoryStats::GetTotalBytes() const
+{
+    return term_dictionary_bytes + inverted_index_bytes + positional_index_bytes + forward_index_bytes + document_metadata_bytes + stop_words_bytes;
+}
+
+std::ostream& operator<<(std::ostream& out, const MemoryStats& stats)
+{
+    return out << "{ term_dictionary = "sv << stats.term_dictionary_bytes
+               << ", inverted_index = "sv << stats.inverted_index_bytes
+               << ", positional_index = "sv << stats.positional_index_bytes
+               << ", forward_index = "sv << stats.forward_index_bytes
+               << ", document_metadata = "sv << stats.document_metadata_bytes
+               << ", stop_words = "sv << stats.stop_words_bytes
+               << ", total = "sv << stats.GetTotalBytes() << " }"sv;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <memory_resource>
+
+// Ресурс памяти, считающий выделенные через него байты. Контейнеры индекса получают его через
+// std::pmr-аллокатор, поэтому учитывается всё, что они запрашивают, включая узлы деревьев и запас ёмкости.
+// Служебные заголовки malloc не учитываются
+class CountingMemoryResource : public std::pmr::memory_resource
+{
+    public:
+        explicit CountingMemoryResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+        size_t GetAllocatedBytes() const;
+        size_t GetPeakAllocatedBytes() const;
+        size_t GetAllocationCount() const;
+
+        // Меняет источник памяти. Допустимо, только пока через ресурс ничего не выделено
+        void SetUpstream(std::pmr::memory_resource* upstream);
+        std::pmr::memory_resource* GetUpstream() const;
+
+    private:
+        std::pmr::memory_resource* upstream_;
+        std::atomic<size_t> allocated_bytes_ = 0;
+        std::atomic<size_t> peak_allocated_bytes_ = 0;
+        std::atomic<size_t> allocation_count_ = 0;
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+// Память структур индекса SearchServer в байтах
+struct MemoryStats
+{
+    // Слова индекса, их идентификаторы и префиксное дерево для шаблонов и нечёткого поиска
+    size_t term_dictionary_bytes = 0;
+    size_t inverted_index_bytes = 0;
+    size_t positional_index_bytes = 0;
+    size_t forward_index_bytes = 0;
+    // Рейтинг, статус и длина документов, множество id и индексы атрибутов
+    size_t document_metadata_bytes = 0;
+    size_t stop_words_bytes = 0;
+
+    size_t GetTotalBytes() const;
+};
+
+std::ostream& operator<<(std::ostream& out, const MemoryStats& stats);
@@ -0,0 +1,333 @@
+#include "posting_list.h"
+#include "score_kernel.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Код 0 означает нулевой TF, код c > 0 — значение 2^(-(255 - c) / 16)
+    const int LOG_UINT8_STEPS_PER_OCTAVE = 16;
+
+    std::array<double, 256> MakeLogUint8Values()
+    {
+        std::array<double, 256> values{};
+        for(int code = 1; code < 256; ++code)
+        {
+            values[code] = std::exp2(-static_cast<double>(255 - code) / LOG_UINT8_STEPS_PER_OCTAVE);
+        }
+
+        return values;
+    }
+
+    const std::array<double, 256> LOG_UINT8_VALUES = MakeLogUint8Values();
+}
+
+uint16_t EncodeFloat16(double value)
+{
+    const float single = static_cast<float>(value);
+    uint32_t bits;
+    std::memcpy(&bits, &single, sizeof(bits));
+
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    const int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if(exponent >= 31)
+    {
+        return sign | 0x7C00;
+    }
+
+    if(exponent <= 0)
+    {
+        // Денормализованное число половинной точности
+        if(exponent < -10)
+        {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        const int shift = 14 - exponent;
+        uint32_t half_mantissa = mantissa >> shift;
+        if((mantissa >> (shift - 1)) & 1)
+        {
+            ++half_mantissa;
+        }
+        return static_cast<uint16_t>(sign | half_mantissa);
+    }
+
+    uint16_t half = static_cast<uint16_t>(sign | (exponent << 10) | (mantissa >> 13));
+    if(mantissa & 0x1000)
+    {
+        // Округление к ближайшему, перенос в порядок даёт верный результат
+        ++half;
+    }
+
+    return half;
+}
+
+double DecodeFloat16(uint16_t code)
+{
+    const int exponent = (code >> 10) & 0x1F;
+    const int mantissa = code & 0x3FF;
+    const double sign = (code & 0x8000) ? -1.0 : 1.0;
+
+    if(exponent == 0)
+    {
+        return sign * std::ldexp(mantissa, -24);
+    }
+    if(exponent == 31)
+    {
+        return sign * HUGE_VAL;
+    }
+
+    return sign * std::ldexp(1024 + mantissa, exponent - 25);
+}
+
+uint8_t EncodeLogUint8(double value)
+{
+    if(value <= 0.0)
+    {
+        return 0;
+    }
+
+    const long code = 255 + std::lround(std::log2(value) * LOG_UINT8_STEPS_PER_OCTAVE);
+    return static_cast<uint8_t>(std::clamp(code, 1l, 255l));
+}
+
+double DecodeLogUint8(uint8_t code)
+{
+    return LOG_UINT8_VALUES[code];
+}
+
+PostingList::Iterator::Iterator(const PostingList* postings, size_t index) : postings_(postings), index_(index)
+{
+}
+
+PostingList::Iterator::value_type PostingList::Iterator::operator*() const
+{
+    return {postings_->GetDocumentId(index_), postings_->GetTermFreq(index_)};
+}
+
+PostingList::Iterator& PostingList::Iterator::operator++()
+{
+    ++index_;
+    return *this;
+}
+
+PostingList::Iterator PostingList::Iterator::operator++(int)
+{
+    Iterator previous = *this;
+    ++index_;
+    return previous;
+}
+
+bool PostingList::Iterator::operator==(const Iterator& other) const
+{
+    return index_ == other.index_;
+}
+
+bool PostingList::Iterator::operator!=(const Iterator& other) const
+{
+    return index_ != other.index_;
+}
+
+PostingList::PostingList(TermFreqPrecision precision, const allocator_type& allocator)
+    : precision_(precision), document_ids_(allocator), exact_freqs_(allocator), half_freqs_(allocator), byte_freqs_(allocator)
+{
+}
+
+PostingList::PostingList(const PostingList& other, const allocator_type& allocator)
+    : precision_(other.precision_), document_ids_(other.document_ids_, allocator), exact_freqs_(other.exact_freqs_, allocator),
+      half_freqs_(other.half_freqs_, allocator), byte_freqs_(other.byte_freqs_, allocator)
+{
+}
+
+PostingList::PostingList(PostingList&& other, const allocator_type& allocator)
+    : precision_(other.precision_), document_ids_(std::move(other.document_ids_), allocator), exact_freqs_(std::move(other.exact_freqs_), allocator),
+      half_freqs_(std::move(other.half_freqs_), allocator), byte_freqs_(std::move(other.byte_freqs_), allocator)
+{
+}
+
+void PostingList::Insert(int document_id, double term_freq)
+{
+    const auto position = std::lower_bound(document_ids_.begin(), document_ids_.end(), document_id);
+    const size_t index = position - document_ids_.begin();
+    const bool is_new = position == document_ids_.end() || *position != document_id;
+
+    if(is_new)
+    {
+        document_ids_.insert(position, document_id);
+    }
+
+    switch(precision_)
+    {
+        case TermFreqPrecision::EXACT:
+            if(is_new)
+            {
+                exact_freqs_.insert(exact_freqs_.begin() + index, term_freq);
+            }
+            else
+            {
+                exact_freqs_[index] = term_freq;
+            }
+            break;
+
+        case TermFreqPrecision::FLOAT16:
+            if(is_new)
+            {
+                half_freqs_.insert(half_freqs_.begin() + index, EncodeFloat16(term_freq));
+            }
+            else
+            {
+                half_freqs_[index] = EncodeFloat16(term_freq);
+            }
+            break;
+
+        case TermFreqPrecision::UINT8:
+            if(is_new)
+            {
+                byte_freqs_.insert(byte_freqs_.begin() + index, EncodeLogUint8(term_freq));
+            }
+            else
+            {
+                byte_freqs_[index] = EncodeLogUint8(term_freq);
+            }
+            break;
+    }
+}
+
+void PostingList::Reserve(size_t count)
+{
+    document_ids_.reserve(count);
+    switch(precision_)
+    {
+        case TermFreqPrecision::EXACT:
+            exact_freqs_.reserve(count);
+            break;
+        case TermFreqPrecision::FLOAT16:
+            half_freqs_.reserve(count);
+            break;
+        case TermFreqPrecision::UINT8:
+            byte_freqs_.reserve(count);
+            break;
+    }
+}
+
+void PostingList::Erase(int document_id)
+{
+    const size_t index = FindIndex(document_id);
+    if(index == document_ids_.size())
+    {
+        return;
+    }
+
+    document_ids_.erase(document_ids_.begin() + index);
+    switch(precision_)
+    {
+        case TermFreqPrecision::EXACT:
+            exact_freqs_.erase(exact_freqs_.begin() + index);
+            break;
+        case TermFreqPrecision::FLOAT16:
+            half_freqs_.erase(half_freqs_.begin() + index);
+            break;
+        case TermFreqPrecision::UINT8:
+            byte_freqs_.erase(byte_freqs_.begin() + index);
+            break;
+    }
+}
+
+bool PostingList::Contains(int document_id) const
+{
+    return std::binary_search(document_ids_.begin(), document_ids_.end(), document_id);
+}
+
+PostingList::Iterator PostingList::Find(int document_id) const
+{
+    return Iterator(this, FindIndex(document_id));
+}
+
+int PostingList::GetDocumentId(size_t index) const
+{
+    return document_ids_[index];
+}
+
+double PostingList::GetTermFreq(size_t index) const
+{
+    switch(precision_)
+    {
+        case TermFreqPrecision::FLOAT16:
+            return DecodeFloat16(half_freqs_[index]);
+        case TermFreqPrecision::UINT8:
+            return DecodeLogUint8(byte_freqs_[index]);
+        default:
+            return exact_freqs_[index];
+    }
+}
+
+const std::pmr::vector<int>& PostingList::GetDocumentIds() const
+{
+    return document_ids_;
+}
+
+void PostingList::ScaleTermFreqs(size_t first, size_t count, double factor, double* out) const
+{
+    switch(precision_)
+    {
+        case TermFreqPrecision::EXACT:
+            ::ScaleTermFreqs(DetectSimdLevel(), exact_freqs_.data() + first, count, factor, out);
+            break;
+        case TermFreqPrecision::FLOAT16:
+            ::ScaleTermFreqs(DetectSimdLevel(), half_freqs_.data() + first, count, factor, out);
+            break;
+        case TermFreqPrecision::UINT8:
+            for(size_t i = 0; i < count; ++i)
+            {
+                out[i] = DecodeLogUint8(byte_freqs_[first + i]) * factor;
+            }
+            break;
+    }
+}
+
+TermFreqPrecision PostingList::GetPrecision() const
+{
+    return precision_;
+}
+
+size_t PostingList::GetMemoryUsage() const
+{
+    return document_ids_.capacity() * sizeof(int) + exact_freqs_.capacity() * sizeof(double)
+        + half_freqs_.capacity() * sizeof(uint16_t) + byte_freqs_.capacity() * sizeof(uint8_t);
+}
+
+size_t PostingList::size() const
+{
+    return document_ids_.size();
+}
+
+bool PostingList::empty() const
+{
+    return document_ids_.empty();
+}
+
+PostingList::Iterator PostingList::begin() const
+{
+    return Iterator(this, 0);
+}
+
+PostingList::Iterator PostingList::end() const
+{
+    return Iterator(this, document_ids_.size());
+}
+
+size_t PostingList::FindIndex(int document_id) const
+{
+    const auto position = std::lower_bound(document_ids_.begin(), document_ids_.end(), document_id);
+    if(position == document_ids_.end() || *position != document_id)
+    {
+        return document_ids_.size();
+    }
+
+    return position - document_ids_.begin();
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+// Точность хранения TF в постингах. EXACT — double, FLOAT16 — половинная точность IEEE 754
+// (относительная ошибка до 2^-11), UINT8 — логарифмическая шкала с шагом 2^(1/16) (ошибка до 2.2%).
+// TF уже нормирован длиной документа и лежит в (0, 1], поэтому шкалы не нужно масштабировать
+enum class TermFreqPrecision
+{
+    EXACT,
+    FLOAT16,
+    UINT8,
+};
+
+uint16_t EncodeFloat16(double value);
+double DecodeFloat16(uint16_t code);
+uint8_t EncodeLogUint8(double value);
+double DecodeLogUint8(uint8_t code);
+
+// Постинги слова: отсортированные id документов и TF в одном непрерывном массиве выбранной точности.
+// Массивы берут память у аллокатора списка, в контейнерах std::pmr он передаётся автоматически
+class PostingList
+{
+    public:
+        class Iterator
+        {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = std::pair<int, double>;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = value_type;
+
+                Iterator(const PostingList* postings, size_t index);
+
+                value_type operator*() const;
+                Iterator& operator++();
+                Iterator operator++(int);
+
+                bool operator==(const Iterator& other) const;
+                bool operator!=(const Iterator& other) const;
+
+            private:
+                const PostingList* postings_;
+                size_t index_;
+        };
+
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+        explicit PostingList(TermFreqPrecision precision = TermFreqPrecision::EXACT, const allocator_type& allocator = {});
+        PostingList(const PostingList& other, const allocator_type& allocator);
+        PostingList(PostingList&& other, const allocator_type& allocator);
+        PostingList(const PostingList& other) = default;
+        PostingList(PostingList&& other) = default;
+        PostingList& operator=(const PostingList& other) = default;
+        PostingList& operator=(PostingList&& other) = default;
+
+        // Добавляет документ или заменяет его TF
+        void Insert(int document_id, double term_freq);
+        void Erase(int document_id);
+        // Резервирует место под count постингов, чтобы при построении индекса массивы выделялись один раз
+        void Reserve(size_t count);
+
+        bool Contains(int document_id) const;
+        Iterator Find(int document_id) const;
+
+        int GetDocumentId(size_t index) const;
+        double GetTermFreq(size_t index) const;
+        const std::pmr::vector<int>& GetDocumentIds() const;
+
+        // out[i] = factor * TF постинга first + i, вычисляется векторным ядром из score_kernel.h
+        void ScaleTermFreqs(size_t first, size_t count, double factor, double* out) const;
+
+        TermFreqPrecision GetPrecision() const;
+        size_t GetMemoryUsage() const;
+
+        size_t size() const;
+        bool empty() const;
+
+        Iterator begin() const;
+        Iterator end() const;
+
+    private:
+        TermFreqPrecision precision_;
+        std::pmr::vector<int> document_ids_;
+        std::pmr::vector<double> exact_freqs_;
+        std::pmr::vector<uint16_t> half_freqs_;
+        std::pmr::vector<uint8_t> byte_freqs_;
+
+        size_t FindIndex(int document_id) const;
+};
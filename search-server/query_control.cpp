@@ -0,0 +1,44 @@
+#include "query_control.h"
+
+QueryControl::QueryControl(Clock::time_point deadline) : deadline_(deadline)
+{
+}
+
+QueryControl::QueryControl(Clock::duration timeout) : deadline_(Clock::now() + timeout)
+{
+}
+
+void QueryControl::Cancel()
+{
+    cancelled_ = true;
+}
+
+bool QueryControl::IsCancelled() const
+{
+    return cancelled_;
+}
+
+QueryControl::Clock::time_point QueryControl::GetDeadline() const
+{
+    return deadline_;
+}
+
+bool QueryControl::ShouldStop() const
+{
+    if(stopped_)
+    {
+        return true;
+    }
+
+    if(cancelled_ || (deadline_ != Clock::time_point::max() && Clock::now() >= deadline_))
+    {
+        stopped_ = true;
+    }
+
+    return stopped_;
+}
+
+bool QueryControl::WasStopped() const
+{
+    return stopped_;
+}
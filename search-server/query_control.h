@@ -0,0 +1,29 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+// Срок выполнения и отмена запроса. Поиск проверяет ShouldStop при обходе постингов и, если пора остановиться,
+// возвращает лучшие документы из уже обработанных. Отменить запрос можно из другого потока
+class QueryControl
+{
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        QueryControl() = default;
+        explicit QueryControl(Clock::time_point deadline);
+        explicit QueryControl(Clock::duration timeout);
+
+        void Cancel();
+        bool IsCancelled() const;
+        Clock::time_point GetDeadline() const;
+
+        // Запоминает остановку, чтобы вызывающий мог отличить неполный результат
+        bool ShouldStop() const;
+        bool WasStopped() const;
+
+    private:
+        Clock::time_point deadline_ = Clock::time_point::max();
+        std::atomic_bool cancelled_ = false;
+        mutable std::atomic_bool stopped_ = false;
+};
@@ -0,0 +1,83 @@
+#include "query_executor.h"
+
+#include <algorithm>
+
+QueryExecutor::QueryExecutor(const SearchServer& search_server, size_t thread_count) : search_server_(search_server)
+{
+    thread_count = std::max<size_t>(thread_count, 1);
+    workers_.reserve(thread_count);
+    for(size_t i = 0; i < thread_count; ++i)
+    {
+        workers_.emplace_back([this]() {
+            RunWorker();
+        });
+    }
+}
+
+QueryExecutor::~QueryExecutor()
+{
+    {
+        std::lock_guard guard(tasks_mutex_);
+        stopping_ = true;
+    }
+    tasks_changed_.notify_all();
+
+    for(std::thread& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+std::future<SearchResult> QueryExecutor::Submit(std::string raw_query, std::shared_ptr<QueryControl> control)
+{
+    return Submit(std::move(raw_query), DocumentFilter{DocumentStatus::ACTUAL}, std::move(control));
+}
+
+std::future<SearchResult> QueryExecutor::Submit(std::string raw_query, std::chrono::steady_clock::duration timeout)
+{
+    return Submit(std::move(raw_query), std::make_shared<QueryControl>(timeout));
+}
+
+size_t QueryExecutor::GetThreadCount() const
+{
+    return workers_.size();
+}
+
+size_t QueryExecutor::GetQueueSize() const
+{
+    std::lock_guard guard(tasks_mutex_);
+    return tasks_.size();
+}
+
+void QueryExecutor::Enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard guard(tasks_mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    tasks_changed_.notify_one();
+}
+
+void QueryExecutor::RunWorker()
+{
+    while(true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(tasks_mutex_);
+            tasks_changed_.wait(lock, [this]() {
+                return stopping_ || !tasks_.empty();
+            });
+
+            if(tasks_.empty())
+            {
+                return;
+            }
+
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "search_server.h"
+#include "query_control.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Асинхронные запросы к SearchServer на собственном пуле потоков.
+// Сервер нельзя изменять, пока в пуле есть невыполненные запросы
+class QueryExecutor
+{
+    public:
+        explicit QueryExecutor(const SearchServer& search_server, size_t thread_count = std::thread::hardware_concurrency());
+        // Дожидается выполнения всех поставленных запросов
+        ~QueryExecutor();
+
+        QueryExecutor(const QueryExecutor&) = delete;
+        QueryExecutor& operator=(const QueryExecutor&) = delete;
+
+        // Через control вызывающий может отменить запрос. Срок в control общий для ожидания в очереди и поиска:
+        // запрос, дождавшийся своей очереди после срока, сразу возвращает пустой неполный результат
+        template <typename Ranker = TfIdfRanker, typename DocumentPredicate>
+        std::future<SearchResult> Submit(std::string raw_query, DocumentPredicate document_predicate, std::shared_ptr<QueryControl> control);
+        std::future<SearchResult> Submit(std::string raw_query, std::shared_ptr<QueryControl> control);
+        std::future<SearchResult> Submit(std::string raw_query, std::chrono::steady_clock::duration timeout);
+
+        size_t GetThreadCount() const;
+        size_t GetQueueSize() const;
+
+    private:
+        const SearchServer& search_server_;
+        std::deque<std::function<void()>> tasks_;
+        mutable std::mutex tasks_mutex_;
+        std::condition_variable tasks_changed_;
+        bool stopping_ = false;
+        std::vector<std::thread> workers_;
+
+        void Enqueue(std::function<void()> task);
+        void RunWorker();
+};
+
+template <typename Ranker, typename DocumentPredicate>
+std::future<SearchResult> QueryExecutor::Submit(std::string raw_query, DocumentPredicate document_predicate, std::shared_ptr<QueryControl> control)
+{
+    if(!control)
+    {
+        throw std::invalid_argument("Не задано управление запросом");
+    }
+
+    // packaged_task только перемещается, а std::function требует копирования, поэтому задача хранится в shared_ptr
+    auto task = std::make_shared<std::packaged_task<SearchResult()>>(
+        [this, raw_query = std::move(raw_query), document_predicate, control = std::move(control)]() {
+            return search_server_.FindTopDocuments<Ranker>(raw_query, document_predicate, *control);
+        });
+
+    std::future<SearchResult> result = task->get_future();
+    Enqueue([task]() {
+        (*task)();
+    });
+
+    return result;
+}
@@ -0,0 +1,53 @@
+#include "query_plan.h"
+
+using namespace std::literals;
+
+namespace
+{
+    double ToMicroseconds(std::chrono::nanoseconds duration)
+    {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+}
+
+std::ostream& operator<<(std::ostream& out, ExecutionStrategy strategy)
+{
+    return out << (strategy == ExecutionStrategy::PARALLEL ? "par"sv : "seq"sv);
+}
+
+std::ostream& operator<<(std::ostream& out, const QueryPlan& plan)
+{
+    out << "Query plan: "sv << plan.strategy << ", term-at-a-time, estimated cost "sv << plan.estimated_cost << " postings"sv << std::endl;
+
+    for(const QueryPlanTerm& term : plan.terms)
+    {
+        switch(term.kind)
+        {
+            case QueryTermKind::PLUS:
+                out << "  + "sv;
+                break;
+            case QueryTermKind::EXPANDED:
+                out << "  ~ "sv;
+                break;
+            case QueryTermKind::MINUS:
+                out << "  - "sv;
+                break;
+        }
+
+        out << term.word << ": "sv << term.posting_count << " postings"sv;
+        if(term.kind != QueryTermKind::MINUS)
+        {
+            out << ", idf "sv << term.inverse_document_freq << ", weight "sv << term.weight
+                << (term.access == PostingAccess::FILTER_LOOKUP ? ", filter lookup"sv : ", scan"sv);
+        }
+        out << std::endl;
+    }
+
+    out << "  required groups "sv << plan.required_group_count << ", phrases "sv << plan.phrase_count
+        << ", filtered documents "sv << plan.filtered_document_count << std::endl;
+    out << "Timings: parse "sv << ToMicroseconds(plan.parse_time) << " us, scoring "sv << ToMicroseconds(plan.scoring_time)
+        << " us, top-K "sv << ToMicroseconds(plan.ranking_time) << " us; matched "sv << plan.matched_document_count
+        << ", returned "sv << plan.documents.size() << std::endl;
+
+    return out;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "document.h"
+#include "execution_thresholds.h"
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+enum class QueryTermKind
+{
+    PLUS,
+    EXPANDED,
+    MINUS,
+};
+
+// Обход постингов слова: полный проход в буфер релевантности (term-at-a-time)
+// или поиск в постингах только документов узкого фильтра
+enum class PostingAccess
+{
+    SCAN,
+    FILTER_LOOKUP,
+};
+
+struct QueryPlanTerm
+{
+    std::string word;
+    QueryTermKind kind = QueryTermKind::PLUS;
+    size_t posting_count = 0;
+    double inverse_document_freq = 0.0;
+    double weight = 1.0;
+    PostingAccess access = PostingAccess::SCAN;
+};
+
+// План запроса и фактические времена этапов выполнения, возвращается SearchServer::ExplainQuery
+struct QueryPlan
+{
+    std::vector<QueryPlanTerm> terms;
+    size_t required_group_count = 0;
+    size_t phrase_count = 0;
+    size_t filtered_document_count = 0;
+    size_t estimated_cost = 0;
+    ExecutionStrategy strategy = ExecutionStrategy::SEQUENTIAL;
+
+    std::chrono::nanoseconds parse_time{};
+    std::chrono::nanoseconds scoring_time{};
+    std::chrono::nanoseconds ranking_time{};
+    size_t matched_document_count = 0;
+    std::vector<Document> documents;
+};
+
+std::ostream& operator<<(std::ostream& out, ExecutionStrategy strategy);
+std::ostream& operator<<(std::ostream& out, const QueryPlan& plan);
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// Политики ранжирования выбираются параметром шаблона FindTopDocuments,
+// поэтому подсчёт релевантности встраивается во внутренний цикл поиска.
+// term_freq — доля слова среди слов документа, document_length — число слов документа без стоп-слов.
+// При IS_LINEAR_IN_TERM_FREQ релевантность равна term_freq * ComputeRelevance(1, ...) и считается векторным ядром
+
+struct TfIdfRanker
+{
+    static constexpr bool IS_LINEAR_IN_TERM_FREQ = true;
+
+    static double ComputeInverseDocumentFreq(int document_count, size_t document_freq)
+    {
+        return std::log(document_count * 1.0 / document_freq);
+    }
+
+    static double ComputeRelevance(double term_freq, double inverse_document_freq, uint32_t, double)
+    {
+        return term_freq * inverse_document_freq;
+    }
+};
+
+struct Bm25Ranker
+{
+    static constexpr bool IS_LINEAR_IN_TERM_FREQ = false;
+    static constexpr double K1 = 1.2;
+    static constexpr double B = 0.75;
+
+    static double ComputeInverseDocumentFreq(int document_count, size_t document_freq)
+    {
+        return std::log(1.0 + (document_count - static_cast<double>(document_freq) + 0.5) / (document_freq + 0.5));
+    }
+
+    static double ComputeRelevance(double term_freq, double inverse_document_freq, uint32_t document_length, double average_document_length)
+    {
+        const double count = term_freq * document_length;
+        const double length_norm = K1 * (1.0 - B + B * document_length / average_document_length);
+        return inverse_document_freq * count * (K1 + 1.0) / (count + length_norm);
+    }
+};
+
+// BM25F сначала нормирует частоту по длине каждого поля и взвешивает поля, а насыщение применяет к сумме.
+// У документа сейчас одно текстовое поле, поэтому сумма состоит из одного слагаемого
+struct Bm25FRanker
+{
+    static constexpr bool IS_LINEAR_IN_TERM_FREQ = false;
+    static constexpr double K1 = 1.2;
+    static constexpr double BODY_WEIGHT = 1.0;
+    static constexpr double BODY_B = 0.75;
+
+    static double ComputeInverseDocumentFreq(int document_count, size_t document_freq)
+    {
+        return Bm25Ranker::ComputeInverseDocumentFreq(document_count, document_freq);
+    }
+
+    static double ComputeRelevance(double term_freq, double inverse_document_freq, uint32_t document_length, double average_document_length)
+    {
+        const double body_freq = BODY_WEIGHT * term_freq * document_length / (1.0 - BODY_B + BODY_B * document_length / average_document_length);
+        return inverse_document_freq * body_freq * (K1 + 1.0) / (body_freq + K1);
+    }
+};
@@ -10,7 +10,7 @@ void RemoveDuplicates(SearchServer& search_server)
         std::set<std::string> word_set;
         for(auto [word, freq] : search_server.GetWordFrequencies(document_id))
         {
-            word_set.insert(word);
+            word_set.insert(std::string(word));
         }
 
         if(unique_word_sets.count(word_set) != 0)
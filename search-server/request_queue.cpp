@@ -1,41 +1,131 @@
 #include "request_queue.h"
 
-RequestQueue::RequestQueue(const SearchServer& search_server) : search_server_(search_server), query_num(1)
+RequestQueue::RequestQueue(const SearchServer& search_server, AdmissionLimits limits, std::chrono::steady_clock::duration stats_window)
+    : search_server_(search_server), request_stats_(stats_window, min_in_day_), limits_(limits)
 {
 }
 
-std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status)
+RequestResult RequestQueue::HandleRequest(const std::string& raw_query, RequestPriority priority)
 {
-    std::vector<Document> documents = search_server_.FindTopDocuments(raw_query, status);
-    AddResult(documents.size());
+    return HandleRequest(raw_query, DocumentFilter{DocumentStatus::ACTUAL}, priority);
+}
 
-    return documents;
+std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status)
+{
+    return HandleRequest(raw_query, DocumentFilter{status}, RequestPriority::NORMAL).search_result.documents;
 }
 
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query)
 {
-    std::vector<Document> documents = search_server_.FindTopDocuments(raw_query);
-    AddResult(documents.size());
-
-    return documents;
+    return AddFindRequest(raw_query, DocumentStatus::ACTUAL);
 }
 
 int RequestQueue::GetNoResultRequests() const
 {
-    int cnt = count_if(requests_.begin(), requests_.end(), [](QueryResult qr){
-        return qr.result_count == 0;
-    });
+    return static_cast<int>(request_stats_.GetSnapshot().no_result_count);
+}
+
+WindowStatsSnapshot RequestQueue::GetRequestStats() const
+{
+    return request_stats_.GetSnapshot();
+}
+
+AdmissionStats RequestQueue::GetAdmissionStats() const
+{
+    std::lock_guard guard(mutex_);
+    return stats_;
+}
+
+RequestQueue::Admission RequestQueue::Admit(RequestPriority priority)
+{
+    const auto arrival = std::chrono::steady_clock::now();
+    std::unique_lock lock(mutex_);
+
+    std::deque<uint64_t>& waiting = waiting_requests_[static_cast<size_t>(priority)];
+    if(waiting.size() >= limits_.max_queued_requests)
+    {
+        return Reject({});
+    }
+
+    const uint64_t ticket = next_ticket_++;
+    waiting.push_back(ticket);
+
+    const auto can_start = [this, priority, ticket]() {
+        return running_requests_ < limits_.max_concurrent_requests && IsNextInLine(priority, ticket);
+    };
 
-    return cnt;
+    bool admitted = true;
+    if(limits_.max_queue_time == std::chrono::steady_clock::duration::max())
+    {
+        slot_released_.wait(lock, can_start);
+    }
+    else
+    {
+        admitted = slot_released_.wait_until(lock, arrival + limits_.max_queue_time, can_start);
+    }
+
+    const auto queue_time = std::chrono::steady_clock::now() - arrival;
+    if(!admitted)
+    {
+        // Ушедший из очереди запрос мог загораживать следующие
+        waiting.erase(std::find(waiting.begin(), waiting.end(), ticket));
+        slot_released_.notify_all();
+        return Reject(queue_time);
+    }
+
+    waiting.pop_front();
+    ++running_requests_;
+    stats_.total_queue_time += queue_time;
+    stats_.max_queue_time = std::max(stats_.max_queue_time, queue_time);
+    // Следующий в очереди может пройти, если слоты ещё есть
+    slot_released_.notify_all();
+
+    return {true, queue_time};
 }
 
-void RequestQueue::AddResult(int result_num)
+void RequestQueue::Release(std::optional<RequestOutcome> outcome)
 {
-    query_num++;
-    requests_.push_back({query_num, result_num});
+    {
+        std::lock_guard guard(mutex_);
+        --running_requests_;
+        if(!outcome)
+        {
+            ++stats_.failed_requests;
+        }
+        else if(*outcome == RequestOutcome::REJECTED)
+        {
+            ++stats_.rejected_requests;
+        }
+        else if(*outcome == RequestOutcome::DEGRADED)
+        {
+            ++stats_.degraded_requests;
+        }
+        else
+        {
+            ++stats_.completed_requests;
+        }
+    }
+    slot_released_.notify_all();
+}
 
-    if(requests_.size() > min_in_day_)
+bool RequestQueue::IsNextInLine(RequestPriority priority, uint64_t ticket) const
+{
+    for(size_t higher = 0; higher < static_cast<size_t>(priority); ++higher)
     {
-        requests_.pop_front();
+        if(!waiting_requests_[higher].empty())
+        {
+            return false;
+        }
     }
-}
\ No newline at end of file
+
+    return waiting_requests_[static_cast<size_t>(priority)].front() == ticket;
+}
+
+RequestQueue::Admission RequestQueue::Reject(std::chrono::steady_clock::duration queue_time)
+{
+    ++stats_.rejected_requests;
+    stats_.total_queue_time += queue_time;
+    stats_.max_queue_time = std::max(stats_.max_queue_time, queue_time);
+
+    return {false, queue_time};
+}
@@ -2,37 +2,154 @@
 
 #include "search_server.h"
 #include "document.h"
+#include "query_control.h"
+#include "sliding_window_stats.h"
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <deque>
+#include <mutex>
+#include <optional>
 
+// Очереди ожидания обслуживаются строго по приоритету, внутри приоритета — по порядку поступления
+enum class RequestPriority
+{
+    HIGH,
+    NORMAL,
+    LOW,
+};
+
+// Ограничения входа в RequestQueue. Стоимость запроса оценивается SearchServer::EstimateQueryCost уже после получения
+// слота, так как разбор запроса — тоже работа. По умолчанию ограничений нет, и запросы выполняются как раньше
+struct AdmissionLimits
+{
+    size_t max_concurrent_requests = SIZE_MAX;
+    // Длина очереди ожидания каждого приоритета; запрос сверх неё отклоняется сразу
+    size_t max_queued_requests = SIZE_MAX;
+    // Запрос, не получивший слот за это время, отклоняется
+    std::chrono::steady_clock::duration max_queue_time = std::chrono::steady_clock::duration::max();
+    // Запросы дороже max_query_cost отклоняются, дороже degraded_query_cost — выполняются со сроком degraded_time_budget
+    size_t max_query_cost = SIZE_MAX;
+    size_t degraded_query_cost = SIZE_MAX;
+    std::chrono::steady_clock::duration degraded_time_budget = std::chrono::milliseconds(10);
+};
+
+enum class RequestOutcome
+{
+    COMPLETED,
+    DEGRADED,
+    REJECTED,
+};
+
+struct RequestResult
+{
+    RequestOutcome outcome = RequestOutcome::COMPLETED;
+    SearchResult search_result;
+    std::chrono::steady_clock::duration queue_time{};
+};
+
+struct AdmissionStats
+{
+    uint64_t completed_requests = 0;
+    uint64_t degraded_requests = 0;
+    uint64_t rejected_requests = 0;
+    // Запросы, выполнение которых завершилось исключением
+    uint64_t failed_requests = 0;
+    std::chrono::steady_clock::duration total_queue_time{};
+    std::chrono::steady_clock::duration max_queue_time{};
+};
+
+// Точка входа запросов: ограничивает число одновременно выполняемых запросов, держит очереди ожидания
+// по приоритетам и сбрасывает нагрузку по стоимости запроса и времени ожидания. Методы можно вызывать из разных потоков
 class RequestQueue
 {
     public:
-        explicit RequestQueue(const SearchServer& search_server);
+        // Статистика результатов считается за скользящее окно stats_window
+        explicit RequestQueue(const SearchServer& search_server, AdmissionLimits limits = {}, std::chrono::steady_clock::duration stats_window = std::chrono::hours(24));
+
+        template <typename DocumentPredicate>
+        RequestResult HandleRequest(const std::string& raw_query, DocumentPredicate document_predicate, RequestPriority priority);
+        RequestResult HandleRequest(const std::string& raw_query, RequestPriority priority);
 
+        // Запросы с обычным приоритетом. Отклонённый запрос возвращает пустой список и, как любой запрос
+        // без результатов, учитывается в GetNoResultRequests
         template <typename DocumentPredicate>
         std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate)
         {
-            std::vector<Document> documents = search_server_.FindTopDocuments(raw_query, document_predicate);
-            AddResult(documents.size());
-
-            return documents;
+            return HandleRequest(raw_query, document_predicate, RequestPriority::NORMAL).search_result.documents;
         }
 
         std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status);
         std::vector<Document> AddFindRequest(const std::string& raw_query);
         int GetNoResultRequests() const;
+        WindowStatsSnapshot GetRequestStats() const;
+        AdmissionStats GetAdmissionStats() const;
 
     private:
-        void AddResult(int result_num);
-
-        struct QueryResult
+        struct Admission
         {
-            int query_number;
-            int result_count;
+            bool is_admitted;
+            std::chrono::steady_clock::duration queue_time;
         };
 
-        std::deque<QueryResult> requests_;
+        Admission Admit(RequestPriority priority);
+        // Освобождает слот и учитывает исход запроса; nullopt — выполнение завершилось исключением
+        void Release(std::optional<RequestOutcome> outcome);
+        bool IsNextInLine(RequestPriority priority, uint64_t ticket) const;
+        Admission Reject(std::chrono::steady_clock::duration queue_time);
+
         const static int min_in_day_ = 1440;
         const SearchServer& search_server_;
-        int query_num;
-};
\ No newline at end of file
+        // Окно делится на min_in_day_ интервалов: для окна в сутки это поминутная статистика
+        SlidingWindowStats request_stats_;
+
+        const AdmissionLimits limits_;
+        mutable std::mutex mutex_;
+        std::condition_variable slot_released_;
+        std::array<std::deque<uint64_t>, 3> waiting_requests_;
+        uint64_t next_ticket_ = 0;
+        size_t running_requests_ = 0;
+        AdmissionStats stats_;
+};
+
+template <typename DocumentPredicate>
+RequestResult RequestQueue::HandleRequest(const std::string& raw_query, DocumentPredicate document_predicate, RequestPriority priority)
+{
+    const Admission admission = Admit(priority);
+
+    RequestResult result;
+    result.outcome = RequestOutcome::REJECTED;
+    result.queue_time = admission.queue_time;
+    result.search_result.is_complete = false;
+    if(!admission.is_admitted)
+    {
+        request_stats_.Record(0);
+        return result;
+    }
+
+    try
+    {
+        const size_t query_cost = search_server_.EstimateQueryCost(raw_query);
+        if(query_cost > limits_.max_query_cost)
+        {
+            Release(RequestOutcome::REJECTED);
+            request_stats_.Record(0);
+            return result;
+        }
+
+        // Дорогой запрос получает срок и возвращает лучшие документы, найденные за это время
+        result.outcome = query_cost > limits_.degraded_query_cost ? RequestOutcome::DEGRADED : RequestOutcome::COMPLETED;
+        const QueryControl control = result.outcome == RequestOutcome::DEGRADED ? QueryControl(limits_.degraded_time_budget) : QueryControl();
+        result.search_result = search_server_.FindTopDocuments(raw_query, document_predicate, control);
+    }
+    catch(...)
+    {
+        Release(std::nullopt);
+        throw;
+    }
+    Release(result.outcome);
+    request_stats_.Record(result.search_result.documents.size());
+
+    return result;
+}
@@ -0,0 +1,181 @@
+#include "result_cursors.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+using namespace std::literals;
+
+ResultCursors::ResultCursors(const SearchServer& search_server, CursorLimits limits)
+    : search_server_(search_server), limits_(limits), token_generator_(std::random_device{}())
+{
+}
+
+ResultPage ResultCursors::Open(const std::string& raw_query, size_t page_size)
+{
+    return Open(raw_query, DocumentFilter{DocumentStatus::ACTUAL}, page_size);
+}
+
+ResultPage ResultCursors::Next(const std::string& cursor, size_t page_size)
+{
+    ValidatePageSize(page_size);
+
+    std::shared_ptr<Cursor> state;
+    {
+        std::lock_guard guard(mutex_);
+        const auto now = std::chrono::steady_clock::now();
+        RemoveExpired(now);
+        const auto it = cursors_.find(cursor);
+        if(it == cursors_.end())
+        {
+            throw std::out_of_range("Курсор не найден или истёк"s);
+        }
+        it->second.last_access = now;
+        lru_.splice(lru_.end(), lru_, it->second.lru_position);
+        state = it->second.cursor;
+    }
+
+    // Повторное выполнение запроса идёт без общего мьютекса, чтобы не задерживать другие курсоры
+    std::lock_guard guard(state->mutex);
+    ResultPage page = TakePage(*state, page_size);
+    if(HasMore(*state))
+    {
+        page.next_cursor = cursor;
+    }
+    else
+    {
+        Close(cursor);
+    }
+
+    return page;
+}
+
+void ResultCursors::Close(const std::string& cursor)
+{
+    std::lock_guard guard(mutex_);
+    if(const auto it = cursors_.find(cursor); it != cursors_.end())
+    {
+        lru_.erase(it->second.lru_position);
+        cursors_.erase(it);
+    }
+}
+
+size_t ResultCursors::GetOpenCursorCount() const
+{
+    std::lock_guard guard(mutex_);
+    return cursors_.size();
+}
+
+ResultPage ResultCursors::OpenCursor(CandidateSource source, size_t page_size)
+{
+    auto cursor = std::make_shared<Cursor>();
+    cursor->source = std::move(source);
+    cursor->index_version = search_server_.GetIndexVersion();
+
+    // Курсор ещё не зарегистрирован, и к нему нет доступа из других потоков
+    ResultPage page = TakePage(*cursor, page_size);
+    if(HasMore(*cursor))
+    {
+        page.next_cursor = Register(std::move(cursor));
+    }
+
+    return page;
+}
+
+ResultPage ResultCursors::TakePage(Cursor& cursor, size_t page_size)
+{
+    ResultPage page;
+    page.documents.reserve(std::min(page_size, std::max<size_t>(limits_.max_candidates, 1)));
+    while(page.documents.size() < page_size)
+    {
+        if(cursor.position == cursor.candidates.size())
+        {
+            if(cursor.is_last_window)
+            {
+                break;
+            }
+            FillWindow(cursor);
+            continue;
+        }
+
+        const size_t count = std::min(page_size - page.documents.size(), cursor.candidates.size() - cursor.position);
+        const auto first = cursor.candidates.begin() + cursor.position;
+        page.documents.insert(page.documents.end(), first, first + count);
+        cursor.position += count;
+    }
+
+    page.is_stale = search_server_.GetIndexVersion() != cursor.index_version;
+
+    return page;
+}
+
+bool ResultCursors::HasMore(const Cursor& cursor)
+{
+    return cursor.position < cursor.candidates.size() || !cursor.is_last_window;
+}
+
+void ResultCursors::FillWindow(Cursor& cursor)
+{
+    // Окно запрашивается с одним лишним документом, чтобы заранее знать, закончилась ли выдача
+    const size_t window_size = std::max<size_t>(limits_.max_candidates, 1);
+    std::optional<Document> last;
+    if(!cursor.candidates.empty())
+    {
+        last = cursor.candidates.back();
+    }
+
+    cursor.candidates = cursor.source(last ? &*last : nullptr, window_size + 1);
+    cursor.position = 0;
+    cursor.is_last_window = cursor.candidates.size() <= window_size;
+}
+
+std::string ResultCursors::Register(std::shared_ptr<Cursor> cursor)
+{
+    std::lock_guard guard(mutex_);
+    const auto now = std::chrono::steady_clock::now();
+    RemoveExpired(now);
+    while(!lru_.empty() && cursors_.size() >= limits_.max_open_cursors)
+    {
+        cursors_.erase(lru_.front());
+        lru_.pop_front();
+    }
+
+    std::string token;
+    do
+    {
+        std::ostringstream out;
+        out << std::hex << std::setw(16) << std::setfill('0') << token_generator_();
+        token = out.str();
+    }
+    while(cursors_.count(token) != 0);
+
+    lru_.push_back(token);
+    cursors_[token] = CursorEntry{std::move(cursor), std::prev(lru_.end()), now};
+
+    return token;
+}
+
+void ResultCursors::RemoveExpired(std::chrono::steady_clock::time_point now)
+{
+    while(!lru_.empty())
+    {
+        const auto it = cursors_.find(lru_.front());
+        if(now - it->second.last_access < limits_.idle_timeout)
+        {
+            return;
+        }
+        cursors_.erase(it);
+        lru_.pop_front();
+    }
+}
+
+void ResultCursors::ValidatePageSize(size_t page_size)
+{
+    if(page_size == 0)
+    {
+        throw std::invalid_argument("Размер страницы должен быть положительным"s);
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "search_server.h"
+#include "document.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+// Ограничения открытых курсоров. Память курсора не превышает max_candidates документов
+struct CursorLimits
+{
+    // Размер окна кандидатов, которое курсор держит между страницами
+    size_t max_candidates = 1000;
+    // Сверх этого числа закрывается курсор, к которому дольше всех не обращались
+    size_t max_open_cursors = 1024;
+    // Курсор, к которому не обращались дольше этого времени, закрывается
+    std::chrono::steady_clock::duration idle_timeout = std::chrono::seconds(60);
+};
+
+struct ResultPage
+{
+    std::vector<Document> documents;
+    // Пустой курсор означает, что выдача закончилась
+    std::string next_cursor;
+    // Индекс изменился после открытия курсора: оставшиеся страницы ранжируются по новому индексу
+    bool is_stale = false;
+};
+
+// Курсоры глубокой пагинации. Курсор хранит отсортированное окно лучших кандидатов после уже выданных
+// документов, поэтому очередная страница внутри окна — это срез без повторного выполнения запроса. Когда окно
+// кончается, запрос выполняется снова и отбирает следующие max_candidates документов строго после последнего
+// выданного. Окна упорядочены точным ключом SearchServer::IsRankedStrictlyBefore, поэтому документы
+// не повторяются и не теряются, даже если между страницами менялся индекс.
+// Методы можно вызывать из разных потоков; изменения индекса, как и для SearchServer, синхронизирует вызывающий
+class ResultCursors
+{
+    public:
+        explicit ResultCursors(const SearchServer& search_server, CursorLimits limits = {});
+
+        // Выполняет запрос и возвращает первую страницу. Предикат копируется в курсор и вызывается
+        // при каждом повторном выполнении запроса, пока курсор открыт
+        template <typename Ranker = TfIdfRanker, typename DocumentPredicate>
+        ResultPage Open(const std::string& raw_query, DocumentPredicate document_predicate, size_t page_size);
+        ResultPage Open(const std::string& raw_query, size_t page_size);
+
+        // Следующая страница. Токен курсора не меняется, каждый вызов продвигает курсор; последняя страница
+        // закрывает его. Для неизвестного, закрытого или просроченного курсора бросает out_of_range
+        ResultPage Next(const std::string& cursor, size_t page_size);
+        void Close(const std::string& cursor);
+
+        size_t GetOpenCursorCount() const;
+
+    private:
+        // Следующие count документов после last или с начала выдачи, если last пуст
+        using CandidateSource = std::function<std::vector<Document>(const Document* last, size_t count)>;
+
+        struct Cursor
+        {
+            std::mutex mutex;
+            CandidateSource source;
+            std::vector<Document> candidates;
+            size_t position = 0;
+            // Запрос вернул не больше max_candidates документов, значит, после окна документов нет
+            bool is_last_window = false;
+            uint64_t index_version = 0;
+        };
+
+        struct CursorEntry
+        {
+            std::shared_ptr<Cursor> cursor;
+            std::list<std::string>::iterator lru_position;
+            std::chrono::steady_clock::time_point last_access;
+        };
+
+        const SearchServer& search_server_;
+        const CursorLimits limits_;
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, CursorEntry> cursors_;
+        // От давно не использованных курсоров к недавним
+        std::list<std::string> lru_;
+        std::mt19937_64 token_generator_;
+
+        ResultPage OpenCursor(CandidateSource source, size_t page_size);
+        // TakePage и HasMore вызываются под мьютексом курсора
+        ResultPage TakePage(Cursor& cursor, size_t page_size);
+        static bool HasMore(const Cursor& cursor);
+        void FillWindow(Cursor& cursor);
+        // Регистрирует курсор под новым токеном, вытесняя старые курсоры сверх лимита
+        std::string Register(std::shared_ptr<Cursor> cursor);
+        void RemoveExpired(std::chrono::steady_clock::time_point now);
+        static void ValidatePageSize(size_t page_size);
+};
+
+template <typename Ranker, typename DocumentPredicate>
+ResultPage ResultCursors::Open(const std::string& raw_query, DocumentPredicate document_predicate, size_t page_size)
+{
+    ValidatePageSize(page_size);
+    const SearchServer& search_server = search_server_;
+    CandidateSource source = [&search_server, raw_query, document_predicate](const Document* last, size_t count)
+    {
+        return last == nullptr ? search_server.FindRankedDocuments<Ranker>(raw_query, document_predicate, count)
+                               : search_server.FindRankedDocuments<Ranker>(raw_query, document_predicate, *last, count);
+    };
+
+    return OpenCursor(std::move(source), page_size);
+}
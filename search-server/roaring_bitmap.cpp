@@ -0,0 +1,401 @@
+#include "roaring_bitmap.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+    const size_t BITSET_WORD_COUNT = 65536 / 64;
+
+    uint32_t CountBits(const std::vector<uint64_t>& bitset)
+    {
+        uint32_t count = 0;
+        for(const uint64_t word : bitset)
+        {
+            count += static_cast<uint32_t>(std::bitset<64>(word).count());
+        }
+
+        return count;
+    }
+}
+
+bool RoaringBitmap::Container::IsBitset() const
+{
+    return !bitset.empty();
+}
+
+bool RoaringBitmap::Container::Contains(uint16_t value) const
+{
+    if(IsBitset())
+    {
+        return (bitset[value / 64] >> (value % 64)) & 1;
+    }
+
+    return std::binary_search(array.begin(), array.end(), value);
+}
+
+void RoaringBitmap::Container::ConvertToBitset()
+{
+    bitset.assign(BITSET_WORD_COUNT, 0);
+    for(const uint16_t value : array)
+    {
+        bitset[value / 64] |= uint64_t{1} << (value % 64);
+    }
+
+    array.clear();
+    array.shrink_to_fit();
+}
+
+void RoaringBitmap::Container::ConvertToArray()
+{
+    array.clear();
+    array.reserve(cardinality);
+    for(size_t i = 0; i < bitset.size(); ++i)
+    {
+        for(uint64_t word = bitset[i]; word != 0; word &= word - 1)
+        {
+            const uint64_t lowest = word & (~word + 1);
+            array.push_back(static_cast<uint16_t>(i * 64 + std::bitset<64>(lowest - 1).count()));
+        }
+    }
+
+    bitset.clear();
+    bitset.shrink_to_fit();
+}
+
+void RoaringBitmap::Container::Normalize()
+{
+    if(IsBitset())
+    {
+        cardinality = CountBits(bitset);
+        if(cardinality <= ROARING_ARRAY_MAX_SIZE)
+        {
+            ConvertToArray();
+        }
+    }
+    else
+    {
+        cardinality = static_cast<uint32_t>(array.size());
+        if(cardinality > ROARING_ARRAY_MAX_SIZE)
+        {
+            ConvertToBitset();
+        }
+    }
+}
+
+void RoaringBitmap::Add(uint32_t value)
+{
+    const uint16_t key = static_cast<uint16_t>(value >> 16);
+    const uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+
+    auto it = FindContainer(key);
+    if(it == containers_.end() || it->key != key)
+    {
+        it = containers_.insert(it, Container{});
+        it->key = key;
+    }
+
+    if(it->IsBitset())
+    {
+        uint64_t& word = it->bitset[low / 64];
+        const uint64_t mask = uint64_t{1} << (low % 64);
+        if((word & mask) == 0)
+        {
+            word |= mask;
+            ++it->cardinality;
+        }
+        return;
+    }
+
+    const auto position = std::lower_bound(it->array.begin(), it->array.end(), low);
+    if(position != it->array.end() && *position == low)
+    {
+        return;
+    }
+
+    it->array.insert(position, low);
+    ++it->cardinality;
+    if(it->cardinality > ROARING_ARRAY_MAX_SIZE)
+    {
+        it->ConvertToBitset();
+    }
+}
+
+void RoaringBitmap::Remove(uint32_t value)
+{
+    const uint16_t key = static_cast<uint16_t>(value >> 16);
+    const uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+
+    const auto it = FindContainer(key);
+    if(it == containers_.end() || it->key != key || !it->Contains(low))
+    {
+        return;
+    }
+
+    if(it->IsBitset())
+    {
+        it->bitset[low / 64] &= ~(uint64_t{1} << (low % 64));
+        --it->cardinality;
+        if(it->cardinality <= ROARING_ARRAY_MAX_SIZE)
+        {
+            it->ConvertToArray();
+        }
+    }
+    else
+    {
+        it->array.erase(std::lower_bound(it->array.begin(), it->array.end(), low));
+        --it->cardinality;
+    }
+
+    if(it->cardinality == 0)
+    {
+        containers_.erase(it);
+    }
+}
+
+bool RoaringBitmap::Contains(uint32_t value) const
+{
+    const uint16_t key = static_cast<uint16_t>(value >> 16);
+    const auto it = FindContainer(key);
+
+    return it != containers_.end() && it->key == key && it->Contains(static_cast<uint16_t>(value & 0xFFFF));
+}
+
+size_t RoaringBitmap::Cardinality() const
+{
+    size_t cardinality = 0;
+    for(const Container& container : containers_)
+    {
+        cardinality += container.cardinality;
+    }
+
+    return cardinality;
+}
+
+bool RoaringBitmap::IsEmpty() const
+{
+    return containers_.empty();
+}
+
+size_t RoaringBitmap::GetMemoryUsage() const
+{
+    size_t bytes = containers_.capacity() * sizeof(Container);
+    for(const Container& container : containers_)
+    {
+        bytes += container.array.capacity() * sizeof(uint16_t) + container.bitset.capacity() * sizeof(uint64_t);
+    }
+
+    return bytes;
+}
+
+RoaringBitmap& RoaringBitmap::operator|=(const RoaringBitmap& other)
+{
+    std::vector<Container> result;
+    result.reserve(containers_.size() + other.containers_.size());
+
+    auto lhs = containers_.begin();
+    auto rhs = other.containers_.begin();
+    while(lhs != containers_.end() || rhs != other.containers_.end())
+    {
+        if(rhs == other.containers_.end() || (lhs != containers_.end() && lhs->key < rhs->key))
+        {
+            result.push_back(std::move(*lhs++));
+        }
+        else if(lhs == containers_.end() || rhs->key < lhs->key)
+        {
+            result.push_back(*rhs++);
+        }
+        else
+        {
+            Unite(*lhs, *rhs++);
+            result.push_back(std::move(*lhs++));
+        }
+    }
+
+    containers_ = std::move(result);
+    return *this;
+}
+
+RoaringBitmap& RoaringBitmap::operator&=(const RoaringBitmap& other)
+{
+    std::vector<Container> result;
+
+    auto rhs = other.containers_.begin();
+    for(Container& container : containers_)
+    {
+        while(rhs != other.containers_.end() && rhs->key < container.key)
+        {
+            ++rhs;
+        }
+        if(rhs == other.containers_.end())
+        {
+            break;
+        }
+        if(rhs->key == container.key)
+        {
+            Intersect(container, *rhs);
+            if(container.cardinality > 0)
+            {
+                result.push_back(std::move(container));
+            }
+        }
+    }
+
+    containers_ = std::move(result);
+    return *this;
+}
+
+RoaringBitmap& RoaringBitmap::operator-=(const RoaringBitmap& other)
+{
+    std::vector<Container> result;
+    result.reserve(containers_.size());
+
+    auto rhs = other.containers_.begin();
+    for(Container& container : containers_)
+    {
+        while(rhs != other.containers_.end() && rhs->key < container.key)
+        {
+            ++rhs;
+        }
+        if(rhs != other.containers_.end() && rhs->key == container.key)
+        {
+            Subtract(container, *rhs);
+        }
+        if(container.cardinality > 0)
+        {
+            result.push_back(std::move(container));
+        }
+    }
+
+    containers_ = std::move(result);
+    return *this;
+}
+
+std::vector<uint32_t> RoaringBitmap::ToVector() const
+{
+    std::vector<uint32_t> values;
+    values.reserve(Cardinality());
+    ForEach([&values](uint32_t value) {
+        values.push_back(value);
+    });
+
+    return values;
+}
+
+std::vector<RoaringBitmap::Container>::iterator RoaringBitmap::FindContainer(uint16_t key)
+{
+    return std::lower_bound(containers_.begin(), containers_.end(), key, [](const Container& container, uint16_t value) {
+        return container.key < value;
+    });
+}
+
+std::vector<RoaringBitmap::Container>::const_iterator RoaringBitmap::FindContainer(uint16_t key) const
+{
+    return std::lower_bound(containers_.begin(), containers_.end(), key, [](const Container& container, uint16_t value) {
+        return container.key < value;
+    });
+}
+
+void RoaringBitmap::Unite(Container& lhs, const Container& rhs)
+{
+    if(!lhs.IsBitset() && !rhs.IsBitset())
+    {
+        std::vector<uint16_t> united;
+        united.reserve(lhs.array.size() + rhs.array.size());
+        std::set_union(lhs.array.begin(), lhs.array.end(), rhs.array.begin(), rhs.array.end(), std::back_inserter(united));
+        lhs.array = std::move(united);
+    }
+    else
+    {
+        if(!lhs.IsBitset())
+        {
+            lhs.ConvertToBitset();
+        }
+
+        if(rhs.IsBitset())
+        {
+            for(size_t i = 0; i < BITSET_WORD_COUNT; ++i)
+            {
+                lhs.bitset[i] |= rhs.bitset[i];
+            }
+        }
+        else
+        {
+            for(const uint16_t value : rhs.array)
+            {
+                lhs.bitset[value / 64] |= uint64_t{1} << (value % 64);
+            }
+        }
+    }
+
+    lhs.Normalize();
+}
+
+void RoaringBitmap::Intersect(Container& lhs, const Container& rhs)
+{
+    if(lhs.IsBitset() && rhs.IsBitset())
+    {
+        for(size_t i = 0; i < BITSET_WORD_COUNT; ++i)
+        {
+            lhs.bitset[i] &= rhs.bitset[i];
+        }
+    }
+    else if(lhs.IsBitset())
+    {
+        std::vector<uint16_t> intersected;
+        std::copy_if(rhs.array.begin(), rhs.array.end(), std::back_inserter(intersected), [&lhs](uint16_t value) {
+            return lhs.Contains(value);
+        });
+        lhs.bitset.clear();
+        lhs.array = std::move(intersected);
+    }
+    else
+    {
+        lhs.array.erase(std::remove_if(lhs.array.begin(), lhs.array.end(), [&rhs](uint16_t value) {
+            return !rhs.Contains(value);
+        }), lhs.array.end());
+    }
+
+    lhs.Normalize();
+}
+
+void RoaringBitmap::Subtract(Container& lhs, const Container& rhs)
+{
+    if(lhs.IsBitset() && rhs.IsBitset())
+    {
+        for(size_t i = 0; i < BITSET_WORD_COUNT; ++i)
+        {
+            lhs.bitset[i] &= ~rhs.bitset[i];
+        }
+    }
+    else if(lhs.IsBitset())
+    {
+        for(const uint16_t value : rhs.array)
+        {
+            lhs.bitset[value / 64] &= ~(uint64_t{1} << (value % 64));
+        }
+    }
+    else
+    {
+        lhs.array.erase(std::remove_if(lhs.array.begin(), lhs.array.end(), [&rhs](uint16_t value) {
+            return rhs.Contains(value);
+        }), lhs.array.end());
+    }
+
+    lhs.Normalize();
+}
+
+RoaringBitmap operator|(RoaringBitmap lhs, const RoaringBitmap& rhs)
+{
+    return lhs |= rhs;
+}
+
+RoaringBitmap operator&(RoaringBitmap lhs, const RoaringBitmap& rhs)
+{
+    return lhs &= rhs;
+}
+
+RoaringBitmap operator-(RoaringBitmap lhs, const RoaringBitmap& rhs)
+{
+    return lhs -= rhs;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <bitset>
+
+// Контейнер с числом элементов больше ROARING_ARRAY_MAX_SIZE хранится битовой картой
+const size_t ROARING_ARRAY_MAX_SIZE = 4096;
+
+// Сжатое множество 32-битных чисел по схеме Roaring: числа делятся на блоки по старшим 16 битам,
+// младшие 16 бит блока хранятся отсортированным массивом или битовой картой на 65536 бит
+class RoaringBitmap
+{
+    public:
+        void Add(uint32_t value);
+        void Remove(uint32_t value);
+        bool Contains(uint32_t value) const;
+
+        size_t Cardinality() const;
+        bool IsEmpty() const;
+        size_t GetMemoryUsage() const;
+
+        RoaringBitmap& operator|=(const RoaringBitmap& other);
+        RoaringBitmap& operator&=(const RoaringBitmap& other);
+        RoaringBitmap& operator-=(const RoaringBitmap& other);
+
+        template <typename Function>
+        void ForEach(Function function) const;
+        // Обходит числа из [first, last) по возрастанию, пропуская контейнеры вне диапазона
+        template <typename Function>
+        void ForEachInRange(uint64_t first, uint64_t last, Function function) const;
+
+        std::vector<uint32_t> ToVector() const;
+
+    private:
+        struct Container
+        {
+            uint16_t key = 0;
+            uint32_t cardinality = 0;
+            std::vector<uint16_t> array;
+            std::vector<uint64_t> bitset;
+
+            bool IsBitset() const;
+            bool Contains(uint16_t value) const;
+            void ConvertToBitset();
+            void ConvertToArray();
+            void Normalize();
+        };
+
+        std::vector<Container> containers_;
+
+        std::vector<Container>::iterator FindContainer(uint16_t key);
+        std::vector<Container>::const_iterator FindContainer(uint16_t key) const;
+
+        static void Unite(Container& lhs, const Container& rhs);
+        static void Intersect(Container& lhs, const Container& rhs);
+        static void Subtract(Container& lhs, const Container& rhs);
+};
+
+RoaringBitmap operator|(RoaringBitmap lhs, const RoaringBitmap& rhs);
+RoaringBitmap operator&(RoaringBitmap lhs, const RoaringBitmap& rhs);
+RoaringBitmap operator-(RoaringBitmap lhs, const RoaringBitmap& rhs);
+
+template <typename Function>
+void RoaringBitmap::ForEach(Function function) const
+{
+    for(const Container& container : containers_)
+    {
+        const uint32_t high = static_cast<uint32_t>(container.key) << 16;
+
+        if(!container.IsBitset())
+        {
+            for(const uint16_t value : container.array)
+            {
+                function(high | value);
+            }
+            continue;
+        }
+
+        for(size_t i = 0; i < container.bitset.size(); ++i)
+        {
+            uint64_t word = container.bitset[i];
+            while(word != 0)
+            {
+                const uint64_t lowest = word & (~word + 1);
+                const uint32_t bit = static_cast<uint32_t>(std::bitset<64>(lowest - 1).count());
+                function(high | static_cast<uint32_t>(i * 64 + bit));
+                word ^= lowest;
+            }
+        }
+    }
+}
+
+template <typename Function>
+void RoaringBitmap::ForEachInRange(uint64_t first, uint64_t last, Function function) const
+{
+    if(first >= last)
+    {
+        return;
+    }
+
+    auto it = std::lower_bound(containers_.begin(), containers_.end(), first >> 16, [](const Container& container, uint64_t key) {
+        return container.key < key;
+    });
+    for(; it != containers_.end() && (uint64_t{it->key} << 16) < last; ++it)
+    {
+        const uint64_t high = uint64_t{it->key} << 16;
+        const uint32_t low_first = first > high ? static_cast<uint32_t>(first - high) : 0;
+        const uint32_t low_last = static_cast<uint32_t>(std::min<uint64_t>(last - high, 65536));
+
+        if(!it->IsBitset())
+        {
+            for(auto value = std::lower_bound(it->array.begin(), it->array.end(), low_first); value != it->array.end() && *value < low_last; ++value)
+            {
+                function(static_cast<uint32_t>(high) | *value);
+            }
+            continue;
+        }
+
+        for(uint32_t i = low_first / 64; i * 64 < low_last; ++i)
+        {
+            uint64_t word = it->bitset[i];
+            if(i * 64 < low_first)
+            {
+                word &= ~uint64_t{0} << (low_first % 64);
+            }
+            if((i + 1) * 64 > low_last)
+            {
+                word &= (uint64_t{1} << (low_last % 64)) - 1;
+            }
+
+            while(word != 0)
+            {
+                const uint64_t lowest = word & (~word + 1);
+                const uint32_t bit = static_cast<uint32_t>(std::bitset<64>(lowest - 1).count());
+                function(static_cast<uint32_t>(high) | (i * 64 + bit));
+                word ^= lowest;
+            }
+        }
+    }
+}
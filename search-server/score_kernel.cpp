@@ -0,0 +1,216 @@
+#include "score_kernel.h"
+#include "posting_list.h"
+
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SCORE_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+using namespace std::literals;
+
+namespace
+{
+    void ScaleScalar(const double* term_freqs, size_t count, double factor, double* out)
+    {
+        for(size_t i = 0; i < count; ++i)
+        {
+            out[i] = term_freqs[i] * factor;
+        }
+    }
+
+    void ScaleHalfScalar(const uint16_t* half_term_freqs, size_t count, double factor, double* out)
+    {
+        for(size_t i = 0; i < count; ++i)
+        {
+            out[i] = DecodeFloat16(half_term_freqs[i]) * factor;
+        }
+    }
+
+#ifdef SCORE_KERNEL_X86
+    __attribute__((target("avx2")))
+    void ScaleAvx2(const double* term_freqs, size_t count, double factor, double* out)
+    {
+        const __m256d factors = _mm256_set1_pd(factor);
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(term_freqs + i), factors));
+        }
+        ScaleScalar(term_freqs + i, count - i, factor, out + i);
+    }
+
+    __attribute__((target("avx2,f16c")))
+    void ScaleHalfAvx2(const uint16_t* half_term_freqs, size_t count, double factor, double* out)
+    {
+        const __m256d factors = _mm256_set1_pd(factor);
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            const __m256 values = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(half_term_freqs + i)));
+            _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(values)), factors));
+            _mm256_storeu_pd(out + i + 4, _mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(values, 1)), factors));
+        }
+        ScaleHalfScalar(half_term_freqs + i, count - i, factor, out + i);
+    }
+
+    __attribute__((target("avx512f")))
+    void ScaleAvx512(const double* term_freqs, size_t count, double factor, double* out)
+    {
+        const __m512d factors = _mm512_set1_pd(factor);
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            _mm512_storeu_pd(out + i, _mm512_mul_pd(_mm512_loadu_pd(term_freqs + i), factors));
+        }
+        ScaleScalar(term_freqs + i, count - i, factor, out + i);
+    }
+
+    __attribute__((target("avx512f,f16c")))
+    void ScaleHalfAvx512(const uint16_t* half_term_freqs, size_t count, double factor, double* out)
+    {
+        const __m512d factors = _mm512_set1_pd(factor);
+        size_t i = 0;
+        for(; i + 16 <= count; i += 16)
+        {
+            const __m256 low = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(half_term_freqs + i)));
+            const __m256 high = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(half_term_freqs + i + 8)));
+            // Форма с маской и полной маской 0xFF — та же инструкция без неопределённого регистра-источника
+            _mm512_storeu_pd(out + i, _mm512_mul_pd(_mm512_maskz_cvtps_pd(0xFF, low), factors));
+            _mm512_storeu_pd(out + i + 8, _mm512_mul_pd(_mm512_maskz_cvtps_pd(0xFF, high), factors));
+        }
+        ScaleHalfScalar(half_term_freqs + i, count - i, factor, out + i);
+    }
+#endif
+
+    SimdLevel DetectSupportedSimdLevel()
+    {
+#ifdef SCORE_KERNEL_X86
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("f16c"))
+        {
+            return SimdLevel::AVX512;
+        }
+        if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c"))
+        {
+            return SimdLevel::AVX2;
+        }
+#endif
+        return SimdLevel::SCALAR;
+    }
+}
+
+SimdLevel DetectSimdLevel()
+{
+    static const SimdLevel level = DetectSupportedSimdLevel();
+    return level;
+}
+
+std::string_view GetSimdLevelName(SimdLevel level)
+{
+    switch(level)
+    {
+        case SimdLevel::AVX2:
+            return "AVX2"sv;
+        case SimdLevel::AVX512:
+            return "AVX-512"sv;
+        default:
+            return "scalar"sv;
+    }
+}
+
+void ScaleTermFreqs(SimdLevel level, const double* term_freqs, size_t count, double factor, double* out)
+{
+    switch(std::min(level, DetectSimdLevel()))
+    {
+#ifdef SCORE_KERNEL_X86
+        case SimdLevel::AVX512:
+            ScaleAvx512(term_freqs, count, factor, out);
+            return;
+        case SimdLevel::AVX2:
+            ScaleAvx2(term_freqs, count, factor, out);
+            return;
+#endif
+        default:
+            ScaleScalar(term_freqs, count, factor, out);
+    }
+}
+
+void ScaleTermFreqs(SimdLevel level, const uint16_t* half_term_freqs, size_t count, double factor, double* out)
+{
+    switch(std::min(level, DetectSimdLevel()))
+    {
+#ifdef SCORE_KERNEL_X86
+        case SimdLevel::AVX512:
+            ScaleHalfAvx512(half_term_freqs, count, factor, out);
+            return;
+        case SimdLevel::AVX2:
+            ScaleHalfAvx2(half_term_freqs, count, factor, out);
+            return;
+#endif
+        default:
+            ScaleHalfScalar(half_term_freqs, count, factor, out);
+    }
+}
+
+ScoreBuffer::ScoreBuffer(int max_document_id) : blocks_(max_document_id < 0 ? 0 : max_document_id / SCORE_BLOCK_SIZE + 1)
+{
+}
+
+void ScoreBuffer::Add(int document_id, double score)
+{
+    Block& block = GetBlock(document_id);
+    const int offset = document_id % SCORE_BLOCK_SIZE;
+    block.scores[offset] += score;
+    block.touched[offset / 64] |= uint64_t{1} << (offset % 64);
+}
+
+void ScoreBuffer::Add(const int* document_ids, const double* scores, size_t count)
+{
+    Block* block = nullptr;
+    int block_index = -1;
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        // Постинги отсортированы, поэтому блок меняется редко
+        if(document_ids[i] / SCORE_BLOCK_SIZE != block_index)
+        {
+            block_index = document_ids[i] / SCORE_BLOCK_SIZE;
+            block = &GetBlock(document_ids[i]);
+        }
+
+        const int offset = document_ids[i] % SCORE_BLOCK_SIZE;
+        block->scores[offset] += scores[i];
+        block->touched[offset / 64] |= uint64_t{1} << (offset % 64);
+    }
+}
+
+int ScoreBuffer::GetBlockCount() const
+{
+    return static_cast<int>(blocks_.size());
+}
+
+ScoreBuffer::Block& ScoreBuffer::GetBlock(int document_id)
+{
+    std::unique_ptr<Block>& block = blocks_[document_id / SCORE_BLOCK_SIZE];
+    if(!block)
+    {
+        block = std::make_unique<Block>();
+    }
+
+    return *block;
+}
+
+void SparseScoreBuffer::Add(int document_id, double score)
+{
+    scores_[document_id] += score;
+}
+
+void SparseScoreBuffer::Add(const int* document_ids, const double* scores, size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        scores_[document_ids[i]] += scores[i];
+    }
+}
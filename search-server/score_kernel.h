@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Постинги обрабатываются кусками по SCORE_KERNEL_CHUNK_SIZE: вклады считаются векторным ядром, затем прибавляются к буферу
+const size_t SCORE_KERNEL_CHUNK_SIZE = 256;
+// Число документов в блоке буфера релевантности, кратно 64
+const int SCORE_BLOCK_SIZE = 1024;
+
+// Набор инструкций ядра. Лучший доступный определяется по процессору один раз при первом вызове
+enum class SimdLevel
+{
+    SCALAR,
+    AVX2,
+    AVX512,
+};
+
+SimdLevel DetectSimdLevel();
+std::string_view GetSimdLevelName(SimdLevel level);
+
+// Ядра считают out[i] = factor * term_freqs[i]. Уровень выше доступного понижается до доступного
+void ScaleTermFreqs(SimdLevel level, const double* term_freqs, size_t count, double factor, double* out);
+void ScaleTermFreqs(SimdLevel level, const uint16_t* half_term_freqs, size_t count, double factor, double* out);
+
+// Плотный буфер релевантности по id документа, разбитый на блоки. Блок выделяется при первом касании.
+// Разные блоки можно заполнять из разных потоков
+class ScoreBuffer
+{
+    public:
+        explicit ScoreBuffer(int max_document_id);
+
+        void Add(int document_id, double score);
+        // Прибавляет scores[i] к документу document_ids[i]
+        void Add(const int* document_ids, const double* scores, size_t count);
+
+        int GetBlockCount() const;
+
+        // Обходит документы, получившие вклад, в порядке возрастания id
+        template <typename Function>
+        void ForEach(Function function) const;
+        template <typename Function>
+        void ForEach(int first_block, int last_block, Function function) const;
+
+    private:
+        struct Block
+        {
+            std::array<double, SCORE_BLOCK_SIZE> scores{};
+            std::array<uint64_t, SCORE_BLOCK_SIZE / 64> touched{};
+        };
+
+        std::vector<std::unique_ptr<Block>> blocks_;
+
+        Block& GetBlock(int document_id);
+};
+
+// Разреженный буфер релевантности для редких id, когда каталог блоков ScoreBuffer был бы больше самих документов.
+// Не потокобезопасен: параллельный запрос заводит свой буфер на каждую часть пространства id
+class SparseScoreBuffer
+{
+    public:
+        void Add(int document_id, double score);
+        void Add(const int* document_ids, const double* scores, size_t count);
+
+        // Обходит документы, получившие вклад, в произвольном порядке
+        template <typename Function>
+        void ForEach(Function function) const;
+
+    private:
+        std::unordered_map<int, double> scores_;
+};
+
+template <typename Function>
+void ScoreBuffer::ForEach(Function function) const
+{
+    ForEach(0, GetBlockCount(), function);
+}
+
+template <typename Function>
+void ScoreBuffer::ForEach(int first_block, int last_block, Function function) const
+{
+    for(int block_index = first_block; block_index < last_block; ++block_index)
+    {
+        const Block* block = blocks_[block_index].get();
+        if(block == nullptr)
+        {
+            continue;
+        }
+
+        for(size_t word_index = 0; word_index < block->touched.size(); ++word_index)
+        {
+            for(uint64_t word = block->touched[word_index]; word != 0; word &= word - 1)
+            {
+                const int offset = static_cast<int>(word_index * 64) + static_cast<int>(std::bitset<64>((word & (~word + 1)) - 1).count());
+                function(block_index * SCORE_BLOCK_SIZE + offset, block->scores[offset]);
+            }
+        }
+    }
+}
+
+template <typename Function>
+void SparseScoreBuffer::ForEach(Function function) const
+{
+    for(const auto& [document_id, score] : scores_)
+    {
+        function(document_id, score);
+    }
+}
@@ -1,7 +1,91 @@
 #include "search_server.h"
 
+#include <exception>
+#include <queue>
+#include <unordered_map>
+
 using namespace std::literals;
 
+namespace
+{
+    // Частичный индекс части корпуса для BuildIndex. Слова указывают в тексты документов или в buffers
+    struct PartialIndex
+    {
+        struct Posting
+        {
+            int document_id;
+            double term_freq;
+        };
+
+        size_t first_document = 0;
+        size_t last_document = 0;
+        std::deque<std::string> buffers;
+        std::unordered_map<std::string_view, uint32_t> term_ids;
+        // Слова, постинги и позиции по локальному идентификатору слова
+        std::vector<std::string_view> words;
+        std::vector<std::vector<Posting>> postings;
+        std::vector<std::vector<std::pair<int, std::vector<int>>>> positions;
+        // Локальные идентификаторы слов документов части в порядке слов и длины документов
+        std::vector<std::vector<uint32_t>> document_terms;
+        std::vector<uint32_t> document_lengths;
+        // Локальные идентификаторы в порядке слов и их глобальные идентификаторы, которые при этом тоже возрастают
+        std::vector<uint32_t> sorted_terms;
+        std::vector<uint32_t> global_ids;
+        std::exception_ptr error;
+
+        void AddDocument(int document_id, const std::vector<std::string_view>& document_words, bool with_positions)
+        {
+            std::vector<uint32_t>& terms = document_terms.emplace_back();
+            terms.reserve(document_words.size());
+            document_lengths.push_back(static_cast<uint32_t>(document_words.size()));
+            for(size_t position = 0; position < document_words.size(); ++position)
+            {
+                const auto [it, is_new] = term_ids.try_emplace(document_words[position], static_cast<uint32_t>(words.size()));
+                if(is_new)
+                {
+                    words.push_back(document_words[position]);
+                    postings.emplace_back();
+                    positions.emplace_back();
+                }
+                terms.push_back(it->second);
+
+                if(with_positions)
+                {
+                    auto& term_positions = positions[it->second];
+                    if(term_positions.empty() || term_positions.back().first != document_id)
+                    {
+                        term_positions.emplace_back(document_id, std::vector<int>());
+                    }
+                    term_positions.back().second.push_back(static_cast<int>(position));
+                }
+            }
+
+            std::vector<uint32_t> sorted_document_terms = terms;
+            std::sort(sorted_document_terms.begin(), sorted_document_terms.end());
+            const double inv_word_count = 1.0 / document_words.size();
+            for(auto it = sorted_document_terms.begin(); it != sorted_document_terms.end();)
+            {
+                const auto run_end = std::upper_bound(it, sorted_document_terms.end(), *it);
+                postings[*it].push_back({document_id, (run_end - it) * inv_word_count});
+                it = run_end;
+            }
+        }
+    };
+
+    template <typename Container, typename Function>
+    void ForEachItem(bool is_parallel, Container& items, Function function)
+    {
+        if(is_parallel)
+        {
+            std::for_each(std::execution::par, items.begin(), items.end(), function);
+        }
+        else
+        {
+            std::for_each(items.begin(), items.end(), function);
+        }
+    }
+}
+
 SearchServer::SearchServer()
 {
 }
@@ -14,143 +98,1306 @@ SearchServer::SearchServer(std::string_view stop_words_text) : SearchServer(Spli
 {
 }
 
-void SearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings)
+void SearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings)
+{
+    ValidateNewDocument(document_id, document);
+
+    std::string buffer;
+    IndexDocument(document_id, SplitIntoWordsNoStop(document, buffer), status, ratings);
+    ++index_version_;
+    CountAddedDocuments(1);
+}
+
+void SearchServer::AddDocuments(const std::vector<DocumentRecord>& documents)
+{
+    struct TokenizedDocument
+    {
+        std::string buffer;
+        std::vector<std::string_view> words;
+    };
+
+    // Слова указывают в buffer своего документа, поэтому элементы заполняются на месте
+    std::vector<TokenizedDocument> tokenized(documents.size());
+    const auto tokenize = [this, &documents, &tokenized](const DocumentRecord& document) {
+        TokenizedDocument& result = tokenized[&document - documents.data()];
+        result.words = SplitIntoWordsNoStop(document.text, result.buffer);
+    };
+
+    if(documents.size() >= execution_thresholds_.parallel_document_count)
+    {
+        std::for_each(std::execution::par, documents.begin(), documents.end(), tokenize);
+    }
+    else
+    {
+        std::for_each(documents.begin(), documents.end(), tokenize);
+    }
+
+    for(size_t i = 0; i < documents.size(); ++i)
+    {
+        ValidateNewDocument(documents[i].id, documents[i].text);
+        IndexDocument(documents[i].id, tokenized[i].words, documents[i].status, documents[i].ratings);
+        ++index_version_;
+        CountAddedDocuments(1);
+    }
+}
+
+void SearchServer::BuildIndex(const std::vector<DocumentRecord>& documents, size_t partition_count)
+{
+    if(!documents_.empty() || !words_.empty())
+    {
+        throw std::logic_error("Построение индекса доступно только для пустого сервера.");
+    }
+
+    // Части — непрерывные диапазоны id, поэтому постинги частей, взятые по порядку частей, уже отсортированы по id
+    std::vector<const DocumentRecord*> sorted_documents(documents.size());
+    std::transform(documents.begin(), documents.end(), sorted_documents.begin(), [](const DocumentRecord& document) { return &document; });
+    std::sort(sorted_documents.begin(), sorted_documents.end(), [](const DocumentRecord* lhs, const DocumentRecord* rhs) { return lhs->id < rhs->id; });
+    if(std::adjacent_find(sorted_documents.begin(), sorted_documents.end(), [](const DocumentRecord* lhs, const DocumentRecord* rhs) {
+           return lhs->id == rhs->id;
+       }) != sorted_documents.end())
+    {
+        throw std::invalid_argument("Попытка добавить документ c id ранее добавленного документа.");
+    }
+
+    const bool is_parallel = documents.size() >= execution_thresholds_.parallel_document_count;
+    // Слэбовый ресурс однопоточный, поэтому с ним контейнеры индекса заполняются в одном потоке
+    const bool is_parallel_merge = is_parallel && index_allocator_ == IndexAllocator::DEFAULT;
+    if(partition_count == 0)
+    {
+        partition_count = is_parallel ? std::max(std::thread::hardware_concurrency(), 1u) : 1;
+    }
+    partition_count = std::clamp<size_t>(partition_count, 1, std::max<size_t>(documents.size(), 1));
+
+    std::vector<PartialIndex> partitions(partition_count);
+    for(size_t i = 0; i < partition_count; ++i)
+    {
+        partitions[i].first_document = documents.size() * i / partition_count;
+        partitions[i].last_document = documents.size() * (i + 1) / partition_count;
+    }
+
+    ForEachItem(is_parallel, partitions, [this, &sorted_documents](PartialIndex& partition) {
+        try
+        {
+            partition.document_terms.reserve(partition.last_document - partition.first_document);
+            partition.document_lengths.reserve(partition.last_document - partition.first_document);
+            for(size_t i = partition.first_document; i < partition.last_document; ++i)
+            {
+                const DocumentRecord& document = *sorted_documents[i];
+                ValidateNewDocument(document.id, document.text);
+                partition.AddDocument(document.id, SplitIntoWordsNoStop(document.text, partition.buffers.emplace_back()), positional_index_enabled_);
+            }
+        }
+        catch(...)
+        {
+            partition.error = std::current_exception();
+        }
+
+        partition.sorted_terms.resize(partition.words.size());
+        std::iota(partition.sorted_terms.begin(), partition.sorted_terms.end(), 0);
+        std::sort(partition.sorted_terms.begin(), partition.sorted_terms.end(), [&partition](uint32_t lhs, uint32_t rhs) {
+            return partition.words[lhs] < partition.words[rhs];
+        });
+        partition.global_ids.resize(partition.sorted_terms.size());
+    });
+    for(const PartialIndex& partition : partitions)
+    {
+        if(partition.error)
+        {
+            std::rethrow_exception(partition.error);
+        }
+    }
+
+    // k-путевое слияние отсортированных словарей частей. Глобальные идентификаторы выдаются в порядке слов
+    using Head = std::pair<std::string_view, size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<>> heads;
+    std::vector<size_t> positions(partition_count, 0);
+    for(size_t i = 0; i < partition_count; ++i)
+    {
+        if(!partitions[i].sorted_terms.empty())
+        {
+            heads.emplace(partitions[i].words[partitions[i].sorted_terms[0]], i);
+        }
+    }
+    while(!heads.empty())
+    {
+        const auto [word, partition_index] = heads.top();
+        heads.pop();
+        if(term_words_.empty() || term_words_.back() != word)
+        {
+            const auto it = words_.emplace_hint(words_.end(), word, static_cast<uint32_t>(term_words_.size()));
+            term_words_.push_back(it->first);
+        }
+
+        PartialIndex& partition = partitions[partition_index];
+        size_t& position = positions[partition_index];
+        partition.global_ids[position] = static_cast<uint32_t>(term_words_.size() - 1);
+        if(++position < partition.sorted_terms.size())
+        {
+            heads.emplace(partition.words[partition.sorted_terms[position]], partition_index);
+        }
+    }
+    term_dictionary_.reset();
+
+    // Узлы деревьев создаются в одном потоке, а постинги и позиции заполняются параллельно по диапазонам слов
+    const size_t term_count = term_words_.size();
+    std::vector<PostingList*> posting_lists;
+    std::vector<std::pmr::map<int, std::pmr::vector<int>>*> position_lists;
+    posting_lists.reserve(term_count);
+    for(const std::string_view word : term_words_)
+    {
+        posting_lists.push_back(&word_to_document_freqs_.emplace_hint(word_to_document_freqs_.end(), word, term_freq_precision_)->second);
+        if(positional_index_enabled_)
+        {
+            position_lists.push_back(&word_to_document_positions_.emplace_hint(word_to_document_positions_.end(), std::piecewise_construct,
+                                                                               std::forward_as_tuple(word), std::forward_as_tuple())->second);
+        }
+    }
+
+    std::vector<size_t> term_ranges(is_parallel_merge ? partition_count * 4 : 1);
+    std::iota(term_ranges.begin(), term_ranges.end(), 0);
+    ForEachItem(is_parallel_merge, term_ranges, [&](size_t range) {
+        const uint32_t first_term = static_cast<uint32_t>(term_count * range / term_ranges.size());
+        const uint32_t last_term = static_cast<uint32_t>(term_count * (range + 1) / term_ranges.size());
+
+        std::vector<size_t> posting_counts(last_term - first_term, 0);
+        for(const PartialIndex& partition : partitions)
+        {
+            const auto first = std::lower_bound(partition.global_ids.begin(), partition.global_ids.end(), first_term);
+            for(auto it = first; it != partition.global_ids.end() && *it < last_term; ++it)
+            {
+                posting_counts[*it - first_term] += partition.postings[partition.sorted_terms[it - partition.global_ids.begin()]].size();
+            }
+        }
+        for(uint32_t term = first_term; term < last_term; ++term)
+        {
+            posting_lists[term]->Reserve(posting_counts[term - first_term]);
+        }
+
+        for(const PartialIndex& partition : partitions)
+        {
+            const auto first = std::lower_bound(partition.global_ids.begin(), partition.global_ids.end(), first_term);
+            for(auto it = first; it != partition.global_ids.end() && *it < last_term; ++it)
+            {
+                const uint32_t local_term = partition.sorted_terms[it - partition.global_ids.begin()];
+                PostingList& postings = *posting_lists[*it];
+                for(const PartialIndex::Posting& posting : partition.postings[local_term])
+                {
+                    postings.Insert(posting.document_id, posting.term_freq);
+                }
+
+                if(positional_index_enabled_)
+                {
+                    auto& document_positions = *position_lists[*it];
+                    for(const auto& [document_id, term_positions] : partition.positions[local_term])
+                    {
+                        document_positions.emplace_hint(document_positions.end(), std::piecewise_construct, std::forward_as_tuple(document_id),
+                                                        std::forward_as_tuple(term_positions.begin(), term_positions.end()));
+                    }
+                }
+            }
+        }
+    });
+
+    // Прямой индекс переводится на глобальные идентификаторы слов
+    std::vector<std::vector<TermCounts>> forward_indexes(partition_count);
+    ForEachItem(is_parallel_merge, partitions, [this, &partitions, &forward_indexes](PartialIndex& partition) {
+        std::vector<uint32_t> local_to_global(partition.words.size());
+        for(size_t i = 0; i < partition.sorted_terms.size(); ++i)
+        {
+            local_to_global[partition.sorted_terms[i]] = partition.global_ids[i];
+        }
+
+        std::vector<TermCounts>& forward_index = forward_indexes[&partition - partitions.data()];
+        forward_index.reserve(partition.document_terms.size());
+        for(std::vector<uint32_t>& terms : partition.document_terms)
+        {
+            for(uint32_t& term : terms)
+            {
+                term = local_to_global[term];
+            }
+            forward_index.push_back(MakeTermCounts(std::move(terms), &forward_index_memory_));
+        }
+    });
+
+    for(size_t i = 0; i < partition_count; ++i)
+    {
+        for(size_t j = 0; j < forward_indexes[i].size(); ++j)
+        {
+            const DocumentRecord& document = *sorted_documents[partitions[i].first_document + j];
+            const uint32_t length = partitions[i].document_lengths[j];
+            document_terms_.emplace_hint(document_terms_.end(), document.id, std::move(forward_indexes[i][j]));
+
+            const auto document_it = documents_.emplace_hint(documents_.end(), document.id, DocumentData{ComputeAverageRating(document.ratings), document.status, length});
+            status_to_documents_[document.status].Add(document.id);
+            rating_to_documents_[document_it->second.rating].Add(document.id);
+            document_ids_.emplace_hint(document_ids_.end(), document.id);
+            total_document_length_ += length;
+        }
+    }
+    index_version_ += documents.size();
+    CountAddedDocuments(documents.size());
+}
+
+void SearchServer::IndexDocument(int document_id, const std::vector<std::string_view>& words, DocumentStatus status, const std::vector<int>& ratings)
+{
+    const double inv_word_count = 1.0 / words.size();
+
+    std::vector<uint32_t> term_ids;
+    term_ids.reserve(words.size());
+
+    for(size_t position = 0; position < words.size(); ++position)
+    {
+        auto it = words_.find(words[position]);
+        if(it == words_.end())
+        {
+            it = words_.emplace(words[position], static_cast<uint32_t>(term_words_.size())).first;
+            term_words_.push_back(it->first);
+            term_dictionary_.reset();
+        }
+        term_ids.push_back(it->second);
+
+        if(positional_index_enabled_)
+        {
+            word_to_document_positions_[it->first][document_id].push_back(static_cast<int>(position));
+        }
+    }
+
+    const auto [terms_it, _] = document_terms_.emplace(document_id, MakeTermCounts(std::move(term_ids), &forward_index_memory_));
+    for(const TermCount& term : terms_it->second)
+    {
+        word_to_document_freqs_.try_emplace(term_words_[term.term_id], term_freq_precision_).first->second.Insert(document_id, term.count * inv_word_count);
+    }
+
+    const auto document_it = documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status, static_cast<uint32_t>(words.size())}).first;
+    status_to_documents_[status].Add(document_id);
+    rating_to_documents_[document_it->second.rating].Add(document_id);
+    total_document_length_ += words.size();
+    document_ids_.insert(document_id);
+}
+
+void SearchServer::SetStopWords(std::string_view stop_words_text)
+{
+    std::string stop_words(stop_words_text);
+    for(const std::pmr::string& word : stop_words_)
+    {
+        stop_words.push_back(' ');
+        stop_words += word;
+    }
+
+    ChangeStopWords(stop_words);
+    RebuildStopWords();
+}
+
+void SearchServer::ChangeStopWords(std::string_view stop_words_text, DocumentTextSource text_source)
+{
+    RebuildStopWords();
+
+    std::pmr::set<std::pmr::string, std::less<>> new_stop_words;
+    std::string buffer;
+    for(std::string_view word : SplitIntoWords(stop_words_text))
+    {
+        ValidateStopWord(word);
+        for(std::string_view normalized_word : tokenizer_.Tokenize(word, buffer))
+        {
+            new_stop_words.emplace(normalized_word);
+        }
+    }
+
+    std::vector<std::string_view> added_words;
+    std::set_difference(new_stop_words.begin(), new_stop_words.end(), stop_words_.begin(), stop_words_.end(), std::back_inserter(added_words), std::less<>());
+    const bool has_removed_words = !std::includes(new_stop_words.begin(), new_stop_words.end(), stop_words_.begin(), stop_words_.end(), std::less<>());
+
+    // Слова, переставшие быть стоп-словами, в индекс не попали. При стемминге в индексе лежат основы, и под основой
+    // нового стоп-слова могут быть другие слова, поэтому тексты нужны, только если эта основа есть в индексе
+    const auto is_stem_indexed = [this](std::string_view word) {
+        const auto it = word_to_document_freqs_.find(tokenizer_.Stem(word));
+        return it != word_to_document_freqs_.end() && !it->second.empty();
+    };
+    const bool needs_texts = !documents_.empty()
+        && (has_removed_words || (tokenizer_.IsStemmingEnabled() && std::any_of(added_words.begin(), added_words.end(), is_stem_indexed)));
+    if(needs_texts && !text_source)
+    {
+        throw std::logic_error("Для такой смены стоп-слов нужны тексты документов.");
+    }
+
+    std::set<int> affected_documents;
+    if(needs_texts)
+    {
+        affected_documents.insert(document_ids_.begin(), document_ids_.end());
+    }
+    else
+    {
+        for(std::string_view word : added_words)
+        {
+            if(const auto it = word_to_document_freqs_.find(word); it != word_to_document_freqs_.end())
+            {
+                const auto& document_ids = it->second.GetDocumentIds();
+                affected_documents.insert(document_ids.begin(), document_ids.end());
+            }
+        }
+    }
+
+    stop_words_.clear();
+    for(const std::pmr::string& word : new_stop_words)
+    {
+        stop_words_.emplace(word);
+    }
+    CompileStopWords();
+    stop_word_rebuild_queue_.assign(affected_documents.begin(), affected_documents.end());
+    stop_word_text_source_ = needs_texts ? std::move(text_source) : DocumentTextSource();
+}
+
+size_t SearchServer::RebuildStopWords(size_t max_documents)
+{
+    for(; max_documents > 0 && !stop_word_rebuild_queue_.empty(); --max_documents)
+    {
+        const int document_id = stop_word_rebuild_queue_.front();
+        // Документ могли удалить после смены стоп-слов
+        if(documents_.count(document_id) != 0)
+        {
+            // Если текст получить не удалось, документ остаётся в очереди и перестраивается при следующем вызове
+            if(stop_word_text_source_)
+            {
+                ReindexDocument(document_id);
+            }
+            else
+            {
+                RemoveStopWordsFromDocument(document_id);
+            }
+        }
+        stop_word_rebuild_queue_.pop_front();
+    }
+
+    if(stop_word_rebuild_queue_.empty())
+    {
+        stop_word_text_source_ = DocumentTextSource();
+    }
+
+    return stop_word_rebuild_queue_.size();
+}
+
+size_t SearchServer::GetStopWordRebuildBacklog() const
+{
+    return stop_word_rebuild_queue_.size();
+}
+
+void SearchServer::ReindexDocument(int document_id)
+{
+    const std::string text = stop_word_text_source_(document_id);
+    ValidateDocumentText(text);
+    std::string buffer;
+    const std::vector<std::string_view> words = SplitIntoWordsNoStop(text, buffer);
+
+    const DocumentData document_data = documents_.at(document_id);
+    RemoveDocument(document_id);
+    IndexDocument(document_id, words, document_data.status, {document_data.rating});
+}
+
+void SearchServer::RemoveStopWordsFromDocument(int document_id)
+{
+    TermCounts& terms = document_terms_.at(document_id);
+    DocumentData& document_data = documents_.at(document_id);
+
+    uint32_t stop_word_count = 0;
+    std::vector<int> stop_word_positions;
+    for(const TermCount& term : terms)
+    {
+        const std::string_view word = term_words_[term.term_id];
+        if(!IsStopWord(word))
+        {
+            continue;
+        }
+
+        stop_word_count += term.count;
+        word_to_document_freqs_.at(word).Erase(document_id);
+        if(const auto positions_it = word_to_document_positions_.find(word); positions_it != word_to_document_positions_.end())
+        {
+            if(const auto document_it = positions_it->second.find(document_id); document_it != positions_it->second.end())
+            {
+                stop_word_positions.insert(stop_word_positions.end(), document_it->second.begin(), document_it->second.end());
+                positions_it->second.erase(document_it);
+            }
+        }
+    }
+    if(stop_word_count == 0)
+    {
+        return;
+    }
+
+    terms.erase(std::remove_if(terms.begin(), terms.end(), [this](const TermCount& term) { return IsStopWord(term_words_[term.term_id]); }), terms.end());
+    std::sort(stop_word_positions.begin(), stop_word_positions.end());
+
+    // Длина документа уменьшилась: TF остальных слов пересчитывается, позиции сдвигаются на число удалённых слов перед ними
+    const uint32_t length = document_data.length - stop_word_count;
+    for(const TermCount& term : terms)
+    {
+        const std::string_view word = term_words_[term.term_id];
+        word_to_document_freqs_.at(word).Insert(document_id, static_cast<double>(term.count) / length);
+        if(const auto positions_it = word_to_document_positions_.find(word); positions_it != word_to_document_positions_.end())
+        {
+            if(const auto document_it = positions_it->second.find(document_id); document_it != positions_it->second.end())
+            {
+                for(int& position : document_it->second)
+                {
+                    position -= static_cast<int>(std::lower_bound(stop_word_positions.begin(), stop_word_positions.end(), position) - stop_word_positions.begin());
+                }
+            }
+        }
+    }
+
+    total_document_length_ -= stop_word_count;
+    document_data.length = length;
+    ++index_version_;
+}
+
+void SearchServer::SetStemmingEnabled(bool enabled)
+{
+    if(!documents_.empty())
+    {
+        throw std::logic_error("Стемминг можно переключить только до добавления документов.");
+    }
+
+    tokenizer_.SetStemmingEnabled(enabled);
+}
+
+void SearchServer::SetTermFreqPrecision(TermFreqPrecision precision)
+{
+    if(!documents_.empty())
+    {
+        throw std::logic_error("Точность TF можно изменить только до добавления документов.");
+    }
+
+    term_freq_precision_ = precision;
+}
+
+void SearchServer::SetIndexAllocator(IndexAllocator allocator)
+{
+    const std::array<CountingMemoryResource*, 5> index_memory = {&term_dictionary_memory_, &inverted_index_memory_,
+        &positional_index_memory_, &forward_index_memory_, &document_metadata_memory_};
+
+    // Пустой индекс после удаления всех документов ещё держит память словаря
+    if(!documents_.empty() || std::any_of(index_memory.begin(), index_memory.end(), [](const CountingMemoryResource* memory) {
+           return memory->GetAllocatedBytes() != 0;
+       }))
+    {
+        throw std::logic_error("Аллокатор индекса можно изменить только до добавления документов.");
+    }
+
+    std::unique_ptr<HugePageMemoryResource> huge_page_memory;
+    std::unique_ptr<SlabMemoryResource> slab_memory;
+    std::pmr::memory_resource* upstream = std::pmr::new_delete_resource();
+
+    if(allocator == IndexAllocator::SLAB_HUGE_PAGES)
+    {
+        huge_page_memory = std::make_unique<HugePageMemoryResource>();
+        slab_memory = std::make_unique<SlabMemoryResource>(huge_page_memory.get());
+        upstream = slab_memory.get();
+    }
+    else if(allocator == IndexAllocator::SLAB)
+    {
+        slab_memory = std::make_unique<SlabMemoryResource>();
+        upstream = slab_memory.get();
+    }
+
+    for(CountingMemoryResource* memory : index_memory)
+    {
+        memory->SetUpstream(upstream);
+    }
+
+    slab_memory_ = std::move(slab_memory);
+    huge_page_memory_ = std::move(huge_page_memory);
+    index_allocator_ = allocator;
+}
+
+IndexAllocator SearchServer::GetIndexAllocator() const
+{
+    return index_allocator_;
+}
+
+void SearchServer::SetPositionalIndexEnabled(bool enabled)
+{
+    positional_index_enabled_ = enabled;
+}
+
+void SearchServer::SetFuzzyMaxDistance(int max_distance)
+{
+    if(max_distance < 0 || max_distance > MAX_FUZZY_DISTANCE)
+    {
+        throw std::invalid_argument("Допустимое расстояние нечёткого поиска — от 0 до 2.");
+    }
+
+    fuzzy_max_distance_ = max_distance;
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query) const
+{
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(const std::execution::sequenced_policy&, std::string_view raw_query) const
+{
+    return FindTopDocuments(std::execution::seq, raw_query, DocumentStatus::ACTUAL);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query) const
+{
+    return FindTopDocuments(std::execution::par, raw_query, DocumentStatus::ACTUAL);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const
+{
+    return FindTopDocuments(raw_query, DocumentFilter{status});
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(const std::execution::sequenced_policy&, std::string_view raw_query, DocumentStatus status) const
+{
+    return FindTopDocuments(std::execution::seq, raw_query, DocumentFilter{status});
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query, DocumentStatus status) const
+{
+    return FindTopDocuments(std::execution::par, raw_query, DocumentFilter{status});
+}
+
+size_t SearchServer::EstimateQueryCost(std::string_view raw_query) const
+{
+    Query query = ParseQuery(raw_query);
+    RemoveDuplicateQueryWords(query);
+
+    return EstimateQueryCost(query);
+}
+
+void SearchServer::SetExecutionThresholds(const ExecutionThresholds& thresholds)
+{
+    execution_thresholds_ = thresholds;
+}
+
+const ExecutionThresholds& SearchServer::GetExecutionThresholds() const
+{
+    return execution_thresholds_;
+}
+
+ExecutionStrategy SearchServer::ChooseExecutionStrategy(size_t estimated_cost) const
+{
+    return estimated_cost >= execution_thresholds_.parallel_posting_count ? ExecutionStrategy::PARALLEL : ExecutionStrategy::SEQUENTIAL;
+}
+
+size_t SearchServer::EstimateQueryCost(const Query& query) const
+{
+    const auto get_posting_count = [this](std::string_view word) -> size_t {
+        const auto it = word_to_document_freqs_.find(word);
+        return it == word_to_document_freqs_.end() ? 0 : it->second.size();
+    };
+
+    size_t cost = 0;
+    for(std::string_view word : query.plus_words)
+    {
+        cost += get_posting_count(word);
+    }
+    for(std::string_view word : query.minus_words)
+    {
+        cost += get_posting_count(word);
+    }
+    for(const WeightedWord& word : query.expanded_words)
+    {
+        cost += get_posting_count(word.data);
+    }
+
+    return cost;
+}
+
+void SearchServer::RecordQueryTerms(const Query& query) const
+{
+    // Длины постингов находятся до захвата мьютекса, под ним только обновляется скетч
+    std::vector<std::pair<std::string_view, size_t>> terms;
+    const auto add_term = [this, &terms](std::string_view word) {
+        if(const auto it = word_to_document_freqs_.find(word); it != word_to_document_freqs_.end() && !it->second.empty())
+        {
+            terms.emplace_back(word, it->second.size());
+        }
+    };
+    std::for_each(query.plus_words.begin(), query.plus_words.end(), add_term);
+    std::for_each(query.minus_words.begin(), query.minus_words.end(), add_term);
+    for(const WeightedWord& word : query.expanded_words)
+    {
+        add_term(word.data);
+    }
+    if(terms.empty())
+    {
+        return;
+    }
+
+    // Поток начинает со своего скетча и берёт первый свободный, поэтому параллельные запросы не ждут друг друга
+    const size_t first_shard = std::hash<std::thread::id>()(std::this_thread::get_id()) % query_term_sketches_.size();
+    QueryTermSketch* shard = nullptr;
+    std::unique_lock<std::mutex> guard;
+    for(size_t i = 0; i < query_term_sketches_.size() && !guard.owns_lock(); ++i)
+    {
+        shard = &query_term_sketches_[(first_shard + i) % query_term_sketches_.size()];
+        guard = std::unique_lock(shard->mutex, std::try_to_lock);
+    }
+    if(!guard.owns_lock())
+    {
+        shard = &query_term_sketches_[first_shard];
+        guard = std::unique_lock(shard->mutex);
+    }
+
+    for(const auto& [word, posting_count] : terms)
+    {
+        shard->sketch.Add(word, posting_count);
+    }
+}
+
+uint64_t SearchServer::GetIndexVersion() const
+{
+    return index_version_;
+}
+
+int SearchServer::GetDocumentCount() const
+{
+    return documents_.size();
+}
+
+std::pmr::set<int>::const_iterator SearchServer::begin() const
+{
+    return document_ids_.begin();
+}
+
+std::pmr::set<int>::const_iterator SearchServer::end() const
+{
+    return document_ids_.end();
+}
+
+IndexStats SearchServer::GetIndexStats(size_t top_count) const
+{
+    IndexStats stats;
+    stats.document_count = documents_.size();
+    stats.vocabulary_size = words_.size();
+
+    std::vector<std::pair<size_t, std::string_view>> terms;
+    terms.reserve(word_to_document_freqs_.size());
+    for(const auto& [word, postings] : word_to_document_freqs_)
+    {
+        const size_t document_count = postings.size();
+        if(document_count == 0)
+        {
+            continue;
+        }
+
+        ++stats.live_term_count;
+        stats.posting_count += document_count;
+        size_t bucket = 0;
+        while((document_count >> (bucket + 1)) != 0)
+        {
+            ++bucket;
+        }
+        if(stats.document_frequency_histogram.size() <= bucket)
+        {
+            stats.document_frequency_histogram.resize(bucket + 1, 0);
+        }
+        ++stats.document_frequency_histogram[bucket];
+        terms.emplace_back(document_count, word);
+    }
+
+    // При равной длине постингов слова идут по алфавиту
+    const size_t heaviest_count = std::min(top_count, terms.size());
+    std::partial_sort(terms.begin(), terms.begin() + heaviest_count, terms.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+    });
+    for(size_t i = 0; i < heaviest_count; ++i)
+    {
+        stats.heaviest_terms.push_back({std::string(terms[i].second), terms[i].first});
+    }
+
+    SpaceSavingSketch query_term_sketch(QUERY_TERM_SKETCH_CAPACITY);
+    for(QueryTermSketch& shard : query_term_sketches_)
+    {
+        std::lock_guard guard(shard.mutex);
+        query_term_sketch.Merge(shard.sketch);
+    }
+    stats.costliest_query_terms = query_term_sketch.GetTop(top_count);
+    stats.total_query_posting_count = query_term_sketch.GetTotalWeight();
+
+    stats.vocabulary_growth = vocabulary_growth_;
+    if(stats.vocabulary_growth.empty() || stats.vocabulary_growth.back().added_document_count != added_document_count_)
+    {
+        stats.vocabulary_growth.push_back({added_document_count_, words_.size(), std::chrono::steady_clock::now()});
+    }
+
+    return stats;
+}
+
+MemoryStats SearchServer::GetMemoryStats() const
+{
+    MemoryStats stats;
+    stats.term_dictionary_bytes = term_dictionary_memory_.GetAllocatedBytes();
+    stats.inverted_index_bytes = inverted_index_memory_.GetAllocatedBytes();
+    stats.positional_index_bytes = positional_index_memory_.GetAllocatedBytes();
+    stats.forward_index_bytes = forward_index_memory_.GetAllocatedBytes();
+    stats.document_metadata_bytes = document_metadata_memory_.GetAllocatedBytes();
+    stats.stop_words_bytes = stop_words_memory_.GetAllocatedBytes();
+
+    // Префиксное дерево и контейнеры битовых карт живут в обычной куче и считаются по ёмкости
+    {
+        std::lock_guard guard(term_dictionary_mutex_);
+        if(term_dictionary_)
+        {
+            stats.term_dictionary_bytes += term_dictionary_->GetMemoryUsage();
+        }
+    }
+    for(const auto& [_, documents] : status_to_documents_)
+    {
+        stats.document_metadata_bytes += documents.GetMemoryUsage();
+    }
+    for(const auto& [_, documents] : rating_to_documents_)
+    {
+        stats.document_metadata_bytes += documents.GetMemoryUsage();
+    }
+
+    return stats;
+}
+
+WordFrequencies SearchServer::GetWordFrequencies(int document_id) const
+{
+    ValidateDocumentId(document_id);
+
+    return WordFrequencies(document_terms_.at(document_id), term_words_, documents_.at(document_id).length);
+}
+
+void SearchServer::RemoveDocument(int document_id)
+{
+    RemoveDocument(document_id, ExecutionStrategy::PARALLEL);
+}
+
+void SearchServer::RemoveDocument(const std::execution::sequenced_policy&, int document_id)
+{
+    RemoveDocument(document_id, ExecutionStrategy::SEQUENTIAL);
+}
+
+void SearchServer::RemoveDocument(const std::execution::parallel_policy&, int document_id)
+{
+    RemoveDocument(document_id, ExecutionStrategy::PARALLEL);
+}
+
+void SearchServer::RemoveDocument(int document_id, ExecutionStrategy max_strategy)
+{
+    ValidateDocumentId(document_id);
+
+    const auto& terms = document_terms_.at(document_id);
+    std::vector<PostingList*> postings(terms.size());
+    size_t posting_count = 0;
+    for(size_t i = 0; i < terms.size(); ++i)
+    {
+        postings[i] = &word_to_document_freqs_.at(term_words_[terms[i].term_id]);
+        posting_count += postings[i]->size();
+    }
+
+    // Удаление из постинга сдвигает его хвост, поэтому работа измеряется суммарной длиной постингов документа
+    const auto erase_document = [this, document_id](PostingList* word_postings) {
+        word_postings->Erase(document_id);
+    };
+    if(max_strategy == ExecutionStrategy::PARALLEL && posting_count >= execution_thresholds_.parallel_posting_count)
+    {
+        std::for_each(std::execution::par, postings.begin(), postings.end(), erase_document);
+    }
+    else
+    {
+        std::for_each(postings.begin(), postings.end(), erase_document);
+    }
+
+    for(const TermCount& term : terms)
+    {
+        if(auto positions_it = word_to_document_positions_.find(term_words_[term.term_id]); positions_it != word_to_document_positions_.end())
+        {
+            positions_it->second.erase(document_id);
+        }
+    }
+
+    RemoveDocumentAttributes(document_id);
+    total_document_length_ -= documents_.at(document_id).length;
+    ++index_version_;
+    documents_.erase(document_id);
+    document_ids_.erase(document_id);
+    document_terms_.erase(document_id);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::string_view raw_query, int document_id) const
+{
+    return MatchDocument(std::execution::seq, raw_query, document_id);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::sequenced_policy&, std::string_view raw_query, int document_id) const
+{
+    return MatchDocuments(raw_query, {document_id}, ExecutionStrategy::SEQUENTIAL).front();
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::parallel_policy&, std::string_view raw_query, int document_id) const
+{
+    return MatchDocuments(raw_query, {document_id}, ExecutionStrategy::PARALLEL).front();
+}
+
+std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> SearchServer::MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids) const
+{
+    return MatchDocuments(raw_query, document_ids, ExecutionStrategy::PARALLEL);
+}
+
+std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> SearchServer::MatchDocuments(const std::execution::sequenced_policy&, std::string_view raw_query, const std::vector<int>& document_ids) const
+{
+    return MatchDocuments(raw_query, document_ids, ExecutionStrategy::SEQUENTIAL);
+}
+
+std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> SearchServer::MatchDocuments(const std::execution::parallel_policy&, std::string_view raw_query, const std::vector<int>& document_ids) const
+{
+    return MatchDocuments(raw_query, document_ids, ExecutionStrategy::PARALLEL);
+}
+
+std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> SearchServer::MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids, ExecutionStrategy max_strategy) const
+{
+    ValidateDocumentIds(document_ids);
+    const MatchQuery match_query = PrepareMatchQuery(raw_query);
+
+    std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> results(document_ids.size());
+    const auto match_document = [this, &match_query](int document_id) {
+        return MatchPreparedQuery(match_query, document_id);
+    };
+    if(max_strategy == ExecutionStrategy::PARALLEL && document_ids.size() >= execution_thresholds_.parallel_document_count)
+    {
+        std::transform(std::execution::par, document_ids.begin(), document_ids.end(), results.begin(), match_document);
+    }
+    else
+    {
+        std::transform(document_ids.begin(), document_ids.end(), results.begin(), match_document);
+    }
+
+    return results;
+}
+
+SearchServer::MatchQuery SearchServer::PrepareMatchQuery(std::string_view raw_query) const
+{
+    MatchQuery match_query;
+    match_query.query = ParseQuery(raw_query);
+
+    const auto resolve_words = [this](const std::vector<std::string_view>& words, std::vector<uint32_t>& term_ids) {
+        for(std::string_view word : words)
+        {
+            if(const uint32_t term_id = GetTermId(word); term_id != NO_TERM_ID)
+            {
+                term_ids.push_back(term_id);
+            }
+        }
+
+        std::sort(term_ids.begin(), term_ids.end());
+        term_ids.erase(std::unique(term_ids.begin(), term_ids.end()), term_ids.end());
+    };
+
+    resolve_words(match_query.query.plus_words, match_query.plus_terms);
+    resolve_words(match_query.query.minus_words, match_query.minus_terms);
+
+    std::vector<std::string_view> expanded_words;
+    for(const auto& [word, weight] : match_query.query.expanded_words)
+    {
+        expanded_words.push_back(word);
+    }
+    resolve_words(expanded_words, match_query.expanded_terms);
+
+    return match_query;
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchPreparedQuery(const MatchQuery& match_query, int document_id) const
+{
+    const DocumentStatus status = documents_.at(document_id).status;
+    const auto& terms = document_terms_.at(document_id);
+
+    if(!IntersectTerms(match_query.minus_terms, terms).empty() || !IsMatchingRequiredWords(match_query.query, document_id))
+    {
+        return {std::vector<std::string_view>{}, status};
+    }
+
+    // Совпавшие слова запроса, затем совпавшие раскрытые слова, каждая группа в алфавитном порядке
+    std::vector<std::string_view> matched_words;
+    for(const auto& query_terms : {&match_query.plus_terms, &match_query.expanded_terms})
+    {
+        const size_t group_begin = matched_words.size();
+        for(const uint32_t term_id : IntersectTerms(*query_terms, terms))
+        {
+            matched_words.push_back(term_words_[term_id]);
+        }
+        std::sort(matched_words.begin() + group_begin, matched_words.end());
+    }
+
+    return {matched_words, status};
+}
+
+uint32_t SearchServer::GetTermId(std::string_view word) const
+{
+    const auto it = words_.find(word);
+    return it == words_.end() ? NO_TERM_ID : it->second;
+}
+
+bool SearchServer::IsStopWord(std::string_view word) const
+{
+    return stop_word_set_.Contains(word);
+}
+
+void SearchServer::AddStopWord(std::string_view word)
+{
+    ValidateStopWord(word);
+
+    std::string buffer;
+    for(std::string_view normalized_word : tokenizer_.Tokenize(word, buffer))
+    {
+        stop_words_.emplace(normalized_word);
+    }
+}
+
+void SearchServer::CompileStopWords()
+{
+    stop_word_set_ = StopWordSet(std::vector<std::string_view>(stop_words_.begin(), stop_words_.end()), &stop_words_memory_);
+}
+
+std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text, std::string& buffer) const
+{
+    std::vector<std::string_view> words;
+    for (std::string_view word : tokenizer_.Tokenize(text, buffer))
+    {
+        if (!IsStopWord(word))
+        {
+            words.push_back(tokenizer_.Stem(word));
+        }
+    }
+
+    return words;
+}
+
+void SearchServer::CountAddedDocuments(uint64_t count)
+{
+    const uint64_t previous_count = added_document_count_;
+    added_document_count_ += count;
+    if(added_document_count_ / vocabulary_sample_interval_ == previous_count / vocabulary_sample_interval_)
+    {
+        return;
+    }
+
+    vocabulary_growth_.push_back({added_document_count_, words_.size(), std::chrono::steady_clock::now()});
+    if(vocabulary_growth_.size() > MAX_VOCABULARY_POINTS)
+    {
+        // Остаются точки, кратные удвоенному интервалу, поэтому память под историю ограничена при любом числе документов
+        size_t kept_count = 0;
+        for(size_t i = 1; i < vocabulary_growth_.size(); i += 2)
+        {
+            vocabulary_growth_[kept_count++] = vocabulary_growth_[i];
+        }
+        vocabulary_growth_.resize(kept_count);
+        vocabulary_sample_interval_ *= 2;
+    }
+}
+
+int SearchServer::ComputeAverageRating(const std::vector<int>& ratings)
+{
+    if (ratings.empty())
+    {
+        return 0;
+    }
+    
+    int rating_sum = 0;
+    for (const int rating : ratings)
+    {
+        rating_sum += rating;
+    }
+
+    return rating_sum / static_cast<int>(ratings.size());
+}
+
+SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view word) const
+{
+    if(word.empty())
+    {
+        throw std::invalid_argument("Query word is empty"s);
+    }
+
+    ValidateWordQuery(word);
+
+    bool is_minus = false;
+    bool is_required = false;
+
+    if(word[0] == '-')
+    {
+        is_minus = true;
+        word = word.substr(1);
+    }
+    else if(word[0] == '+')
+    {
+        is_required = true;
+        word = word.substr(1);
+    }
+
+    if(word.empty() || word[0] == '-' || word[0] == '+' || !IsValidWord(word))
+    {
+        throw std::invalid_argument("Query word "s + std::string(word) + " is invalid"s);
+    }
+
+    return { word, is_minus, is_required };
+}
+
+SearchServer::Query SearchServer::ParseQuery(std::string_view text) const
+{
+    Query result;
+    std::vector<std::string_view> words = ExtractPhrases(text, result);
+
+    result.minus_words.reserve(words.size());
+    result.plus_words.reserve(result.plus_words.size() + words.size());
+
+    for(std::string_view word : words)
+    {
+        AddQueryWord(ParseQueryWord(word), result);
+    }
+    RemoveDuplicateExpansions(result);
+
+    return result;
+}
+
+std::vector<std::string_view> SearchServer::ExtractPhrases(std::string_view text, Query& query) const
+{
+    size_t quote = text.find('"');
+    if(quote == text.npos)
+    {
+        return SplitIntoWords(text);
+    }
+
+    std::vector<std::string_view> words;
+    const auto add_words = [&words](std::string_view part) {
+        for(std::string_view word : SplitIntoWords(part))
+        {
+            words.push_back(word);
+        }
+    };
+
+    while(quote != text.npos)
+    {
+        const size_t closing_quote = text.find('"', quote + 1);
+        if(closing_quote == text.npos)
+        {
+            throw std::invalid_argument("Фраза поискового запроса не закрыта кавычкой.");
+        }
+
+        add_words(text.substr(0, quote));
+
+        std::vector<std::string_view> phrase;
+        for(std::string_view word : SplitIntoWords(text.substr(quote + 1, closing_quote - quote - 1)))
+        {
+            const QueryWord query_word = ParseQueryWord(word);
+            if(query_word.is_minus || query_word.is_required)
+            {
+                throw std::invalid_argument("Фраза поискового запроса не может содержать операторы.");
+            }
+
+            const auto normalized_words = NormalizeQueryWord(query_word.data, query, false);
+            phrase.insert(phrase.end(), normalized_words.begin(), normalized_words.end());
+        }
+
+        if(!phrase.empty())
+        {
+            query.plus_words.insert(query.plus_words.end(), phrase.begin(), phrase.end());
+            query.phrases.push_back(std::move(phrase));
+        }
+
+        text.remove_prefix(closing_quote + 1);
+        quote = text.find('"');
+    }
+    add_words(text);
+
+    return words;
+}
+
+void SearchServer::AddQueryWord(const QueryWord& query_word, Query& query) const
 {
-    ValidateNewDocument(document_id, document);
+    if(query_word.is_required)
+    {
+        std::vector<std::string_view> group;
+        std::string_view alternatives = query_word.data;
 
-    const auto words = SplitIntoWordsNoStop(document);
-    const double inv_word_count = 1.0 / words.size();
+        while(true)
+        {
+            const size_t separator = alternatives.find('|');
+            const std::string_view alternative = alternatives.substr(0, separator);
 
-    for(std::string_view word : words)
-    {
-        auto it = words_.insert(static_cast<std::string>(word));
-        word_to_document_freqs_[*it.first][document_id] += inv_word_count;
-        document_word_freqs_[document_id][*it.first] += inv_word_count;
-    }
+            if(alternative.empty() || alternative[0] == '-' || alternative[0] == '+')
+            {
+                throw std::invalid_argument("Query word "s + std::string(query_word.data) + " is invalid"s);
+            }
 
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status});
-    document_ids_.insert(document_id);
-}
+            for(std::string_view word : NormalizeQueryWord(alternative, query))
+            {
+                if(IsExpandableWord(word))
+                {
+                    // Группе нужны все слова шаблона, а в релевантность идут только первые MAX_TERM_EXPANSION_COUNT
+                    const auto expansions = ExpandWord(word, SIZE_MAX);
+                    for(const WeightedWord& expansion : expansions)
+                    {
+                        group.push_back(expansion.data);
+                    }
+                    query.expanded_words.insert(query.expanded_words.end(), expansions.begin(),
+                                                expansions.begin() + std::min(expansions.size(), MAX_TERM_EXPANSION_COUNT));
+                }
+                else if(IsFuzzyCandidate(word))
+                {
+                    for(const WeightedWord& expansion : ExpandFuzzyWord(word))
+                    {
+                        group.push_back(expansion.data);
+                        query.expanded_words.push_back(expansion);
+                    }
+                }
+                else
+                {
+                    group.push_back(word);
+                    query.plus_words.push_back(word);
+                }
+            }
 
-void SearchServer::SetStopWords(std::string_view stop_words_text)
-{
-    for(std::string_view word : SplitIntoWords(stop_words_text))
+            if(separator == alternatives.npos)
+            {
+                break;
+            }
+            alternatives.remove_prefix(separator + 1);
+        }
+
+        if(!group.empty())
+        {
+            query.required_groups.push_back(std::move(group));
+        }
+        return;
+    }
+
+    for(std::string_view word : NormalizeQueryWord(query_word.data, query))
     {
-        stop_words_.insert(static_cast<std::string>(word));
+        if(IsExpandableWord(word))
+        {
+            // Минус-шаблон исключает документы со всеми подходящими словами, а не с первыми MAX_TERM_EXPANSION_COUNT
+            for(const WeightedWord& expansion : ExpandWord(word, query_word.is_minus ? SIZE_MAX : MAX_TERM_EXPANSION_COUNT))
+            {
+                if(query_word.is_minus)
+                {
+                    query.minus_words.push_back(expansion.data);
+                }
+                else
+                {
+                    query.expanded_words.push_back(expansion);
+                }
+            }
+        }
+        else if(query_word.is_minus)
+        {
+            query.minus_words.push_back(word);
+        }
+        else if(IsFuzzyCandidate(word))
+        {
+            const auto expansions = ExpandFuzzyWord(word);
+            query.expanded_words.insert(query.expanded_words.end(), expansions.begin(), expansions.end());
+        }
+        else
+        {
+            query.plus_words.push_back(word);
+        }
     }
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query) const
+std::vector<std::string_view> SearchServer::NormalizeQueryWord(std::string_view word, Query& query, bool keep_wildcards) const
 {
-    return FindTopDocuments(std::execution::seq, raw_query, DocumentStatus::ACTUAL);
-}
+    std::string& buffer = query.word_buffers.emplace_back();
 
-std::vector<Document> SearchServer::FindTopDocuments(const std::execution::sequenced_policy&, std::string_view raw_query) const
-{
-    return FindTopDocuments(std::execution::seq, raw_query, DocumentStatus::ACTUAL);
-}
+    std::vector<std::string_view> words;
+    for(std::string_view normalized_word : tokenizer_.Tokenize(word, buffer, keep_wildcards))
+    {
+        if(!IsStopWord(normalized_word))
+        {
+            words.push_back(tokenizer_.Stem(normalized_word));
+        }
+    }
 
-std::vector<Document> SearchServer::FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query) const
-{
-    return FindTopDocuments(std::execution::par, raw_query, DocumentStatus::ACTUAL);
+    return words;
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const
+bool SearchServer::IsExpandableWord(std::string_view word)
 {
-    return FindTopDocuments(std::execution::seq, raw_query, [status](int document_id, DocumentStatus document_status, int rating)
-    {
-        return document_status == status;
-    });
+    return word.find_first_of("*?") != word.npos;
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(const std::execution::sequenced_policy&, std::string_view raw_query, DocumentStatus status) const
+std::vector<SearchServer::WeightedWord> SearchServer::ExpandWord(std::string_view pattern, size_t max_count) const
 {
-    return FindTopDocuments(std::execution::seq, raw_query, [status](int document_id, DocumentStatus document_status, int rating)
+    const size_t wildcard = pattern.find_first_of("*?");
+    if(wildcard == 0)
     {
-        return document_status == status;
-    });
-}
+        throw std::invalid_argument("Шаблон слова поискового запроса не может начинаться с '*' или '?'.");
+    }
 
-std::vector<Document> SearchServer::FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query, DocumentStatus status) const
-{
-    return FindTopDocuments(std::execution::par, raw_query, [status](int document_id, DocumentStatus document_status, int rating)
-    {
-        return document_status == status;
-    });
-}
+    const auto term_dictionary = GetTermDictionary();
+    const bool is_prefix = wildcard + 1 == pattern.size() && pattern.back() == '*';
+    const std::vector<std::string_view> terms = is_prefix
+        ? term_dictionary->FindByPrefix(pattern.substr(0, wildcard), max_count)
+        : term_dictionary->FindByPattern(pattern, max_count, max_count == SIZE_MAX ? SIZE_MAX : MAX_TERM_DICTIONARY_VISITS);
 
-int SearchServer::GetDocumentCount() const
-{
-    return documents_.size();
-}
+    const double literal_length = static_cast<double>(CountUtf8Chars(pattern) - std::count_if(pattern.begin(), pattern.end(), [](char c) {
+        return c == '*' || c == '?';
+    }));
 
-std::set<int>::const_iterator SearchServer::begin() const
-{
-    return document_ids_.begin();
-}
+    std::vector<WeightedWord> expansions;
+    expansions.reserve(terms.size());
+    for(std::string_view term : terms)
+    {
+        expansions.push_back({term, std::min(1.0, literal_length / CountUtf8Chars(term))});
+    }
 
-std::set<int>::const_iterator SearchServer::end() const
-{
-    return document_ids_.end();
+    return expansions;
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const
+bool SearchServer::IsFuzzyCandidate(std::string_view word) const
 {
-    ValidateDocumentIndex(document_id);
+    if(fuzzy_max_distance_ == 0)
+    {
+        return false;
+    }
 
-    return document_word_freqs_.at(document_id);
+    const auto it = word_to_document_freqs_.find(word);
+    return it == word_to_document_freqs_.end() || it->second.empty();
 }
 
-void SearchServer::RemoveDocument(int document_id)
+std::vector<SearchServer::WeightedWord> SearchServer::ExpandFuzzyWord(std::string_view word) const
 {
-    RemoveDocument(std::execution::seq, document_id);
-}
+    const size_t length = CountUtf8Chars(word);
+    if(length < MIN_FUZZY_WORD_LENGTH)
+    {
+        return {};
+    }
 
-void SearchServer::RemoveDocument(const std::execution::sequenced_policy&, int document_id)
-{
-    ValidateDocumentIndex(document_id);
+    const int max_distance = length < MIN_FUZZY_TWO_EDITS_WORD_LENGTH ? std::min(fuzzy_max_distance_, 1) : fuzzy_max_distance_;
 
-    for(auto& [word, freqs] : document_word_freqs_.at(document_id))
+    std::vector<WeightedWord> expansions;
+    for(const auto& [term, distance] : GetTermDictionary()->FindFuzzy(word, max_distance, MAX_TERM_EXPANSION_COUNT))
     {
-        word_to_document_freqs_.at(word).erase(document_id);
+        expansions.push_back({term, 1.0 / (1 + distance)});
     }
 
-    documents_.erase(document_id);
-    document_ids_.erase(document_id);
-    document_word_freqs_.erase(document_id);
+    return expansions;
 }
 
-void SearchServer::RemoveDocument(const std::execution::parallel_policy&, int document_id)
+void SearchServer::RemoveDuplicateExpansions(Query& query)
 {
-    ValidateDocumentIndex(document_id);
-
-    auto word_freqs = document_word_freqs_.at(document_id);
-    std::vector<std::string_view> words;
-    words.reserve(word_freqs.size());
-
-    transform(std::execution::par, word_freqs.begin(), word_freqs.end(), words.begin(), [](const auto item) {
-        return item.first;
+    std::sort(query.expanded_words.begin(), query.expanded_words.end(), [](const WeightedWord& lhs, const WeightedWord& rhs) {
+        return lhs.data < rhs.data || (lhs.data == rhs.data && lhs.weight > rhs.weight);
     });
 
-    for_each(std::execution::par, words.begin(), words.end(), [this, document_id](const auto& word) {
-        word_to_document_freqs_.at(word).erase(document_id);
+    auto last = std::unique(query.expanded_words.begin(), query.expanded_words.end(), [](const WeightedWord& lhs, const WeightedWord& rhs) {
+        return lhs.data == rhs.data;
     });
+    query.expanded_words.erase(last, query.expanded_words.end());
 
-    documents_.erase(document_id);
-    document_ids_.erase(document_id);
-    document_word_freqs_.erase(document_id);
-}
-
-
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::string_view raw_query, int document_id) const
-{
-    return MatchDocument(std::execution::seq, raw_query, document_id);
+    query.expanded_words.erase(std::remove_if(query.expanded_words.begin(), query.expanded_words.end(), [&query](const WeightedWord& word) {
+        return std::find(query.plus_words.begin(), query.plus_words.end(), word.data) != query.plus_words.end();
+    }), query.expanded_words.end());
 }
 
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::sequenced_policy&, std::string_view raw_query, int document_id) const
+void SearchServer::RemoveDuplicateQueryWords(Query& query)
 {
-    Query query = ParseQuery(raw_query);
-
     std::sort(query.minus_words.begin(), query.minus_words.end());
     auto last_minus = std::unique(query.minus_words.begin(), query.minus_words.end());
     query.minus_words.erase(last_minus, query.minus_words.end());
@@ -158,201 +1405,326 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
     std::sort(query.plus_words.begin(), query.plus_words.end());
     auto last_plus = std::unique(query.plus_words.begin(), query.plus_words.end());
     query.plus_words.erase(last_plus, query.plus_words.end());
+}
 
-    std::vector<std::string_view> matched_words;
+std::shared_ptr<const TermDictionary> SearchServer::GetTermDictionary() const
+{
+    std::lock_guard guard(term_dictionary_mutex_);
 
-    for(std::string_view word : query.plus_words)
+    if(!term_dictionary_)
     {
-        if(document_word_freqs_.at(document_id).count(word) > 0)
+        std::vector<std::string_view> sorted_words;
+        sorted_words.reserve(words_.size());
+        for(const auto& [word, _] : words_)
         {
-            const auto it = word_to_document_freqs_.find(word);
-            if (it->first == word)
-                matched_words.push_back(it->first);
+            sorted_words.push_back(word);
         }
+        term_dictionary_ = std::make_shared<const TermDictionary>(std::move(sorted_words));
     }
 
-    for(std::string_view word : query.minus_words)
+    return term_dictionary_;
+}
+
+RoaringBitmap SearchServer::FindFilteredDocuments(const DocumentFilter& filter) const
+{
+    RoaringBitmap documents;
+
+    if(filter.status)
+    {
+        const auto it = status_to_documents_.find(*filter.status);
+        if(it == status_to_documents_.end())
+        {
+            return {};
+        }
+        documents = it->second;
+    }
+    else if(!filter.min_rating && !filter.max_rating)
     {
-        if(document_word_freqs_.at(document_id).count(word) > 0)
+        for(const auto& [_, status_documents] : status_to_documents_)
         {
-            matched_words.clear();
-            break;
+            documents |= status_documents;
         }
+        return documents;
     }
 
-    return {matched_words, documents_.at(document_id).status};
-}
+    if(filter.min_rating || filter.max_rating)
+    {
+        if(filter.min_rating && filter.max_rating && *filter.min_rating > *filter.max_rating)
+        {
+            return {};
+        }
 
+        const auto first = filter.min_rating ? rating_to_documents_.lower_bound(*filter.min_rating) : rating_to_documents_.begin();
+        const auto last = filter.max_rating ? rating_to_documents_.upper_bound(*filter.max_rating) : rating_to_documents_.end();
 
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::parallel_policy&, std::string_view raw_query, int document_id) const
+        RoaringBitmap rating_documents;
+        for(auto it = first; it != last; ++it)
+        {
+            rating_documents |= it->second;
+        }
+
+        if(filter.status)
+        {
+            documents &= rating_documents;
+        }
+        else
+        {
+            documents = std::move(rating_documents);
+        }
+    }
+
+    return documents;
+}
+
+RoaringBitmap SearchServer::FindExcludedDocuments(const Query& query) const
 {
-    ValidateDocumentIndex(document_id);
+    RoaringBitmap documents;
+    for(std::string_view word : query.minus_words)
+    {
+        const auto it = word_to_document_freqs_.find(word);
+        if(it == word_to_document_freqs_.end())
+        {
+            continue;
+        }
 
-    Query query = ParseQuery(std::execution::par, raw_query);
+        for(const int document_id : it->second.GetDocumentIds())
+        {
+            documents.Add(static_cast<uint32_t>(document_id));
+        }
+    }
 
-    std::sort(query.minus_words.begin(), query.minus_words.end());
-    auto last_minus = std::unique(query.minus_words.begin(), query.minus_words.end());
-    query.minus_words.erase(last_minus, query.minus_words.end());
+    return documents;
+}
 
-    const auto pred = [this, document_id](const std::string_view word) {
-                return word_to_document_freqs_.count(word) && word_to_document_freqs_.at(word).count(document_id);
-            };
+SearchServer::CandidateDocuments SearchServer::FindCandidateDocuments(const Query& query, const DocumentFilter* filter) const
+{
+    CandidateDocuments candidates;
+    candidates.excluded = FindExcludedDocuments(query);
 
-    if(any_of(std::execution::par, query.minus_words.begin(), query.minus_words.end(), pred))
+    if(filter != nullptr)
     {
-        return { {}, documents_.at(document_id).status };
+        candidates.allowed = FindFilteredDocuments(*filter);
+        candidates.is_restricted = true;
     }
 
-    std::vector<std::string_view> matched_words(query.plus_words.size());
+    if(const auto required_documents = FindRequiredDocuments(query))
+    {
+        RoaringBitmap required;
+        for(const int document_id : *required_documents)
+        {
+            required.Add(static_cast<uint32_t>(document_id));
+        }
+
+        if(candidates.is_restricted)
+        {
+            candidates.allowed &= required;
+        }
+        else
+        {
+            candidates.allowed = std::move(required);
+            candidates.is_restricted = true;
+        }
+    }
 
-    auto matched_copy = std::copy_if(std::execution::par, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(), [this, document_id](std::string_view word) {
-        return (word_to_document_freqs_.count(word) && word_to_document_freqs_.at(word).count(document_id));
-    });
+    if(candidates.is_restricted)
+    {
+        candidates.allowed -= candidates.excluded;
+        candidates.excluded = {};
+    }
 
-    std::sort(matched_words.begin(), matched_copy);
-    auto last_matched = std::unique(matched_words.begin(), matched_copy);
-    matched_words.erase(last_matched, matched_words.end());
+    return candidates;
+}
 
-    return {matched_words, documents_.at(document_id).status};
+bool SearchServer::CandidateDocuments::IsUnrestricted() const
+{
+    return !is_restricted && excluded.IsEmpty();
 }
 
-bool SearchServer::IsStopWord(std::string_view word) const
+bool SearchServer::CandidateDocuments::Contains(int document_id) const
 {
-    return stop_words_.count(word) > 0;
+    const uint32_t id = static_cast<uint32_t>(document_id);
+    return is_restricted ? allowed.Contains(id) : !excluded.Contains(id);
 }
 
-std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text)
+void SearchServer::RemoveDocumentAttributes(int document_id)
 {
-    std::vector<std::string_view> words;
-    for (std::string_view word : SplitIntoWords(text))
+    const DocumentData& document_data = documents_.at(document_id);
+
+    status_to_documents_.at(document_data.status).Remove(document_id);
+
+    auto rating_it = rating_to_documents_.find(document_data.rating);
+    rating_it->second.Remove(document_id);
+    if(rating_it->second.IsEmpty())
     {
-        if (!IsValidWord(word))
-        {
-            throw std::invalid_argument("Word "s + std::string(word) + " is invalid"s);
-        }
-        if (!IsStopWord(word))
-        {
-            words.push_back(word);
-        }
+        rating_to_documents_.erase(rating_it);
     }
+}
 
-    return words;
+double SearchServer::ComputeAverageDocumentLength() const
+{
+    if(documents_.empty())
+    {
+        return 0.0;
+    }
+
+    return static_cast<double>(total_document_length_) / documents_.size();
 }
 
-int SearchServer::ComputeAverageRating(const std::vector<int>& ratings)
+bool SearchServer::IsRankedBefore(const Document& lhs, const Document& rhs)
 {
-    if (ratings.empty())
+    // id разрешает равенство релевантности и рейтинга, чтобы порядок был полным
+    if (std::abs(lhs.relevance - rhs.relevance) < COMPARISON_ERROR)
     {
-        return 0;
+        return lhs.rating > rhs.rating || (lhs.rating == rhs.rating && lhs.id < rhs.id);
     }
-    
-    int rating_sum = 0;
-    for (const int rating : ratings)
+    else
     {
-        rating_sum += rating;
+        return lhs.relevance > rhs.relevance;
     }
+}
 
-    return rating_sum / static_cast<int>(ratings.size());
+bool SearchServer::IsRankedStrictlyBefore(const Document& lhs, const Document& rhs)
+{
+    return std::make_tuple(-lhs.relevance, -static_cast<int64_t>(lhs.rating), lhs.id) < std::make_tuple(-rhs.relevance, -static_cast<int64_t>(rhs.rating), rhs.id);
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view word) const
+void SearchServer::SelectTopDocuments(std::vector<Document>& documents, size_t max_count, DocumentOrder is_ranked_before)
 {
-    if(word.empty())
+    if(documents.size() > max_count)
     {
-        throw std::invalid_argument("Query word is empty"s);
+        std::partial_sort(documents.begin(), documents.begin() + max_count, documents.end(), is_ranked_before);
+        documents.resize(max_count);
     }
+    else
+    {
+        std::sort(documents.begin(), documents.end(), is_ranked_before);
+    }
+}
 
-    ValidateWordQuery(word);
+std::vector<int> SearchServer::GetDocumentIds(std::string_view word) const
+{
+    std::vector<int> document_ids;
 
-    bool is_minus = false;
+    if(const auto it = word_to_document_freqs_.find(word); it != word_to_document_freqs_.end())
+    {
+        document_ids.assign(it->second.GetDocumentIds().begin(), it->second.GetDocumentIds().end());
+    }
 
-    if(word[0] == '-')
+    return document_ids;
+}
+
+std::optional<std::vector<int>> SearchServer::FindRequiredDocuments(const Query& query) const
+{
+    if(query.required_groups.empty() && query.phrases.empty())
     {
-        is_minus = true;
-        word = word.substr(1);
+        return std::nullopt;
     }
 
-    if(word.empty() || word[0] == '-' || !IsValidWord(word))
+    std::vector<std::vector<int>> document_lists;
+
+    for(const auto& group : query.required_groups)
     {
-        throw std::invalid_argument("Query word "s + std::string(word) + " is invalid"s);
+        std::vector<int> document_ids;
+        for(std::string_view word : group)
+        {
+            document_ids = UniteSorted(document_ids, GetDocumentIds(word));
+        }
+        document_lists.push_back(std::move(document_ids));
     }
 
-    return { word, is_minus, IsStopWord(word)};
-}
+    for(const auto& phrase : query.phrases)
+    {
+        std::vector<std::vector<int>> word_lists;
+        for(std::string_view word : phrase)
+        {
+            word_lists.push_back(GetDocumentIds(word));
+        }
 
-SearchServer::Query SearchServer::ParseQuery(const std::string_view text) const
-{
-    return ParseQuery(std::execution::seq, text);
+        std::vector<int> document_ids = IntersectSorted(std::move(word_lists));
+        document_ids.erase(std::remove_if(document_ids.begin(), document_ids.end(), [this, &phrase](int document_id) {
+            return !HasPhrase(phrase, document_id);
+        }), document_ids.end());
+        document_lists.push_back(std::move(document_ids));
+    }
+
+    return IntersectSorted(std::move(document_lists));
 }
 
-SearchServer::Query SearchServer::ParseQuery(const std::execution::sequenced_policy&, std::string_view text) const
+bool SearchServer::HasPhrase(const std::vector<std::string_view>& phrase, int document_id) const
 {
-    std::vector<std::string_view> words = SplitIntoWords(text);
+    std::vector<const std::pmr::vector<int>*> word_positions;
+    word_positions.reserve(phrase.size());
 
-    Query result;
-    result.minus_words.reserve(words.size());
-    result.plus_words.reserve(words.size());
+    for(std::string_view word : phrase)
+    {
+        const auto word_it = word_to_document_positions_.find(word);
+        if(word_it == word_to_document_positions_.end())
+        {
+            return true;
+        }
+
+        const auto document_it = word_it->second.find(document_id);
+        if(document_it == word_it->second.end())
+        {
+            return true;
+        }
+        word_positions.push_back(&document_it->second);
+    }
 
-    for(std::string_view word : SplitIntoWords(text))
+    for(const int start : *word_positions.front())
     {
-        const auto query_word = ParseQueryWord(word);
+        bool is_found = true;
+        for(size_t i = 1; i < word_positions.size() && is_found; ++i)
+        {
+            is_found = std::binary_search(word_positions[i]->begin(), word_positions[i]->end(), start + static_cast<int>(i));
+        }
 
-        if(!query_word.is_stop)
+        if(is_found)
         {
-            if(query_word.is_minus)
-            {
-                result.minus_words.push_back(query_word.data);
-            }
-            else
-            {
-                result.plus_words.push_back(query_word.data);
-            }
+            return true;
         }
     }
 
-    return result;
+    return false;
 }
 
-SearchServer::Query SearchServer::ParseQuery(const std::execution::parallel_policy&, std::string_view text) const
+bool SearchServer::IsMatchingRequiredWords(const Query& query, int document_id) const
 {
-    std::vector<std::string_view> words = SplitIntoWords(text);
-
-    Query result;
-    result.minus_words.reserve(words.size());
-    result.plus_words.reserve(words.size());
+    const auto document_it = document_terms_.find(document_id);
+    if(document_it == document_terms_.end())
+    {
+        return query.required_groups.empty() && query.phrases.empty();
+    }
 
-    std::vector<QueryWord> query_words(words.size());
-    std::transform(std::execution::par, words.begin(), words.end(), query_words.begin(), [this](std::string_view word){
-        return ParseQueryWord(word);
-    });
+    const auto& terms = document_it->second;
+    const auto is_in_document = [this, &terms](std::string_view word) {
+        const uint32_t term_id = GetTermId(word);
+        return term_id != NO_TERM_ID && ContainsTerm(terms, term_id);
+    };
 
-    for(QueryWord& query_word : query_words)
+    for(const auto& group : query.required_groups)
     {
-        if(!query_word.is_stop)
+        if(std::none_of(group.begin(), group.end(), is_in_document))
         {
-            if(query_word.is_minus)
-            {
-                result.minus_words.push_back(query_word.data);
-            }
-            else
-            {
-                result.plus_words.push_back(query_word.data);
-            }
+            return false;
         }
     }
 
-    return result;
-}
+    for(const auto& phrase : query.phrases)
+    {
+        if(!std::all_of(phrase.begin(), phrase.end(), is_in_document) || !HasPhrase(phrase, document_id))
+        {
+            return false;
+        }
+    }
 
-double SearchServer::ComputeWordInverseDocumentFreq(std::string_view word) const
-{
-    return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+    return true;
 }
 
 bool SearchServer::IsValidWord(std::string_view word)
 {
     return std::none_of(word.begin(), word.end(), [](char c) {
-        return c >= '\0' && c < ' ';
+        return c >= '\0' && c < ' ' && !IsSpace(c);
     });
 }
 
@@ -376,7 +1748,7 @@ void SearchServer::ValidateStopWord(std::string_view stop_word)
     }
 }
 
-void SearchServer::ValidateNewDocument(const int document_id, std::string_view document) const
+void SearchServer::ValidateNewDocument(int document_id, std::string_view document) const
 {
     if(document_id < 0)
     {
@@ -386,7 +1758,13 @@ void SearchServer::ValidateNewDocument(const int document_id, std::string_view d
     {
         throw std::invalid_argument("Попытка добавить документ c id ранее добавленного документа.");
     }
-    else if(!IsValidWord(document))
+
+    ValidateDocumentText(document);
+}
+
+void SearchServer::ValidateDocumentText(std::string_view document)
+{
+    if(!IsValidWord(document))
     {
         throw std::invalid_argument("Наличие недопустимых символов в тексте добавляемого документа.");
     }
@@ -404,10 +1782,21 @@ void SearchServer::ValidateWordQuery(std::string_view word) const
     }
 }
 
-void SearchServer::ValidateDocumentIndex(const size_t index) const
+void SearchServer::ValidateDocumentIds(const std::vector<int>& document_ids) const
+{
+    for(const int document_id : document_ids)
+    {
+        if(documents_.count(document_id) == 0)
+        {
+            throw std::out_of_range("Документ с таким id не найден.");
+        }
+    }
+}
+
+void SearchServer::ValidateDocumentId(int document_id) const
 {
-    if(index >= documents_.size())
+    if(documents_.count(document_id) == 0)
     {
-        throw std::out_of_range("Индекс документа выходит за пределы допустимого диапазона.");
+        throw std::out_of_range("Документ с таким id не найден.");
     }
 }
@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory_resource>
 #include <set>
 #include <algorithm>
 #include <numeric>
@@ -10,13 +11,47 @@
 #include <stdexcept>
 #include <utility>
 #include <execution>
+#include <optional>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <type_traits>
+#include <array>
+#include <chrono>
+#include <thread>
+#include <functional>
 #include "string_processing.h"
 #include "document.h"
-#include "concurrent_map.h"
+#include "intersection.h"
+#include "term_dictionary.h"
+#include "ranking.h"
+#include "tokenizer.h"
+#include "roaring_bitmap.h"
+#include "forward_index.h"
+#include "posting_list.h"
+#include "score_kernel.h"
+#include "query_control.h"
+#include "query_plan.h"
+#include "execution_thresholds.h"
+#include "memory_stats.h"
+#include "slab_memory.h"
+#include "stop_word_set.h"
+#include "index_stats.h"
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 const double COMPARISON_ERROR = 1e-6;
 const int NUMBER_PARTS_PARALLEL_MAP = 7;
+// Шаблоны и нечёткие слова добавляют в релевантность не больше MAX_TERM_EXPANSION_COUNT слов.
+// Минус-шаблоны и шаблоны обязательных групп раскрываются полностью, без ограничения обхода словаря
+const size_t MAX_TERM_EXPANSION_COUNT = 64;
+const int MAX_FUZZY_DISTANCE = 2;
+// Слова короче MIN_FUZZY_WORD_LENGTH символов не исправляются, короче MIN_FUZZY_TWO_EDITS_WORD_LENGTH — исправляются одной правкой
+const size_t MIN_FUZZY_WORD_LENGTH = 3;
+const size_t MIN_FUZZY_TWO_EDITS_WORD_LENGTH = 6;
+const uint32_t NO_TERM_ID = UINT32_MAX;
+
+// Исходный текст документа по id для переиндексации, см. SearchServer::ChangeStopWords
+using DocumentTextSource = std::function<std::string(int document_id)>;
 
 class SearchServer
 {
@@ -29,17 +64,71 @@ class SearchServer
         explicit SearchServer(const std::string& stop_words_text);
         explicit SearchServer(std::string_view stop_words_text);
 
+        // Добавляет стоп-слова и сразу перестраивает документы, в которых они есть, см. ChangeStopWords.
+        // При стемминге бросает logic_error, если основа нового стоп-слова есть в индексе: документы
+        // нужно переиндексировать по текстам через ChangeStopWords
         void SetStopWords(std::string_view stop_words_text);
 
-        void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+        // Заменяет множество стоп-слов. Запросы и новые документы используют новое множество сразу, а уже
+        // добавленные документы перестраиваются шагами RebuildStopWords, которые можно чередовать с запросами.
+        // Новые стоп-слова удаляются из документов по прямому и позиционному индексу без исходных текстов.
+        // Чтобы вернуть в документы слово, переставшее быть стоп-словом, или применить при стемминге новые стоп-слова,
+        // основы которых есть в индексе, документы переиндексируются заново по текстам из text_source; без него в этих
+        // случаях бросается logic_error и множество не меняется. Незавершённая перестройка завершается сразу
+        void ChangeStopWords(std::string_view stop_words_text, DocumentTextSource text_source = {});
+        // Перестраивает не больше max_documents документов и возвращает, сколько ещё осталось. Если источник текстов
+        // бросил исключение или вернул некорректный текст, исключение передаётся дальше, а документ остаётся прежним и в очереди
+        size_t RebuildStopWords(size_t max_documents = SIZE_MAX);
+        size_t GetStopWordRebuildBacklog() const;
+
+        // Слова документов и запросов проходят через общий токенизатор: разбиение по пробелам и знакам препинания,
+        // приведение к нижнему регистру и, если включено, стемминг. Стемминг можно включить только до добавления документов
+        void SetStemmingEnabled(bool enabled);
+
+        // TF в постингах можно хранить с пониженной точностью ради памяти. Задаётся до добавления документов
+        void SetTermFreqPrecision(TermFreqPrecision precision);
+
+        // Источник памяти для узлов и массивов индекса: куча, слэбовый ресурс поверх кучи
+        // или слэбовый ресурс поверх участков по 2 МБ в huge pages. Задаётся до добавления документов
+        void SetIndexAllocator(IndexAllocator allocator);
+        IndexAllocator GetIndexAllocator() const;
+
+        // Позиционный индекс нужен для фразовых запросов ("curly cat").
+        // Документы, добавленные при выключенном индексе, проверяются на фразу только по наличию всех её слов
+        void SetPositionalIndexEnabled(bool enabled);
+
+        // Нечёткий поиск: отсутствующие в индексе слова запроса заменяются словами словаря
+        // на расстоянии Левенштейна не больше max_distance с весом 1 / (1 + расстояние). 0 выключает режим
+        void SetFuzzyMaxDistance(int max_distance);
 
-        template <typename DocumentPredicate>
+        void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+        // Пакетное добавление: документы разбиваются на слова параллельно, если их не меньше порога
+        // parallel_document_count, и вставляются в индекс по порядку. При ошибке в документе
+        // предшествующие ему документы пакета остаются добавленными
+        void AddDocuments(const std::vector<DocumentRecord>& documents);
+        // Построение индекса с нуля. Корпус, упорядоченный по id, делится на partition_count частей, каждый поток
+        // строит частичный индекс своей части, затем словари частей сливаются k-путевым слиянием, а постинги —
+        // параллельно по диапазонам слов. При partition_count == 0 частей столько, сколько аппаратных потоков.
+        // Доступно только для пустого сервера; при ошибке в документах сервер остаётся пустым
+        void BuildIndex(const std::vector<DocumentRecord>& documents, size_t partition_count = 0);
+
+        // Ranker задаёт формулу релевантности: TfIdfRanker, Bm25Ranker или Bm25FRanker из ranking.h.
+        // Политика выполнения — разрешение, а не приказ: с par запрос распараллеливается, только если оценка
+        // его стоимости не меньше порога из ExecutionThresholds, с seq выполняется в вызывающем потоке.
+        // Без политики запрос с DocumentFilter или статусом выполняется как с par, а с предикатом-функцией —
+        // как с seq, так как предикат может быть не потокобезопасным
+        template <typename Ranker = TfIdfRanker, typename DocumentPredicate>
         std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
-        template <typename DocumentPredicate>
+        template <typename Ranker = TfIdfRanker, typename DocumentPredicate>
         std::vector<Document> FindTopDocuments(const std::execution::sequenced_policy&, std::string_view raw_query, DocumentPredicate document_predicate) const;
-        template <typename DocumentPredicate>
+        template <typename Ranker = TfIdfRanker, typename DocumentPredicate>
         std::vector<Document> FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query, DocumentPredicate document_predicate) const;
 
+        // Поиск со сроком и отменой из control. При остановке возвращаются лучшие документы
+        // по уже обойдённым постингам, а is_complete равен false
+        template <typename Ranker = TfIdfRanker, typename DocumentPredicate>
+        SearchResult FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, const QueryControl& control) const;
+
         std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
         std::vector<Document> FindTopDocuments(const std::execution::sequenced_policy&, std::string_view raw_query) const;
         std::vector<Document> FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query) const;
@@ -48,13 +137,57 @@ class SearchServer
         std::vector<Document> FindTopDocuments(const std::execution::sequenced_policy&, std::string_view raw_query, DocumentStatus status) const;
         std::vector<Document> FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query, DocumentStatus status) const;
 
+        // Лучшие max_count документов без ограничения MAX_RESULT_DOCUMENT_COUNT в порядке IsRankedStrictlyBefore.
+        // Для глубокой пагинации удобнее курсоры из result_cursors.h
+        template <typename Ranker = TfIdfRanker, typename DocumentPredicate>
+        std::vector<Document> FindRankedDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count) const;
+        // Продолжение ранжирования: лучшие max_count документов, стоящих строго после last
+        template <typename Ranker = TfIdfRanker, typename DocumentPredicate>
+        std::vector<Document> FindRankedDocuments(std::string_view raw_query, DocumentPredicate document_predicate, const Document& last, size_t max_count) const;
+
+        // Порядок выдачи: релевантность по убыванию, затем рейтинг по убыванию, затем id по возрастанию.
+        // Релевантности, различающиеся меньше чем на COMPARISON_ERROR, считаются равными
+        static bool IsRankedBefore(const Document& lhs, const Document& rhs);
+        // Тот же порядок с точным сравнением релевантности. Сравнение с погрешностью не транзитивно, а продолжению
+        // выдачи после документа нужен строгий слабый порядок, иначе документы на границе окон теряются или повторяются
+        static bool IsRankedStrictlyBefore(const Document& lhs, const Document& rhs);
+
+        // Оценка стоимости запроса до выполнения: суммарная длина постингов его слов, включая минус-слова и раскрытые шаблоны
+        size_t EstimateQueryCost(std::string_view raw_query) const;
+
+        // Пороги распараллеливания по умолчанию калибруются при запуске, см. execution_thresholds.h
+        void SetExecutionThresholds(const ExecutionThresholds& thresholds);
+        const ExecutionThresholds& GetExecutionThresholds() const;
+        ExecutionStrategy ChooseExecutionStrategy(size_t estimated_cost) const;
+
+        // Выполняет запрос и возвращает его план: слова с длинами постингов и IDF, выбранную стратегию,
+        // оценку стоимости и фактические времена этапов
+        template <typename Ranker = TfIdfRanker>
+        QueryPlan ExplainQuery(std::string_view raw_query, const DocumentFilter& filter = DocumentFilter{DocumentStatus::ACTUAL}) const;
+
         int GetDocumentCount() const;
+        // Номер версии индекса, растёт при каждом добавлении и удалении документа
+        uint64_t GetIndexVersion() const;
+
+        std::pmr::set<int>::const_iterator begin() const;
+        std::pmr::set<int>::const_iterator end() const;
 
-        std::set<int>::const_iterator begin() const;
-        std::set<int>::const_iterator end() const;
+        // Память, занятая структурами индекса. Контейнеры индекса выделяют память через считающие ресурсы,
+        // поэтому вызов не обходит индекс. По этим цифрам можно ограничивать размер индекса
+        MemoryStats GetMemoryStats() const;
+        // Распределение документной частоты и самые длинные постинги считаются по индексу при вызове, слова запросов
+        // с наибольшей суммарной длиной постингов накапливаются скетчем при каждом поиске, рост словаря — по мере добавления
+        IndexStats GetIndexStats(size_t top_count = 20) const;
 
-        const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+        // Частоты слов документа читаются из прямого индекса без копирования
+        WordFrequencies GetWordFrequencies(int document_id) const;
 
+        // Проверяют аргументы AddDocument и RemoveDocument, не меняя индекс, и бросают те же исключения.
+        // Нужны, чтобы записать изменение в журнал до того, как применить его
+        void ValidateNewDocument(int document_id, std::string_view document) const;
+        void ValidateDocumentId(int document_id) const;
+
+        // Удаление и пакетный матчинг тоже распараллеливаются по объёму работы, если политика это разрешает
         void RemoveDocument(int document_id);
         void RemoveDocument(const std::execution::sequenced_policy&, int document_id);
         void RemoveDocument(const std::execution::parallel_policy&, int document_id);
@@ -63,242 +196,586 @@ class SearchServer
         std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::sequenced_policy&, std::string_view raw_query, int document_id) const;
         std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::parallel_policy&, std::string_view raw_query, int document_id) const;
 
+        // Пакетный матчинг, например для подсветки всех результатов запроса: запрос разбирается
+        // и сопоставляется со словами индекса один раз, документы проверяются независимо друг от друга
+        std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids) const;
+        std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> MatchDocuments(const std::execution::sequenced_policy&, std::string_view raw_query, const std::vector<int>& document_ids) const;
+        std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> MatchDocuments(const std::execution::parallel_policy&, std::string_view raw_query, const std::vector<int>& document_ids) const;
+
     private:
         struct DocumentData
         {
             int rating;
             DocumentStatus status;
+            uint32_t length;
         };
 
-        std::set<std::string, std::less<>> words_;
-        std::set<std::string, std::less<>> stop_words_;
-        std::map<std::string_view , std::map<int, double>> word_to_document_freqs_;
-        std::map<int, std::map<std::string_view, double>> document_word_freqs_;
-        std::map<int, DocumentData> documents_;
-        std::set<int> document_ids_;
+        // Слэбовый ресурс и его источник должны пережить считающие ресурсы и контейнеры, поэтому объявлены первыми
+        IndexAllocator index_allocator_ = IndexAllocator::DEFAULT;
+        std::unique_ptr<HugePageMemoryResource> huge_page_memory_;
+        std::unique_ptr<SlabMemoryResource> slab_memory_;
+
+        // Ресурсы памяти структур индекса для GetMemoryStats, объявлены раньше использующих их контейнеров
+        CountingMemoryResource term_dictionary_memory_;
+        CountingMemoryResource inverted_index_memory_;
+        CountingMemoryResource positional_index_memory_;
+        CountingMemoryResource forward_index_memory_;
+        CountingMemoryResource document_metadata_memory_;
+        CountingMemoryResource stop_words_memory_;
+
+        // Слова индекса и их идентификаторы. Идентификатор — номер слова в term_words_, слова не удаляются
+        std::pmr::map<std::pmr::string, uint32_t, std::less<>> words_{&term_dictionary_memory_};
+        TermWords term_words_{&term_dictionary_memory_};
+        std::pmr::set<std::pmr::string, std::less<>> stop_words_{&stop_words_memory_};
+        // Скомпилированная копия stop_words_ для IsStopWord, обновляется CompileStopWords
+        StopWordSet stop_word_set_{&stop_words_memory_};
+        // Статистика для GetIndexStats. Поиск константен и может идти из разных потоков, поэтому слова запросов
+        // пишутся в скетчи под своими мьютексами, а GetIndexStats сливает их
+        struct QueryTermSketch
+        {
+            std::mutex mutex;
+            SpaceSavingSketch sketch{QUERY_TERM_SKETCH_CAPACITY};
+        };
+        mutable std::array<QueryTermSketch, QUERY_TERM_SKETCH_SHARD_COUNT> query_term_sketches_;
+        std::vector<VocabularyPoint> vocabulary_growth_;
+        uint64_t added_document_count_ = 0;
+        uint64_t vocabulary_sample_interval_ = VOCABULARY_SAMPLE_INTERVAL;
+
+        // Документы, ожидающие перестройки после ChangeStopWords, и источник текстов для переиндексации
+        std::deque<int> stop_word_rebuild_queue_;
+        DocumentTextSource stop_word_text_source_;
+        Tokenizer tokenizer_;
+        std::pmr::map<std::string_view, PostingList> word_to_document_freqs_{&inverted_index_memory_};
+        // Прямой индекс: слова документа с числом вхождений, отсортированные по идентификатору
+        std::pmr::map<int, TermCounts> document_terms_{&forward_index_memory_};
+        std::pmr::map<std::string_view, std::pmr::map<int, std::pmr::vector<int>>> word_to_document_positions_{&positional_index_memory_};
+        std::pmr::map<int, DocumentData> documents_{&document_metadata_memory_};
+        std::pmr::set<int> document_ids_{&document_metadata_memory_};
+        // Индексы атрибутов для DocumentFilter: документы по статусу и по значению рейтинга
+        std::pmr::map<DocumentStatus, RoaringBitmap> status_to_documents_{&document_metadata_memory_};
+        std::pmr::map<int, RoaringBitmap> rating_to_documents_{&document_metadata_memory_};
+        uint64_t total_document_length_ = 0;
+        uint64_t index_version_ = 0;
+        bool positional_index_enabled_ = true;
+        TermFreqPrecision term_freq_precision_ = TermFreqPrecision::EXACT;
+        int fuzzy_max_distance_ = 0;
+        ExecutionThresholds execution_thresholds_ = GetCalibratedExecutionThresholds();
+
+        // Словарь строится по words_ при первом запросе с шаблоном после изменения словаря
+        mutable std::mutex term_dictionary_mutex_;
+        mutable std::shared_ptr<const TermDictionary> term_dictionary_;
+
+        std::shared_ptr<const TermDictionary> GetTermDictionary() const;
 
         bool IsStopWord(std::string_view word) const;
-        std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text);
+        void AddStopWord(std::string_view word);
+        void CompileStopWords();
+        // Удаляет из документа слова, ставшие стоп-словами, пересчитывая TF остальных слов и сдвигая их позиции
+        void RemoveStopWordsFromDocument(int document_id);
+        // Переиндексирует документ по тексту из stop_word_text_source_. Текст получается и проверяется до удаления
+        // старых данных документа, поэтому при ошибке документ остаётся в индексе прежним
+        void ReindexDocument(int document_id);
+        std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text, std::string& buffer) const;
+        // Вставка разбитого на слова документа в индекс, общая для AddDocument, AddDocuments и переиндексации.
+        // Версию индекса и счётчик добавленных документов меняют вызывающие
+        void IndexDocument(int document_id, const std::vector<std::string_view>& words, DocumentStatus status, const std::vector<int>& ratings);
         static int ComputeAverageRating(const std::vector<int>& ratings);
+        // Учитывает добавленные документы и записывает точку роста словаря, когда пройден очередной интервал
+        void CountAddedDocuments(uint64_t count);
 
         struct QueryWord
         {
             std::string_view data;
             bool is_minus;
-            bool is_stop;
+            bool is_required;
         };
 
         QueryWord ParseQueryWord(std::string_view text) const;
 
+        struct WeightedWord
+        {
+            std::string_view data;
+            double weight;
+        };
+
+        // Обычные слова запроса объединяются по ИЛИ, +слова и группы +слово|слово обязательны (И),
+        // фраза в кавычках обязательна и требует, чтобы её слова шли в документе подряд.
+        // Слова с '*' и '?' раскрываются по словарю в expanded_words с весом меньше единицы.
+        // Нормализованные слова запроса хранятся в word_buffers, остальные поля указывают в них или в индекс
         struct Query
         {
+            std::deque<std::string> word_buffers;
             std::vector<std::string_view> plus_words;
             std::vector<std::string_view> minus_words;
+            std::vector<std::vector<std::string_view>> required_groups;
+            std::vector<std::vector<std::string_view>> phrases;
+            std::vector<WeightedWord> expanded_words;
         };
 
+        std::vector<std::string_view> ExtractPhrases(std::string_view text, Query& query) const;
+        void AddQueryWord(const QueryWord& query_word, Query& query) const;
+        std::vector<std::string_view> NormalizeQueryWord(std::string_view word, Query& query, bool keep_wildcards = true) const;
+        static bool IsExpandableWord(std::string_view word);
+        // Не более max_count слов словаря, подходящих под шаблон. Раскрытие для релевантности обходит не больше
+        // MAX_TERM_DICTIONARY_VISITS узлов словаря, полное раскрытие (max_count == SIZE_MAX) — весь словарь
+        std::vector<WeightedWord> ExpandWord(std::string_view pattern, size_t max_count) const;
+        bool IsFuzzyCandidate(std::string_view word) const;
+        std::vector<WeightedWord> ExpandFuzzyWord(std::string_view word) const;
+        static void RemoveDuplicateExpansions(Query& query);
+        static void RemoveDuplicateQueryWords(Query& query);
+
         Query ParseQuery(std::string_view text) const;
-        Query ParseQuery(const std::execution::sequenced_policy&, std::string_view text) const;
-        Query ParseQuery(const std::execution::parallel_policy&, std::string_view text) const;
 
-        double ComputeWordInverseDocumentFreq(std::string_view word) const;
+        // Слова запроса для матчинга, заменённые отсортированными идентификаторами. Слов, которых нет в индексе, здесь нет
+        struct MatchQuery
+        {
+            Query query;
+            std::vector<uint32_t> plus_terms;
+            std::vector<uint32_t> expanded_terms;
+            std::vector<uint32_t> minus_terms;
+        };
+
+        size_t EstimateQueryCost(const Query& query) const;
+        void RecordQueryTerms(const Query& query) const;
 
-        template <typename DocumentPredicate>
-        std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
-        template <typename DocumentPredicate>
-        std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy&, const Query& query, DocumentPredicate document_predicate) const;
-        template <typename DocumentPredicate>
-        std::vector<Document> FindAllDocuments(const std::execution::parallel_policy&, const Query& query, DocumentPredicate document_predicate) const;
+        MatchQuery PrepareMatchQuery(std::string_view raw_query) const;
+        std::tuple<std::vector<std::string_view>, DocumentStatus> MatchPreparedQuery(const MatchQuery& match_query, int document_id) const;
+        uint32_t GetTermId(std::string_view word) const;
+
+        // Постинги слова запроса с IDF и весом слова
+        struct WeightedPostings
+        {
+            const PostingList* postings;
+            double inverse_document_freq;
+            double weight;
+        };
+
+        template <typename Ranker>
+        std::vector<WeightedPostings> GetWeightedPostings(const Query& query) const;
+        template <typename Ranker>
+        double ComputePostingRelevance(const WeightedPostings& word, int document_id, double term_freq, double average_document_length) const;
+        // Документы, которые могут попасть в выдачу: при is_restricted только allowed, иначе все, кроме excluded
+        struct CandidateDocuments
+        {
+            RoaringBitmap allowed;
+            RoaringBitmap excluded;
+            bool is_restricted = false;
+
+            bool IsUnrestricted() const;
+            bool Contains(int document_id) const;
+        };
+
+        // Возвращает false, если control остановил запрос раньше, чем обойдены все постинги
+        template <typename Ranker, typename Scores>
+        bool AccumulatePostings(const WeightedPostings& word, size_t first, size_t last, double average_document_length,
+                                const CandidateDocuments& candidates, Scores& scores, const QueryControl& control) const;
+        double ComputeAverageDocumentLength() const;
+
+        RoaringBitmap FindFilteredDocuments(const DocumentFilter& filter) const;
+        RoaringBitmap FindExcludedDocuments(const Query& query) const;
+        // Минус-слова, обязательные слова и фильтр, если он задан, сводятся в одно множество кандидатов
+        CandidateDocuments FindCandidateDocuments(const Query& query, const DocumentFilter* filter) const;
+        void RemoveDocumentAttributes(int document_id);
+
+        // Перебирает документы фильтра с id из [first_id, last_id) с поиском в постингах
+        template <typename Function>
+        static void ForEachAllowedPosting(const PostingList& postings, const RoaringBitmap& allowed_documents, int64_t first_id, int64_t last_id, Function function);
+
+        std::vector<int> GetDocumentIds(std::string_view word) const;
+        std::optional<std::vector<int>> FindRequiredDocuments(const Query& query) const;
+        bool HasPhrase(const std::vector<std::string_view>& phrase, int document_id) const;
+        bool IsMatchingRequiredWords(const Query& query, int document_id) const;
+
+        using DocumentOrder = bool (*)(const Document& lhs, const Document& rhs);
+
+        // Общий движок всех перегрузок FindTopDocuments. При max_strategy == PARALLEL стратегия выбирается по стоимости запроса.
+        // С after отбираются только документы, стоящие в выдаче после него в порядке is_ranked_before
+        template <typename Ranker, typename DocumentPredicate>
+        SearchResult RunQuery(std::string_view raw_query, DocumentPredicate document_predicate, ExecutionStrategy max_strategy, const QueryControl& control,
+                              size_t max_count = MAX_RESULT_DOCUMENT_COUNT, const Document* after = nullptr, DocumentOrder is_ranked_before = IsRankedBefore) const;
+        template <typename Ranker, typename DocumentPredicate>
+        std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate, ExecutionStrategy strategy, const QueryControl& control) const;
+        // Оставляет max_count лучших документов в порядке is_ranked_before
+        static void SelectTopDocuments(std::vector<Document>& documents, size_t max_count = MAX_RESULT_DOCUMENT_COUNT, DocumentOrder is_ranked_before = IsRankedBefore);
 
         static bool IsValidWord(std::string_view word);
 
         static bool IsValidSearchMinusWord(std::string_view word);
         void ValidateStopWord(std::string_view stop_word);
-        void ValidateNewDocument(const int document_id, std::string_view document) const;
+        static void ValidateDocumentText(std::string_view document);
         void ValidateWordQuery(std::string_view word) const;
-        void ValidateDocumentIndex(const size_t index) const;
+        void ValidateDocumentIds(const std::vector<int>& document_ids) const;
+
+        void RemoveDocument(int document_id, ExecutionStrategy max_strategy);
+        std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids, ExecutionStrategy max_strategy) const;
 };
 
 
 template <typename StringContainer>
-SearchServer::SearchServer(const StringContainer& stop_words) : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
+SearchServer::SearchServer(const StringContainer& stop_words)
 {
-    for(std::string_view word : stop_words)
+    for(std::string_view word : MakeUniqueNonEmptyStrings(stop_words))
     {
-        ValidateStopWord(word);
-        stop_words_.insert(static_cast<std::string>(word));
+        AddStopWord(word);
     }
+    CompileStopWords();
 }
 
-template <typename DocumentPredicate>
+template <typename Ranker, typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const
 {
-    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+    const ExecutionStrategy max_strategy = std::is_same_v<DocumentPredicate, DocumentFilter> ? ExecutionStrategy::PARALLEL : ExecutionStrategy::SEQUENTIAL;
+    return RunQuery<Ranker>(raw_query, document_predicate, max_strategy, QueryControl()).documents;
 }
 
-template <typename DocumentPredicate>
+template <typename Ranker, typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(const std::execution::sequenced_policy&, std::string_view raw_query, DocumentPredicate document_predicate) const
 {
-    Query query = ParseQuery(raw_query);
+    return RunQuery<Ranker>(raw_query, document_predicate, ExecutionStrategy::SEQUENTIAL, QueryControl()).documents;
+}
 
-    std::sort(query.minus_words.begin(), query.minus_words.end());
-    auto last_minus = std::unique(query.minus_words.begin(), query.minus_words.end());
-    query.minus_words.erase(last_minus, query.minus_words.end());
+template <typename Ranker, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query, DocumentPredicate document_predicate) const
+{
+    return RunQuery<Ranker>(raw_query, document_predicate, ExecutionStrategy::PARALLEL, QueryControl()).documents;
+}
 
-    std::sort(query.plus_words.begin(), query.plus_words.end());
-    auto last_plus = std::unique(query.plus_words.begin(), query.plus_words.end());
-    query.plus_words.erase(last_plus, query.plus_words.end());
+template <typename Ranker, typename DocumentPredicate>
+SearchResult SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, const QueryControl& control) const
+{
+    const ExecutionStrategy max_strategy = std::is_same_v<DocumentPredicate, DocumentFilter> ? ExecutionStrategy::PARALLEL : ExecutionStrategy::SEQUENTIAL;
+    return RunQuery<Ranker>(raw_query, document_predicate, max_strategy, control);
+}
 
-    auto matched_documents = FindAllDocuments(std::execution::seq, query, document_predicate);
+template <typename Ranker, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindRankedDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count) const
+{
+    const ExecutionStrategy max_strategy = std::is_same_v<DocumentPredicate, DocumentFilter> ? ExecutionStrategy::PARALLEL : ExecutionStrategy::SEQUENTIAL;
+    return RunQuery<Ranker>(raw_query, document_predicate, max_strategy, QueryControl(), max_count, nullptr, IsRankedStrictlyBefore).documents;
+}
 
-    sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs)
+template <typename Ranker, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindRankedDocuments(std::string_view raw_query, DocumentPredicate document_predicate, const Document& last, size_t max_count) const
+{
+    const ExecutionStrategy max_strategy = std::is_same_v<DocumentPredicate, DocumentFilter> ? ExecutionStrategy::PARALLEL : ExecutionStrategy::SEQUENTIAL;
+    return RunQuery<Ranker>(raw_query, document_predicate, max_strategy, QueryControl(), max_count, &last, IsRankedStrictlyBefore).documents;
+}
+
+template <typename Ranker, typename DocumentPredicate>
+SearchResult SearchServer::RunQuery(std::string_view raw_query, DocumentPredicate document_predicate, ExecutionStrategy max_strategy, const QueryControl& control,
+                                    size_t max_count, const Document* after, DocumentOrder is_ranked_before) const
+{
+    Query query = ParseQuery(raw_query);
+    RemoveDuplicateQueryWords(query);
+    // Продолжение выдачи после after — тот же логический запрос, он уже учтён
+    if(after == nullptr)
     {
-        if (std::abs(lhs.relevance - rhs.relevance) < COMPARISON_ERROR)
+        RecordQueryTerms(query);
+    }
+
+    const ExecutionStrategy strategy = max_strategy == ExecutionStrategy::PARALLEL ? ChooseExecutionStrategy(EstimateQueryCost(query)) : ExecutionStrategy::SEQUENTIAL;
+
+    SearchResult result;
+    result.documents = FindAllDocuments<Ranker>(query, document_predicate, strategy, control);
+    result.is_complete = !control.WasStopped();
+    if(after != nullptr)
+    {
+        result.documents.erase(std::remove_if(result.documents.begin(), result.documents.end(),
+                                              [after, is_ranked_before](const Document& document) { return !is_ranked_before(*after, document); }),
+                               result.documents.end());
+    }
+    SelectTopDocuments(result.documents, max_count, is_ranked_before);
+
+    return result;
+}
+
+template <typename Ranker>
+QueryPlan SearchServer::ExplainQuery(std::string_view raw_query, const DocumentFilter& filter) const
+{
+    using Clock = std::chrono::steady_clock;
+
+    QueryPlan plan;
+    auto stage_start = Clock::now();
+
+    Query query = ParseQuery(raw_query);
+    RemoveDuplicateQueryWords(query);
+    plan.parse_time = Clock::now() - stage_start;
+
+    plan.filtered_document_count = FindFilteredDocuments(filter).Cardinality();
+    const auto add_term = [this, &plan](std::string_view word, QueryTermKind kind, double weight) {
+        QueryPlanTerm term{std::string(word), kind, 0, 0.0, weight, PostingAccess::SCAN};
+        if(const auto it = word_to_document_freqs_.find(word); it != word_to_document_freqs_.end())
         {
-            return lhs.rating > rhs.rating;
+            term.posting_count = it->second.size();
         }
-        else
+        if(kind != QueryTermKind::MINUS && term.posting_count > 0)
         {
-            return lhs.relevance > rhs.relevance;
+            term.inverse_document_freq = Ranker::ComputeInverseDocumentFreq(GetDocumentCount(), term.posting_count);
+            if(plan.filtered_document_count * GALLOPING_RATIO < term.posting_count)
+            {
+                term.access = PostingAccess::FILTER_LOOKUP;
+            }
         }
-    });
+        plan.terms.push_back(std::move(term));
+    };
 
-    if(matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT)
+    for(std::string_view word : query.plus_words)
+    {
+        add_term(word, QueryTermKind::PLUS, 1.0);
+    }
+    for(const auto& [word, weight] : query.expanded_words)
+    {
+        add_term(word, QueryTermKind::EXPANDED, weight);
+    }
+    for(std::string_view word : query.minus_words)
     {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+        add_term(word, QueryTermKind::MINUS, 1.0);
     }
 
-    return matched_documents;
-}
+    plan.required_group_count = query.required_groups.size();
+    plan.phrase_count = query.phrases.size();
+    plan.estimated_cost = EstimateQueryCost(query);
+    plan.strategy = ChooseExecutionStrategy(plan.estimated_cost);
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(const std::execution::parallel_policy&, std::string_view raw_query, DocumentPredicate document_predicate) const
-{
-    Query query = ParseQuery(std::execution::par, raw_query);
+    stage_start = Clock::now();
+    plan.documents = FindAllDocuments<Ranker>(query, filter, plan.strategy, QueryControl());
+    plan.scoring_time = Clock::now() - stage_start;
+    plan.matched_document_count = plan.documents.size();
 
-    std::sort(query.minus_words.begin(), query.minus_words.end());
-    auto last_minus = std::unique(query.minus_words.begin(), query.minus_words.end());
-    query.minus_words.erase(last_minus, query.minus_words.end());
+    stage_start = Clock::now();
+    SelectTopDocuments(plan.documents);
+    plan.ranking_time = Clock::now() - stage_start;
 
-    std::sort(query.plus_words.begin(), query.plus_words.end());
-    auto last_plus = std::unique(query.plus_words.begin(), query.plus_words.end());
-    query.plus_words.erase(last_plus, query.plus_words.end());
+    return plan;
+}
 
-    auto matched_documents = FindAllDocuments(std::execution::par, query, document_predicate);
+template <typename Ranker>
+std::vector<SearchServer::WeightedPostings> SearchServer::GetWeightedPostings(const Query& query) const
+{
+    std::vector<WeightedPostings> weighted_postings;
 
-    sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs)
-    {
-        if (std::abs(lhs.relevance - rhs.relevance) < COMPARISON_ERROR)
+    const auto add_word = [this, &weighted_postings](std::string_view word, double weight) {
+        const auto it = word_to_document_freqs_.find(word);
+        if(it != word_to_document_freqs_.end() && !it->second.empty())
         {
-            return lhs.rating > rhs.rating;
+            weighted_postings.push_back({&it->second, Ranker::ComputeInverseDocumentFreq(GetDocumentCount(), it->second.size()), weight});
         }
-        else
-        {
-            return lhs.relevance > rhs.relevance;
-        }
-    });
+    };
 
-    if(matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT)
+    for(std::string_view word : query.plus_words)
     {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+        add_word(word, 1.0);
     }
 
-    return matched_documents;
+    for(const auto& [word, weight] : query.expanded_words)
+    {
+        add_word(word, weight);
+    }
+
+    return weighted_postings;
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const
+template <typename Ranker>
+double SearchServer::ComputePostingRelevance(const WeightedPostings& word, int document_id, double term_freq, double average_document_length) const
 {
-    return FindAllDocuments(std::execution::seq, query, document_predicate);
+    if constexpr (Ranker::IS_LINEAR_IN_TERM_FREQ)
+    {
+        return term_freq * Ranker::ComputeRelevance(1.0, word.inverse_document_freq, 0, average_document_length) * word.weight;
+    }
+    else
+    {
+        return Ranker::ComputeRelevance(term_freq, word.inverse_document_freq, documents_.at(document_id).length, average_document_length) * word.weight;
+    }
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy&, const Query& query, DocumentPredicate document_predicate) const
+// Постинги [first, last) обрабатываются кусками: вклады считаются ядром в плотный массив и прибавляются к буферу по id.
+// Документы, не входящие в кандидаты, в буфер не попадают, а для нелинейных политик их вклад и не считается
+template <typename Ranker, typename Scores>
+bool SearchServer::AccumulatePostings(const WeightedPostings& word, size_t first, size_t last, double average_document_length,
+                                      const CandidateDocuments& candidates, Scores& scores, const QueryControl& control) const
 {
-    std::map<int, double> document_to_relevance;
+    std::array<double, SCORE_KERNEL_CHUNK_SIZE> contributions;
+    std::array<int, SCORE_KERNEL_CHUNK_SIZE> candidate_ids;
+    const int* document_ids = word.postings->GetDocumentIds().data();
+    const bool checks_candidates = !candidates.IsUnrestricted();
 
-    for(std::string_view word : query.plus_words)
+    for(size_t begin = first; begin < last; begin += SCORE_KERNEL_CHUNK_SIZE)
     {
-        if(word_to_document_freqs_.count(word) == 0)
+        if(control.ShouldStop())
         {
-            continue;
+            return false;
         }
 
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
+        const size_t count = std::min(SCORE_KERNEL_CHUNK_SIZE, last - begin);
+        size_t candidate_count = 0;
 
-        for(const auto [document_id, term_freq] : word_to_document_freqs_.at(word))
+        if constexpr (Ranker::IS_LINEAR_IN_TERM_FREQ)
         {
-            const auto& document_data = documents_.at(document_id);
-            if(document_predicate(document_id, document_data.status, document_data.rating))
+            const double factor = Ranker::ComputeRelevance(1.0, word.inverse_document_freq, 0, average_document_length) * word.weight;
+            word.postings->ScaleTermFreqs(begin, count, factor, contributions.data());
+            if(!checks_candidates)
             {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
+                scores.Add(document_ids + begin, contributions.data(), count);
+                continue;
             }
-        }
-    }
 
-    for(std::string_view word : query.minus_words)
-    {
-        if(word_to_document_freqs_.count(word) == 0)
-        {
-            continue;
+            // Ядро считает весь кусок, после чего вклады кандидатов сдвигаются к началу
+            for(size_t i = 0; i < count; ++i)
+            {
+                if(candidates.Contains(document_ids[begin + i]))
+                {
+                    candidate_ids[candidate_count] = document_ids[begin + i];
+                    contributions[candidate_count++] = contributions[i];
+                }
+            }
         }
-
-        for (const auto [document_id, _] : word_to_document_freqs_.at(word))
+        else
         {
-            document_to_relevance.erase(document_id);
+            for(size_t i = 0; i < count; ++i)
+            {
+                const int document_id = document_ids[begin + i];
+                if(!checks_candidates || candidates.Contains(document_id))
+                {
+                    candidate_ids[candidate_count] = document_id;
+                    contributions[candidate_count++] = ComputePostingRelevance<Ranker>(word, document_id, word.postings->GetTermFreq(begin + i), average_document_length);
+                }
+            }
         }
-    }
 
-    std::vector<Document> matched_documents;
-    for(const auto [document_id, relevance] : document_to_relevance)
-    {
-        matched_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
+        scores.Add(candidate_ids.data(), contributions.data(), candidate_count);
     }
 
-    return matched_documents;
+    return true;
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy&, const Query& query, DocumentPredicate document_predicate) const
+template <typename Ranker, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate, ExecutionStrategy strategy, const QueryControl& control) const
 {
-    ConcurrentMap<int, double> cm_document_to_relevance(NUMBER_PARTS_PARALLEL_MAP);
+    if(documents_.empty())
+    {
+        return {};
+    }
+
+    // Документы с минус-словами, без обязательных слов и не прошедшие DocumentFilter отбрасываются до подсчёта релевантности.
+    // Произвольному предикату нужны данные документа, поэтому он проверяется один раз на документ после подсчёта
+    const DocumentFilter* filter = nullptr;
+    if constexpr (std::is_same_v<DocumentPredicate, DocumentFilter>)
+    {
+        filter = &document_predicate;
+    }
+    const CandidateDocuments candidates = FindCandidateDocuments(query, filter);
+    if(candidates.is_restricted && candidates.allowed.IsEmpty())
+    {
+        return {};
+    }
+    const size_t allowed_count = candidates.is_restricted ? candidates.allowed.Cardinality() : 0;
+    const double average_document_length = ComputeAverageDocumentLength();
+    const std::vector<WeightedPostings> weighted_postings = GetWeightedPostings<Ranker>(query);
+
+    // Пространство id делится на части, каждая часть считается своим потоком без блокировок; последовательное выполнение — это одна часть.
+    // Вклады копятся в плотном буфере, и части делят его по границам блоков. Каталог блоков занимает указатель на SCORE_BLOCK_SIZE id,
+    // поэтому при редких id, когда блоков больше, чем документов, каждая часть копит вклады в своём разреженном буфере
+    const int64_t id_count = int64_t{documents_.rbegin()->first} + 1;
+    const bool is_dense = static_cast<uint64_t>((id_count + SCORE_BLOCK_SIZE - 1) / SCORE_BLOCK_SIZE) <= documents_.size();
+    const int64_t unit_size = is_dense ? SCORE_BLOCK_SIZE : 1;
+    const int64_t unit_count = (id_count + unit_size - 1) / unit_size;
+    const int part_count = strategy == ExecutionStrategy::PARALLEL ? static_cast<int>(std::min<int64_t>(NUMBER_PARTS_PARALLEL_MAP, unit_count)) : 1;
+
+    std::optional<ScoreBuffer> dense_scores;
+    if(is_dense)
+    {
+        dense_scores.emplace(static_cast<int>(id_count - 1));
+    }
+    std::vector<std::vector<Document>> part_documents(part_count);
 
-    std::for_each(std::execution::par, query.plus_words.begin(), query.plus_words.end(), [this, &document_predicate, &cm_document_to_relevance](std::string_view word){
-        if(word_to_document_freqs_.count(word) == 0)
+    // После остановки по сроку или отмене ранжируются документы, набранные к этому моменту
+    const auto accumulate = [&](auto& scores, int64_t first_id, int64_t last_id) {
+        for(const WeightedPostings& word : weighted_postings)
         {
-            return;
+            if(control.ShouldStop())
+            {
+                return;
+            }
+
+            if(candidates.is_restricted && allowed_count * GALLOPING_RATIO < word.postings->size())
+            {
+                ForEachAllowedPosting(*word.postings, candidates.allowed, first_id, last_id, [&](int document_id, double term_freq) {
+                    scores.Add(document_id, ComputePostingRelevance<Ranker>(word, document_id, term_freq, average_document_length));
+                });
+            }
+            else
+            {
+                const auto& document_ids = word.postings->GetDocumentIds();
+                const size_t first = std::lower_bound(document_ids.begin(), document_ids.end(), first_id) - document_ids.begin();
+                const size_t last = std::lower_bound(document_ids.begin() + first, document_ids.end(), last_id) - document_ids.begin();
+                if(!AccumulatePostings<Ranker>(word, first, last, average_document_length, candidates, scores, control))
+                {
+                    return;
+                }
+            }
         }
+    };
 
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
+    const auto find_part_documents = [&](int part) {
+        const int64_t first_unit = unit_count * part / part_count;
+        const int64_t last_unit = unit_count * (part + 1) / part_count;
+        std::vector<Document>& documents = part_documents[part];
 
-        for(const auto [document_id, term_freq] : word_to_document_freqs_.at(word))
-        {
+        const auto add_document = [&](int document_id, double relevance) {
             const auto& document_data = documents_.at(document_id);
-            if(document_predicate(document_id, document_data.status, document_data.rating))
+            if constexpr (!std::is_same_v<DocumentPredicate, DocumentFilter>)
             {
-                cm_document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
+                if(!document_predicate(document_id, document_data.status, document_data.rating))
+                {
+                    return;
+                }
             }
-        }
-    });
 
-    std::map<int, double> document_to_relevance = cm_document_to_relevance.BuildOrdinaryMap();
+            documents.push_back({document_id, relevance, document_data.rating});
+        };
 
-    std::for_each(std::execution::par, query.minus_words.begin(), query.minus_words.end(), [this, &document_to_relevance](std::string_view word){
-        if(word_to_document_freqs_.count(word) == 0)
+        if(dense_scores)
         {
-            return;
+            accumulate(*dense_scores, first_unit * unit_size, last_unit * unit_size);
+            dense_scores->ForEach(static_cast<int>(first_unit), static_cast<int>(last_unit), add_document);
         }
-
-        for (const auto [document_id, _] : word_to_document_freqs_.at(word))
+        else
         {
-            document_to_relevance.erase(document_id);
+            SparseScoreBuffer scores;
+            accumulate(scores, first_unit, last_unit);
+            scores.ForEach(add_document);
         }
-    });
+    };
+
+    if(part_count == 1)
+    {
+        find_part_documents(0);
+        return std::move(part_documents.front());
+    }
+
+    std::vector<int> parts(part_count);
+    std::iota(parts.begin(), parts.end(), 0);
+    std::for_each(std::execution::par, parts.begin(), parts.end(), find_part_documents);
 
     std::vector<Document> matched_documents;
-    for(const auto [document_id, relevance] : document_to_relevance)
+    for(auto& documents : part_documents)
     {
-        matched_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
+        matched_documents.insert(matched_documents.end(), documents.begin(), documents.end());
     }
 
     return matched_documents;
 }
+
+// Узкий фильтр: перебираются документы фильтра с поиском в постингах
+template <typename Function>
+void SearchServer::ForEachAllowedPosting(const PostingList& postings, const RoaringBitmap& allowed_documents, int64_t first_id, int64_t last_id, Function function)
+{
+    allowed_documents.ForEachInRange(static_cast<uint64_t>(first_id), static_cast<uint64_t>(last_id), [&postings, &function](uint32_t document_id) {
+        const auto it = postings.Find(static_cast<int>(document_id));
+        if(it != postings.end())
+        {
+            const auto [found_id, term_freq] = *it;
+            function(found_id, term_freq);
+        }
+    });
+}
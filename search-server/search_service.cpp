@@ -0,0 +1,538 @@
+#include "search_service.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <execution>
+#include <numeric>
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace
+{
+    bool EqualsIgnoreCase(std::string_view left, std::string_view right)
+    {
+        return left.size() == right.size() && std::equal(left.begin(), left.end(), right.begin(), [](char a, char b) {
+            return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+        });
+    }
+
+    std::string_view TrimSpaces(std::string_view text)
+    {
+        while(!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+        {
+            text.remove_prefix(1);
+        }
+        while(!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+        {
+            text.remove_suffix(1);
+        }
+
+        return text;
+    }
+
+    std::string_view GetReasonPhrase(int status)
+    {
+        switch(status)
+        {
+            case 200:
+                return "OK"sv;
+            case 400:
+                return "Bad Request"sv;
+            case 404:
+                return "Not Found"sv;
+            case 405:
+                return "Method Not Allowed"sv;
+            case 503:
+                return "Service Unavailable"sv;
+            default:
+                return "Internal Server Error"sv;
+        }
+    }
+
+    int ParseIntParam(std::string_view text, std::string_view name)
+    {
+        int value = 0;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if(text.empty() || error != std::errc() || end != text.data() + text.size())
+        {
+            throw std::invalid_argument("Некорректный параметр "s + std::string(name) + "."s);
+        }
+
+        return value;
+    }
+
+    const std::string& GetRequiredParam(const HttpRequest& request, std::string_view name)
+    {
+        const auto it = request.params.find(name);
+        if(it == request.params.end())
+        {
+            throw std::invalid_argument("Не задан параметр "s + std::string(name) + "."s);
+        }
+
+        return it->second;
+    }
+
+    DocumentStatus GetStatusParam(const HttpRequest& request)
+    {
+        const auto it = request.params.find("status"sv);
+        if(it == request.params.end())
+        {
+            return DocumentStatus::ACTUAL;
+        }
+
+        const std::optional<DocumentStatus> status = ParseDocumentStatus(it->second);
+        if(!status)
+        {
+            throw std::invalid_argument("Некорректный параметр status."s);
+        }
+
+        return *status;
+    }
+
+    void AppendJsonString(std::string& out, std::string_view text)
+    {
+        static const char HEX_DIGITS[] = "0123456789abcdef";
+
+        out.push_back('"');
+        for(const char c : text)
+        {
+            if(c == '"' || c == '\\')
+            {
+                out.push_back('\\');
+                out.push_back(c);
+            }
+            else if(static_cast<unsigned char>(c) < 0x20)
+            {
+                out += "\\u00"sv;
+                out.push_back(HEX_DIGITS[c >> 4]);
+                out.push_back(HEX_DIGITS[c & 0xF]);
+            }
+            else
+            {
+                out.push_back(c);
+            }
+        }
+        out.push_back('"');
+    }
+
+    HttpResponse MakeErrorResponse(int status, std::string_view message)
+    {
+        HttpResponse response{status, "{\"error\": "s};
+        AppendJsonString(response.body, message);
+        response.body.push_back('}');
+        return response;
+    }
+
+    // Исключения сервера переводятся в коды HTTP: неверные данные — 400, неизвестный документ — 404
+    template <typename Handler>
+    HttpResponse HandleSafely(Handler handler)
+    {
+        try
+        {
+            return handler();
+        }
+        catch(const std::out_of_range& error)
+        {
+            return MakeErrorResponse(404, error.what());
+        }
+        catch(const std::invalid_argument& error)
+        {
+            return MakeErrorResponse(400, error.what());
+        }
+        catch(const std::exception& error)
+        {
+            return MakeErrorResponse(500, error.what());
+        }
+    }
+}
+
+std::string EncodeUrl(std::string_view text)
+{
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+    std::string encoded;
+    encoded.reserve(text.size());
+    for(const char c : text)
+    {
+        const unsigned char byte = static_cast<unsigned char>(c);
+        if(std::isalnum(byte) || c == '-' || c == '_' || c == '.' || c == '~')
+        {
+            encoded.push_back(c);
+        }
+        else
+        {
+            encoded.push_back('%');
+            encoded.push_back(HEX_DIGITS[byte >> 4]);
+            encoded.push_back(HEX_DIGITS[byte & 0xF]);
+        }
+    }
+
+    return encoded;
+}
+
+std::string DecodeUrl(std::string_view text)
+{
+    std::string decoded;
+    decoded.reserve(text.size());
+    for(size_t i = 0; i < text.size(); ++i)
+    {
+        if(text[i] == '+')
+        {
+            decoded.push_back(' ');
+        }
+        else if(text[i] == '%')
+        {
+            unsigned int byte = 0;
+            const char* digits_end = text.data() + std::min(i + 3, text.size());
+            const auto [end, error] = std::from_chars(text.data() + i + 1, digits_end, byte, 16);
+            if(i + 3 > text.size() || error != std::errc() || end != digits_end)
+            {
+                throw std::invalid_argument("Некорректная последовательность % в адресе запроса."s);
+            }
+            decoded.push_back(static_cast<char>(byte));
+            i += 2;
+        }
+        else
+        {
+            decoded.push_back(text[i]);
+        }
+    }
+
+    return decoded;
+}
+
+size_t ParseHttpRequest(std::string_view data, HttpRequest& request)
+{
+    const size_t header_end = data.find("\r\n\r\n"sv);
+    if(header_end == std::string_view::npos)
+    {
+        if(data.size() > HTTP_MAX_REQUEST_SIZE)
+        {
+            throw std::invalid_argument("Слишком большой заголовок запроса."s);
+        }
+        return 0;
+    }
+
+    std::string_view head = data.substr(0, header_end);
+    const size_t request_line_end = std::min(head.find("\r\n"sv), head.size());
+    const std::string_view request_line = head.substr(0, request_line_end);
+    head.remove_prefix(std::min(request_line_end + 2, head.size()));
+
+    const size_t method_end = request_line.find(' ');
+    const size_t target_end = request_line.rfind(' ');
+    if(method_end == std::string_view::npos || method_end == target_end)
+    {
+        throw std::invalid_argument("Некорректная строка запроса."s);
+    }
+    const std::string_view target = request_line.substr(method_end + 1, target_end - method_end - 1);
+    const std::string_view version = request_line.substr(target_end + 1);
+    if(version != "HTTP/1.1"sv && version != "HTTP/1.0"sv)
+    {
+        throw std::invalid_argument("Неподдерживаемая версия HTTP."s);
+    }
+
+    request.method = request_line.substr(0, method_end);
+    request.keep_alive = version == "HTTP/1.1"sv;
+    request.params.clear();
+    request.body.clear();
+
+    size_t content_length = 0;
+    while(!head.empty())
+    {
+        const size_t line_end = std::min(head.find("\r\n"sv), head.size());
+        const std::string_view line = head.substr(0, line_end);
+        head.remove_prefix(std::min(line_end + 2, head.size()));
+
+        const size_t colon = line.find(':');
+        if(colon == std::string_view::npos)
+        {
+            throw std::invalid_argument("Некорректный заголовок запроса."s);
+        }
+        const std::string_view name = TrimSpaces(line.substr(0, colon));
+        const std::string_view value = TrimSpaces(line.substr(colon + 1));
+
+        if(EqualsIgnoreCase(name, "Content-Length"sv))
+        {
+            const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), content_length);
+            if(error != std::errc() || end != value.data() + value.size() || content_length > HTTP_MAX_REQUEST_SIZE)
+            {
+                throw std::invalid_argument("Некорректная длина тела запроса."s);
+            }
+        }
+        else if(EqualsIgnoreCase(name, "Connection"sv))
+        {
+            request.keep_alive = EqualsIgnoreCase(value, "keep-alive"sv) || (request.keep_alive && !EqualsIgnoreCase(value, "close"sv));
+        }
+    }
+
+    const size_t request_size = header_end + 4 + content_length;
+    if(data.size() < request_size)
+    {
+        return 0;
+    }
+
+    const size_t query_begin = target.find('?');
+    request.path = DecodeUrl(target.substr(0, query_begin));
+    if(query_begin != std::string_view::npos)
+    {
+        for(std::string_view query = target.substr(query_begin + 1); !query.empty();)
+        {
+            const size_t param_end = std::min(query.find('&'), query.size());
+            const std::string_view param = query.substr(0, param_end);
+            query.remove_prefix(std::min(param_end + 1, query.size()));
+
+            const size_t equals = std::min(param.find('='), param.size());
+            if(!param.empty())
+            {
+                request.params[DecodeUrl(param.substr(0, equals))] = DecodeUrl(param.substr(std::min(equals + 1, param.size())));
+            }
+        }
+    }
+    request.body = data.substr(header_end + 4, content_length);
+
+    return request_size;
+}
+
+std::string SerializeHttpResponse(const HttpResponse& response, bool keep_alive)
+{
+    std::string out;
+    out.reserve(response.body.size() + 128);
+    out += "HTTP/1.1 "sv;
+    out += std::to_string(response.status);
+    out.push_back(' ');
+    out += GetReasonPhrase(response.status);
+    out += "\r\nContent-Type: application/json\r\nContent-Length: "sv;
+    out += std::to_string(response.body.size());
+    out += keep_alive ? "\r\nConnection: keep-alive\r\n\r\n"sv : "\r\nConnection: close\r\n\r\n"sv;
+    out += response.body;
+    return out;
+}
+
+SearchService::SearchService(SearchServer& search_server, WriteAheadLog* wal) : search_server_(search_server), wal_(wal)
+{
+}
+
+std::vector<HttpResponse> SearchService::HandleBatch(const std::vector<const HttpRequest*>& requests)
+{
+    if(is_diverged_from_log_)
+    {
+        return std::vector<HttpResponse>(requests.size(), MakeErrorResponse(503, "Индекс расходится с журналом изменений."sv));
+    }
+
+    std::vector<HttpResponse> responses(requests.size());
+    bool has_writes = false;
+
+    // Чтения между двумя изменениями не зависят друг от друга и выполняются параллельно
+    size_t read_begin = 0;
+    const auto handle_reads = [&](size_t read_end) {
+        std::vector<size_t> indexes(read_end - read_begin);
+        std::iota(indexes.begin(), indexes.end(), read_begin);
+        const auto handle_read = [this, &requests, &responses](size_t index) {
+            responses[index] = HandleRead(*requests[index]);
+        };
+        if(indexes.size() > 1)
+        {
+            std::for_each(std::execution::par, indexes.begin(), indexes.end(), handle_read);
+        }
+        else
+        {
+            std::for_each(indexes.begin(), indexes.end(), handle_read);
+        }
+    };
+
+    for(size_t i = 0; i < requests.size(); ++i)
+    {
+        if(!IsReadRequest(*requests[i]))
+        {
+            handle_reads(i);
+            responses[i] = HandleWrite(*requests[i]);
+            has_writes = true;
+            read_begin = i + 1;
+        }
+    }
+    handle_reads(requests.size());
+
+    if(has_writes && wal_ != nullptr)
+    {
+        // Применённые изменения пакета не сохранены на диск: их клиенты получают ошибку, а индекс, в котором они
+        // остались, больше не отдаётся — ни чтениям после первого из них, ни следующим пакетам
+        const HttpResponse sync_response = HandleSafely([this]() {
+            wal_->Sync();
+            return HttpResponse{};
+        });
+        if(sync_response.status != 200)
+        {
+            const HttpResponse diverged_response = MakeErrorResponse(503, "Индекс расходится с журналом изменений."sv);
+            for(size_t i = 0; i < requests.size(); ++i)
+            {
+                if(IsReadRequest(*requests[i]))
+                {
+                    if(is_diverged_from_log_)
+                    {
+                        responses[i] = diverged_response;
+                    }
+                }
+                else if(responses[i].status == 200)
+                {
+                    responses[i] = sync_response;
+                    is_diverged_from_log_ = true;
+                }
+            }
+        }
+    }
+
+    return responses;
+}
+
+HttpResponse SearchService::Handle(const HttpRequest& request)
+{
+    return std::move(HandleBatch({&request}).front());
+}
+
+bool SearchService::IsReadRequest(const HttpRequest& request)
+{
+    return request.method == "GET"sv;
+}
+
+HttpResponse SearchService::HandleRead(const HttpRequest& request) const
+{
+    return HandleSafely([this, &request]() {
+        HttpResponse response;
+
+        if(request.path == "/search"sv)
+        {
+            const std::vector<Document> documents = search_server_.FindTopDocuments(GetRequiredParam(request, "query"sv), GetStatusParam(request));
+
+            response.body.push_back('[');
+            for(const Document& document : documents)
+            {
+                if(response.body.size() > 1)
+                {
+                    response.body += ", "sv;
+                }
+                response.body += "{\"id\": "s + std::to_string(document.id) + ", \"relevance\": "s + std::to_string(document.relevance)
+                    + ", \"rating\": "s + std::to_string(document.rating) + "}"s;
+            }
+            response.body.push_back(']');
+        }
+        else if(request.path == "/match"sv)
+        {
+            const int document_id = ParseIntParam(GetRequiredParam(request, "id"sv), "id"sv);
+            const auto [words, status] = search_server_.MatchDocument(GetRequiredParam(request, "query"sv), document_id);
+
+            response.body = "{\"words\": ["s;
+            for(size_t i = 0; i < words.size(); ++i)
+            {
+                if(i > 0)
+                {
+                    response.body += ", "sv;
+                }
+                AppendJsonString(response.body, words[i]);
+            }
+            response.body += "], \"status\": "sv;
+            AppendJsonString(response.body, GetDocumentStatusName(status));
+            response.body.push_back('}');
+        }
+        else if(request.path == "/stats"sv)
+        {
+            const auto top_it = request.params.find("top"sv);
+            const int top_count = top_it == request.params.end() ? 20 : ParseIntParam(top_it->second, "top"sv);
+            if(top_count < 0)
+            {
+                throw std::invalid_argument("Некорректный параметр top."s);
+            }
+            const IndexStats stats = search_server_.GetIndexStats(top_count);
+
+            response.body = "{\"document_count\": "s + std::to_string(stats.document_count) + ", \"vocabulary_size\": "s + std::to_string(stats.vocabulary_size)
+                + ", \"live_term_count\": "s + std::to_string(stats.live_term_count) + ", \"posting_count\": "s + std::to_string(stats.posting_count)
+                + ", \"document_frequency_histogram\": ["s;
+            for(size_t i = 0; i < stats.document_frequency_histogram.size(); ++i)
+            {
+                response.body += (i > 0 ? ", "s : ""s) + std::to_string(stats.document_frequency_histogram[i]);
+            }
+            response.body += "], \"heaviest_terms\": ["sv;
+            for(size_t i = 0; i < stats.heaviest_terms.size(); ++i)
+            {
+                response.body += i > 0 ? ", {\"word\": "sv : "{\"word\": "sv;
+                AppendJsonString(response.body, stats.heaviest_terms[i].word);
+                response.body += ", \"document_count\": "s + std::to_string(stats.heaviest_terms[i].document_count) + "}"s;
+            }
+            response.body += "], \"costliest_query_terms\": ["sv;
+            for(size_t i = 0; i < stats.costliest_query_terms.size(); ++i)
+            {
+                response.body += i > 0 ? ", {\"word\": "sv : "{\"word\": "sv;
+                AppendJsonString(response.body, stats.costliest_query_terms[i].item);
+                response.body += ", \"posting_count\": "s + std::to_string(stats.costliest_query_terms[i].weight)
+                    + ", \"error\": "s + std::to_string(stats.costliest_query_terms[i].error) + "}"s;
+            }
+            response.body += "], \"vocabulary_growth\": ["sv;
+            for(size_t i = 0; i < stats.vocabulary_growth.size(); ++i)
+            {
+                response.body += (i > 0 ? ", [" : "[") + std::to_string(stats.vocabulary_growth[i].added_document_count) + ", "s
+                    + std::to_string(stats.vocabulary_growth[i].vocabulary_size) + "]"s;
+            }
+            response.body += "]}"sv;
+        }
+        else if(request.path == "/documents"sv)
+        {
+            return MakeErrorResponse(405, "Метод не поддерживается."sv);
+        }
+        else
+        {
+            return MakeErrorResponse(404, "Неизвестный адрес."sv);
+        }
+
+        return response;
+    });
+}
+
+HttpResponse SearchService::HandleWrite(const HttpRequest& request)
+{
+    return HandleSafely([this, &request]() {
+        if(request.path != "/documents"sv)
+        {
+            return MakeErrorResponse(request.path == "/search"sv || request.path == "/match"sv || request.path == "/stats"sv ? 405 : 404, "Неизвестный адрес."sv);
+        }
+
+        const int document_id = ParseIntParam(GetRequiredParam(request, "id"sv), "id"sv);
+        if(request.method == "POST"sv)
+        {
+            const DocumentStatus status = GetStatusParam(request);
+            std::vector<int> ratings;
+            if(const auto it = request.params.find("ratings"sv); it != request.params.end())
+            {
+                for(std::string_view rest = it->second; !rest.empty();)
+                {
+                    const size_t comma = std::min(rest.find(','), rest.size());
+                    ratings.push_back(ParseIntParam(rest.substr(0, comma), "ratings"sv));
+                    rest.remove_prefix(std::min(comma + 1, rest.size()));
+                }
+            }
+
+            // Изменение попадает в журнал раньше индекса: если запись в журнал не удалась, индекс не меняется
+            search_server_.ValidateNewDocument(document_id, request.body);
+            if(wal_ != nullptr)
+            {
+                wal_->LogAddDocument(document_id, request.body, status, ratings);
+            }
+            search_server_.AddDocument(document_id, request.body, status, ratings);
+        }
+        else if(request.method == "DELETE"sv)
+        {
+            search_server_.ValidateDocumentId(document_id);
+            if(wal_ != nullptr)
+            {
+                wal_->LogRemoveDocument(document_id);
+            }
+            search_server_.RemoveDocument(document_id);
+        }
+        else
+        {
+            return MakeErrorResponse(405, "Метод не поддерживается."sv);
+        }
+
+        return HttpResponse{200, "{\"id\": "s + std::to_string(document_id) + "}"s};
+    });
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "search_server.h"
+#include "write_ahead_log.h"
+
+// Запрос больше HTTP_MAX_REQUEST_SIZE байт отклоняется, чтобы клиент не мог занять всю память
+const size_t HTTP_MAX_REQUEST_SIZE = 16 * 1024 * 1024;
+
+struct HttpRequest
+{
+    std::string method;
+    std::string path;
+    // Параметры строки запроса после URL-декодирования
+    std::map<std::string, std::string, std::less<>> params;
+    std::string body;
+    bool keep_alive = true;
+};
+
+struct HttpResponse
+{
+    int status = 200;
+    std::string body;
+};
+
+// Разбирает запрос HTTP/1.1 в начале data. Возвращает число прочитанных байт или 0, если запрос ещё не пришёл целиком.
+// Некорректный запрос приводит к исключению invalid_argument
+size_t ParseHttpRequest(std::string_view data, HttpRequest& request);
+std::string SerializeHttpResponse(const HttpResponse& response, bool keep_alive);
+
+std::string EncodeUrl(std::string_view text);
+std::string DecodeUrl(std::string_view text);
+
+// Методы SearchServer поверх HTTP, ответы в JSON:
+// GET /search?query=...[&status=ACTUAL] — FindTopDocuments;
+// GET /match?query=...&id=N — MatchDocument;
+// POST /documents?id=N[&status=ACTUAL][&ratings=1,2,3] с текстом в теле — AddDocument;
+// DELETE /documents?id=N — RemoveDocument;
+// GET /stats[?top=20] — GetIndexStats.
+// Запросы обрабатываются пакетами: подряд идущие чтения выполняются параллельно, изменения — по одному между ними,
+// поэтому ответы совпадают с последовательным выполнением в порядке пакета. С журналом изменение записывается
+// в него до применения к индексу, и пакет с изменениями фиксируется одним fsync до отправки ответов.
+// Если фиксация не удалась, изменения пакета получают ответ 500. Применённые изменения из индекса не откатываются,
+// поэтому чтения после них получают 503, и дальше сервис отвечает 503 на все запросы до перезапуска с восстановлением
+// по журналу
+class SearchService
+{
+    public:
+        explicit SearchService(SearchServer& search_server, WriteAheadLog* wal = nullptr);
+
+        std::vector<HttpResponse> HandleBatch(const std::vector<const HttpRequest*>& requests);
+        HttpResponse Handle(const HttpRequest& request);
+
+    private:
+        SearchServer& search_server_;
+        WriteAheadLog* wal_;
+        // Индекс содержит изменения, которых нет в журнале
+        bool is_diverged_from_log_ = false;
+
+        static bool IsReadRequest(const HttpRequest& request);
+        HttpResponse HandleRead(const HttpRequest& request) const;
+        HttpResponse HandleWrite(const HttpRequest& request);
+};
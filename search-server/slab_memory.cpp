@@ -0,0 +1,191 @@
+#include "slab_memory.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#define HAS_MMAP
+#endif
+
+namespace
+{
+    const size_t SLAB_ALIGNMENT = 16;
+    const size_t SLAB_FINE_CLASS_LIMIT = 256;
+
+    size_t RoundUp(size_t value, size_t multiple)
+    {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+}
+
+size_t HugePageMemoryResource::GetMappedBytes() const
+{
+    return mapped_bytes_;
+}
+
+size_t HugePageMemoryResource::GetHugeTlbBytes() const
+{
+    return huge_tlb_bytes_;
+}
+
+void* HugePageMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+    const size_t size = RoundUp(bytes, HUGE_PAGE_SIZE);
+
+#ifdef HAS_MMAP
+    // Участки выровнены на HUGE_PAGE_SIZE, более строгое выравнивание не поддерживается
+    if(alignment > HUGE_PAGE_SIZE)
+    {
+        throw std::bad_alloc();
+    }
+
+    void* pointer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if(pointer != MAP_FAILED)
+    {
+        huge_tlb_bytes_ += size;
+    }
+    else
+    {
+        // Ядро собирает прозрачные huge pages только в выровненных на 2 МБ диапазонах:
+        // берём участок с запасом и отрезаем невыровненные края
+        const size_t mapped_size = size + HUGE_PAGE_SIZE;
+        char* mapped = static_cast<char*>(mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if(mapped == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+
+        char* aligned = mapped + (RoundUp(reinterpret_cast<uintptr_t>(mapped), HUGE_PAGE_SIZE) - reinterpret_cast<uintptr_t>(mapped));
+        if(aligned != mapped)
+        {
+            munmap(mapped, aligned - mapped);
+        }
+        if(const size_t tail = mapped + mapped_size - (aligned + size); tail > 0)
+        {
+            munmap(aligned + size, tail);
+        }
+
+        pointer = aligned;
+        madvise(pointer, size, MADV_HUGEPAGE);
+    }
+#else
+    void* pointer = ::operator new(size, std::align_val_t(std::max(alignment, alignof(std::max_align_t))));
+#endif
+
+    mapped_bytes_ += size;
+    return pointer;
+}
+
+void HugePageMemoryResource::do_deallocate(void* pointer, size_t bytes, [[maybe_unused]] size_t alignment)
+{
+    const size_t size = RoundUp(bytes, HUGE_PAGE_SIZE);
+
+#ifdef HAS_MMAP
+    munmap(pointer, size);
+#else
+    ::operator delete(pointer, std::align_val_t(std::max(alignment, alignof(std::max_align_t))));
+#endif
+
+    mapped_bytes_ -= size;
+}
+
+bool HugePageMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+SlabMemoryResource::SlabMemoryResource(std::pmr::memory_resource* chunk_upstream, std::pmr::memory_resource* large_upstream)
+    : chunk_upstream_(chunk_upstream), large_upstream_(large_upstream)
+{
+}
+
+SlabMemoryResource::~SlabMemoryResource()
+{
+    for(void* chunk : chunks_)
+    {
+        chunk_upstream_->deallocate(chunk, SLAB_CHUNK_SIZE, SLAB_ALIGNMENT);
+    }
+}
+
+size_t SlabMemoryResource::GetReservedBytes() const
+{
+    return chunks_.size() * SLAB_CHUNK_SIZE + large_bytes_;
+}
+
+size_t SlabMemoryResource::GetSizeClass(size_t bytes)
+{
+    if(bytes <= SLAB_FINE_CLASS_LIMIT)
+    {
+        return (std::max<size_t>(bytes, 1) - 1) / SLAB_ALIGNMENT;
+    }
+
+    size_t size_class = SLAB_FINE_CLASS_LIMIT / SLAB_ALIGNMENT;
+    for(size_t block_size = SLAB_FINE_CLASS_LIMIT * 2; block_size < bytes; block_size *= 2)
+    {
+        ++size_class;
+    }
+
+    return size_class;
+}
+
+size_t SlabMemoryResource::GetClassBlockSize(size_t size_class)
+{
+    const size_t fine_class_count = SLAB_FINE_CLASS_LIMIT / SLAB_ALIGNMENT;
+    if(size_class < fine_class_count)
+    {
+        return (size_class + 1) * SLAB_ALIGNMENT;
+    }
+
+    return SLAB_FINE_CLASS_LIMIT << (size_class - fine_class_count + 1);
+}
+
+void* SlabMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+    if(bytes > SLAB_MAX_BLOCK_SIZE || alignment > SLAB_ALIGNMENT)
+    {
+        large_bytes_ += bytes;
+        return large_upstream_->allocate(bytes, alignment);
+    }
+
+    const size_t size_class = GetSizeClass(bytes);
+    if(FreeBlock* block = free_blocks_[size_class]; block != nullptr)
+    {
+        free_blocks_[size_class] = block->next;
+        return block;
+    }
+
+    const size_t block_size = GetClassBlockSize(size_class);
+    if(chunk_position_ == nullptr || static_cast<size_t>(chunk_end_ - chunk_position_) < block_size)
+    {
+        chunks_.reserve(chunks_.size() + 1);
+        chunk_position_ = static_cast<char*>(chunk_upstream_->allocate(SLAB_CHUNK_SIZE, SLAB_ALIGNMENT));
+        chunk_end_ = chunk_position_ + SLAB_CHUNK_SIZE;
+        chunks_.push_back(chunk_position_);
+    }
+
+    void* block = chunk_position_;
+    chunk_position_ += block_size;
+    return block;
+}
+
+void SlabMemoryResource::do_deallocate(void* pointer, size_t bytes, size_t alignment)
+{
+    if(bytes > SLAB_MAX_BLOCK_SIZE || alignment > SLAB_ALIGNMENT)
+    {
+        large_bytes_ -= bytes;
+        large_upstream_->deallocate(pointer, bytes, alignment);
+        return;
+    }
+
+    const size_t size_class = GetSizeClass(bytes);
+    FreeBlock* block = static_cast<FreeBlock*>(pointer);
+    block->next = free_blocks_[size_class];
+    free_blocks_[size_class] = block;
+}
+
+bool SlabMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
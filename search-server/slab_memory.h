@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+// Блоки до SLAB_MAX_BLOCK_SIZE байт нарезаются из кусков по SLAB_CHUNK_SIZE, крупнее — выделяются напрямую
+const size_t SLAB_MAX_BLOCK_SIZE = 4096;
+const size_t SLAB_CHUNK_SIZE = HUGE_PAGE_SIZE;
+
+// Аллокатор контейнеров индекса, задаётся SearchServer::SetIndexAllocator
+enum class IndexAllocator
+{
+    DEFAULT,
+    SLAB,
+    SLAB_HUGE_PAGES,
+};
+
+// Память участками, кратными 2 МБ. Сначала пробуются явные huge pages (MAP_HUGETLB),
+// если они не зарезервированы в системе — обычный mmap с просьбой к ядру собрать прозрачные huge pages
+class HugePageMemoryResource : public std::pmr::memory_resource
+{
+    public:
+        size_t GetMappedBytes() const;
+        // Байты, полученные из пула явных huge pages
+        size_t GetHugeTlbBytes() const;
+
+    private:
+        size_t mapped_bytes_ = 0;
+        size_t huge_tlb_bytes_ = 0;
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+// Слэбовый ресурс для множества мелких узлов индекса. Мелкие блоки берутся из классов размеров
+// (кратные 16 байтам до 256, затем степени двойки) внутри общих кусков, освобождённые блоки
+// уходят в список свободных своего класса. Куски возвращаются chunk_upstream только при разрушении ресурса.
+// Не потокобезопасен: индекс изменяется из одного потока
+class SlabMemoryResource : public std::pmr::memory_resource
+{
+    public:
+        explicit SlabMemoryResource(std::pmr::memory_resource* chunk_upstream = std::pmr::new_delete_resource(),
+                                    std::pmr::memory_resource* large_upstream = std::pmr::new_delete_resource());
+        ~SlabMemoryResource() override;
+
+        SlabMemoryResource(const SlabMemoryResource&) = delete;
+        SlabMemoryResource& operator=(const SlabMemoryResource&) = delete;
+
+        // Память, взятая у вышестоящих ресурсов: куски целиком и крупные блоки
+        size_t GetReservedBytes() const;
+
+    private:
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        static const size_t SIZE_CLASS_COUNT = 20;
+
+        std::pmr::memory_resource* chunk_upstream_;
+        std::pmr::memory_resource* large_upstream_;
+        std::array<FreeBlock*, SIZE_CLASS_COUNT> free_blocks_{};
+        std::vector<void*> chunks_;
+        char* chunk_position_ = nullptr;
+        char* chunk_end_ = nullptr;
+        size_t large_bytes_ = 0;
+
+        static size_t GetSizeClass(size_t bytes);
+        static size_t GetClassBlockSize(size_t size_class);
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
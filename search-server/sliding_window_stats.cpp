@@ -0,0 +1,88 @@
+#include "sliding_window_stats.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std::literals;
+
+SlidingWindowStats::SlidingWindowStats(Clock::duration window, size_t interval_count, Clock::time_point start)
+    : interval_width_(window / static_cast<Clock::rep>(std::max<size_t>(interval_count, 1))), interval_count_(interval_count), start_(start)
+{
+    if(interval_count_ == 0 || interval_width_ <= Clock::duration::zero())
+    {
+        throw std::invalid_argument("Окно статистики должно содержать хотя бы один интервал ненулевой длины"s);
+    }
+
+    for(Stripe& stripe : stripes_)
+    {
+        stripe.counters = std::make_unique<std::atomic<uint64_t>[]>(interval_count_ * RESULT_COUNT_BIN_COUNT);
+    }
+}
+
+void SlidingWindowStats::Record(size_t result_count, Clock::time_point now)
+{
+    const uint32_t interval = GetInterval(now);
+    const size_t bin = std::min(result_count, RESULT_COUNT_BIN_COUNT - 1);
+    std::atomic<uint64_t>& counter = stripes_[GetThreadStripe()].counters[(interval % interval_count_) * RESULT_COUNT_BIN_COUNT + bin];
+
+    uint64_t value = counter.load(std::memory_order_relaxed);
+    while(true)
+    {
+        // Запись из отставшего потока прибавляется к более новому интервалу, а не сбрасывает его
+        const uint32_t counter_interval = static_cast<uint32_t>(value >> 32);
+        const bool is_actual = (value & UINT32_MAX) != 0 && static_cast<int32_t>(counter_interval - interval) >= 0;
+        const uint64_t updated = is_actual ? value + 1 : (uint64_t{interval} << 32) | 1;
+        if(counter.compare_exchange_weak(value, updated, std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+}
+
+WindowStatsSnapshot SlidingWindowStats::GetSnapshot(Clock::time_point now) const
+{
+    const uint32_t interval = GetInterval(now);
+
+    WindowStatsSnapshot snapshot;
+    for(const Stripe& stripe : stripes_)
+    {
+        for(size_t i = 0; i < interval_count_ * RESULT_COUNT_BIN_COUNT; ++i)
+        {
+            const uint64_t value = stripe.counters[i].load(std::memory_order_relaxed);
+            if(interval - static_cast<uint32_t>(value >> 32) < interval_count_)
+            {
+                snapshot.result_count_distribution[i % RESULT_COUNT_BIN_COUNT] += value & UINT32_MAX;
+            }
+        }
+    }
+
+    for(const uint64_t count : snapshot.result_count_distribution)
+    {
+        snapshot.request_count += count;
+    }
+    snapshot.no_result_count = snapshot.result_count_distribution[0];
+    // Пока окно не заполнено, запросы накоплены за меньшее время. Секунда снизу защищает от деления на ноль сразу после создания
+    const Clock::duration elapsed = std::min(GetWindow(), std::max<Clock::duration>(now - start_, std::chrono::seconds(1)));
+    snapshot.queries_per_second = snapshot.request_count / std::chrono::duration<double>(elapsed).count();
+
+    return snapshot;
+}
+
+SlidingWindowStats::Clock::duration SlidingWindowStats::GetWindow() const
+{
+    return interval_width_ * static_cast<Clock::rep>(interval_count_);
+}
+
+uint32_t SlidingWindowStats::GetInterval(Clock::time_point time) const
+{
+    // Номера интервалов сравниваются по модулю 2^32, поэтому переполнение не мешает
+    return static_cast<uint32_t>(time.time_since_epoch() / interval_width_);
+}
+
+size_t SlidingWindowStats::GetThreadStripe()
+{
+    static std::atomic<size_t> next_stripe = 0;
+    thread_local const size_t stripe = next_stripe++ % WINDOW_STATS_STRIPE_COUNT;
+
+    return stripe;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Запросы с RESULT_COUNT_BIN_COUNT - 1 и более документами попадают в последнюю корзину распределения
+const size_t RESULT_COUNT_BIN_COUNT = 8;
+const size_t WINDOW_STATS_STRIPE_COUNT = 8;
+
+struct WindowStatsSnapshot
+{
+    uint64_t request_count = 0;
+    uint64_t no_result_count = 0;
+    std::array<uint64_t, RESULT_COUNT_BIN_COUNT> result_count_distribution{};
+    double queries_per_second = 0.0;
+};
+
+// Статистика запросов за последние window: окно разбито на интервалы, счётчики интервалов живут в кольце.
+// Запись — O(1) без блокировок: у каждого потока своя полоса счётчиков, а номер интервала хранится
+// в том же атомарном слове, что и значение, поэтому устаревший счётчик сбрасывается одним CAS.
+// Чтение суммирует кольца всех полос и не зависит от числа запросов
+class SlidingWindowStats
+{
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        // Частота запросов до заполнения окна считается по времени, прошедшему с start
+        SlidingWindowStats(Clock::duration window, size_t interval_count, Clock::time_point start = Clock::now());
+
+        void Record(size_t result_count, Clock::time_point now = Clock::now());
+        WindowStatsSnapshot GetSnapshot(Clock::time_point now = Clock::now()) const;
+
+        Clock::duration GetWindow() const;
+
+    private:
+        // Счётчик: номер интервала в старших 32 битах, значение в младших
+        struct alignas(64) Stripe
+        {
+            std::unique_ptr<std::atomic<uint64_t>[]> counters;
+        };
+
+        const Clock::duration interval_width_;
+        const size_t interval_count_;
+        const Clock::time_point start_;
+        std::array<Stripe, WINDOW_STATS_STRIPE_COUNT> stripes_;
+
+        uint32_t GetInterval(Clock::time_point time) const;
+        static size_t GetThreadStripe();
+};
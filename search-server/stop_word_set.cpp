@@ -0,0 +1,161 @@
+#include "stop_word_set.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+    uint64_t MixBits(uint64_t value)
+    {
+        value ^= value >> 30;
+        value *= 0xBF58476D1CE4E5B9ull;
+        value ^= value >> 27;
+        value *= 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+}
+
+StopWordSet::StopWordSet(const allocator_type& allocator) : bloom_filter_(allocator), seeds_(allocator), offsets_(allocator), chars_(allocator)
+{
+}
+
+StopWordSet::StopWordSet(const std::vector<std::string_view>& words, const allocator_type& allocator) : StopWordSet(allocator)
+{
+    if(words.empty())
+    {
+        return;
+    }
+
+    const size_t word_count = words.size();
+    std::vector<uint64_t> hashes(word_count);
+    std::transform(words.begin(), words.end(), hashes.begin(), HashWord);
+
+    // Около 16 бит фильтра на слово: при четырёх битах на слово ложных срабатываний меньше процента
+    size_t block_count = 1;
+    while(block_count * 4 < word_count)
+    {
+        block_count *= 2;
+    }
+    bloom_mask_ = block_count - 1;
+    bloom_filter_.assign(block_count, 0);
+    for(const uint64_t hash : hashes)
+    {
+        bloom_filter_[(hash >> 32) & bloom_mask_] |= GetBloomBits(hash);
+    }
+
+    // Корзины размещаются от больших к малым: для большой корзины сид легче подобрать, пока таблица пуста
+    std::vector<std::vector<uint32_t>> buckets(word_count);
+    for(uint32_t i = 0; i < word_count; ++i)
+    {
+        buckets[(hashes[i] >> 24) % word_count].push_back(i);
+    }
+    std::vector<uint32_t> bucket_order(word_count);
+    std::iota(bucket_order.begin(), bucket_order.end(), 0);
+    std::stable_sort(bucket_order.begin(), bucket_order.end(), [&buckets](uint32_t lhs, uint32_t rhs) {
+        return buckets[lhs].size() > buckets[rhs].size();
+    });
+
+    seeds_.assign(word_count, 0);
+    std::vector<int64_t> slot_words(word_count, -1);
+    std::vector<size_t> slots;
+    for(const uint32_t bucket : bucket_order)
+    {
+        if(buckets[bucket].empty())
+        {
+            break;
+        }
+
+        for(uint32_t seed = 1;; ++seed)
+        {
+            slots.clear();
+            for(const uint32_t word : buckets[bucket])
+            {
+                const size_t slot = MixSeed(hashes[word], seed) % word_count;
+                if(slot_words[slot] != -1 || std::find(slots.begin(), slots.end(), slot) != slots.end())
+                {
+                    break;
+                }
+                slots.push_back(slot);
+            }
+
+            if(slots.size() == buckets[bucket].size())
+            {
+                for(size_t i = 0; i < slots.size(); ++i)
+                {
+                    slot_words[slots[i]] = buckets[bucket][i];
+                }
+                seeds_[bucket] = seed;
+                break;
+            }
+        }
+    }
+
+    offsets_.reserve(word_count + 1);
+    for(const int64_t word : slot_words)
+    {
+        offsets_.push_back(static_cast<uint32_t>(chars_.size()));
+        chars_ += words[word];
+    }
+    offsets_.push_back(static_cast<uint32_t>(chars_.size()));
+}
+
+bool StopWordSet::Contains(std::string_view word) const
+{
+    if(seeds_.empty())
+    {
+        return false;
+    }
+
+    const uint64_t hash = HashWord(word);
+    const uint64_t bits = GetBloomBits(hash);
+    if((bloom_filter_[(hash >> 32) & bloom_mask_] & bits) != bits)
+    {
+        return false;
+    }
+
+    const uint32_t seed = seeds_[(hash >> 24) % seeds_.size()];
+    return GetWord(MixSeed(hash, seed) % seeds_.size()) == word;
+}
+
+size_t StopWordSet::size() const
+{
+    return seeds_.size();
+}
+
+bool StopWordSet::empty() const
+{
+    return seeds_.empty();
+}
+
+uint64_t StopWordSet::HashWord(std::string_view word)
+{
+    // FNV-1a с перемешиванием результата, чтобы старшие и младшие биты были одинаково случайны
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for(const char c : word)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3ull;
+    }
+
+    return MixBits(hash);
+}
+
+uint64_t StopWordSet::MixSeed(uint64_t hash, uint32_t seed)
+{
+    return MixBits(hash ^ (seed * 0x9E3779B97F4A7C15ull));
+}
+
+uint64_t StopWordSet::GetBloomBits(uint64_t hash)
+{
+    uint64_t bits = 0;
+    for(int i = 0; i < BLOOM_BIT_COUNT; ++i)
+    {
+        bits |= uint64_t{1} << ((hash >> (6 * i)) & 63);
+    }
+
+    return bits;
+}
+
+std::string_view StopWordSet::GetWord(size_t slot) const
+{
+    return std::string_view(chars_).substr(offsets_[slot], offsets_[slot + 1] - offsets_[slot]);
+}
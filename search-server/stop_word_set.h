@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Неизменяемое множество стоп-слов для проверки каждого слова документов и запросов.
+// Слово сначала проверяется блочным фильтром Блума: все биты слова лежат в одном 64-битном слове фильтра,
+// поэтому большинство обычных слов отсеивается одним чтением и сравнением без ветвлений. Прошедшее фильтр
+// слово проверяется минимальной совершенной хеш-функцией (hash and displace): сид корзины слова задаёт
+// единственную ячейку, где это слово может лежать, и остаётся одно сравнение строк
+class StopWordSet
+{
+    public:
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+        explicit StopWordSet(const allocator_type& allocator = {});
+        // Слова не должны повторяться
+        StopWordSet(const std::vector<std::string_view>& words, const allocator_type& allocator = {});
+
+        bool Contains(std::string_view word) const;
+
+        size_t size() const;
+        bool empty() const;
+
+    private:
+        // Биты фильтра Блума на слово
+        static const int BLOOM_BIT_COUNT = 4;
+
+        uint64_t bloom_mask_ = 0;
+        std::pmr::vector<uint64_t> bloom_filter_;
+        // Сид корзины для каждой корзины, корзин столько же, сколько слов
+        std::pmr::vector<uint32_t> seeds_;
+        // Слова по номерам ячеек подряд в одной строке, offsets_[i] — начало слова ячейки i
+        std::pmr::vector<uint32_t> offsets_;
+        std::pmr::string chars_;
+
+        static uint64_t HashWord(std::string_view word);
+        static uint64_t MixSeed(uint64_t hash, uint32_t seed);
+        static uint64_t GetBloomBits(uint64_t hash);
+        std::string_view GetWord(size_t slot) const;
+};
@@ -1,18 +1,89 @@
 #include "string_processing.h"
 
+#include <algorithm>
+
+bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
 std::vector<std::string_view> SplitIntoWords(std::string_view text)
 {
     std::vector<std::string_view> words;
-    const size_t pos_end = text.npos;
-    size_t space = text.find(' ');
 
-    while(space != pos_end)
+    size_t position = 0;
+    while(position < text.size())
     {
-        words.push_back(text.substr(0, space));
-        text.remove_prefix(space + 1);
-        space = text.find(' ');
+        while(position < text.size() && IsSpace(text[position]))
+        {
+            ++position;
+        }
+
+        const size_t word_begin = position;
+        while(position < text.size() && !IsSpace(text[position]))
+        {
+            ++position;
+        }
+
+        if(position > word_begin)
+        {
+            words.push_back(text.substr(word_begin, position - word_begin));
+        }
     }
-    words.push_back(text.substr(0, space));
 
     return words;
 }
+
+std::u32string DecodeUtf8(std::string_view text)
+{
+    std::u32string result;
+    result.reserve(text.size());
+
+    for(size_t i = 0; i < text.size();)
+    {
+        const unsigned char lead = static_cast<unsigned char>(text[i]);
+        size_t length = 1;
+        char32_t code_point = lead;
+
+        if(lead >= 0xF0)
+        {
+            length = 4;
+            code_point = lead & 0x07;
+        }
+        else if(lead >= 0xE0)
+        {
+            length = 3;
+            code_point = lead & 0x0F;
+        }
+        else if(lead >= 0xC0)
+        {
+            length = 2;
+            code_point = lead & 0x1F;
+        }
+
+        if(length > 1 && i + length <= text.size())
+        {
+            for(size_t j = 1; j < length; ++j)
+            {
+                code_point = (code_point << 6) | (static_cast<unsigned char>(text[i + j]) & 0x3F);
+            }
+        }
+        else
+        {
+            length = 1;
+            code_point = lead;
+        }
+
+        result.push_back(code_point);
+        i += length;
+    }
+
+    return result;
+}
+
+size_t CountUtf8Chars(std::string_view text)
+{
+    return std::count_if(text.begin(), text.end(), [](char c) {
+        return (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+    });
+}
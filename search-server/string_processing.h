@@ -4,8 +4,15 @@
 #include <vector>
 #include <set>
 
+bool IsSpace(char c);
+
+// Разбиение по пробельным символам ASCII, пустые слова пропускаются
 std::vector<std::string_view> SplitIntoWords(std::string_view text);
 
+// Некорректные байты UTF-8 декодируются как отдельные символы
+std::u32string DecodeUtf8(std::string_view text);
+size_t CountUtf8Chars(std::string_view text);
+
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings)
 {
@@ -0,0 +1,252 @@
+#include "term_dictionary.h"
+#include "string_processing.h"
+
+#include <algorithm>
+#include <deque>
+#include <utility>
+
+TermDictionary::TermDictionary(std::vector<std::string_view> sorted_terms) : terms_(std::move(sorted_terms))
+{
+    std::vector<std::u32string> decoded_terms;
+    decoded_terms.reserve(terms_.size());
+    for(std::string_view term : terms_)
+    {
+        decoded_terms.push_back(DecodeUtf8(term));
+    }
+
+    struct Range
+    {
+        uint32_t node;
+        uint32_t begin;
+        uint32_t end;
+        uint32_t depth;
+    };
+
+    nodes_.push_back({0, 0, 0, 0, static_cast<uint32_t>(terms_.size()), false});
+    std::deque<Range> ranges = {{0, 0, static_cast<uint32_t>(terms_.size()), 0}};
+
+    while(!ranges.empty())
+    {
+        const Range range = ranges.front();
+        ranges.pop_front();
+
+        uint32_t begin = range.begin;
+        if(begin < range.end && decoded_terms[begin].size() == range.depth)
+        {
+            nodes_[range.node].is_terminal = true;
+            ++begin;
+        }
+
+        nodes_[range.node].first_child = static_cast<uint32_t>(nodes_.size());
+
+        while(begin < range.end)
+        {
+            const char32_t label = decoded_terms[begin][range.depth];
+            uint32_t end = begin + 1;
+            while(end < range.end && decoded_terms[end][range.depth] == label)
+            {
+                ++end;
+            }
+
+            ranges.push_back({static_cast<uint32_t>(nodes_.size()), begin, end, range.depth + 1});
+            nodes_.push_back({label, 0, 0, begin, end, false});
+            ++nodes_[range.node].child_count;
+            begin = end;
+        }
+    }
+
+    nodes_.shrink_to_fit();
+}
+
+size_t TermDictionary::size() const
+{
+    return terms_.size();
+}
+
+size_t TermDictionary::GetMemoryUsage() const
+{
+    return terms_.capacity() * sizeof(std::string_view) + nodes_.capacity() * sizeof(Node);
+}
+
+std::vector<std::string_view> TermDictionary::FindByPrefix(std::string_view prefix, size_t max_count) const
+{
+    const Node* node = FindNode(DecodeUtf8(prefix));
+    if(node == nullptr)
+    {
+        return {};
+    }
+
+    const size_t end = node->term_begin + std::min<size_t>(max_count, node->term_end - node->term_begin);
+    return {terms_.begin() + node->term_begin, terms_.begin() + end};
+}
+
+std::vector<std::string_view> TermDictionary::FindByPattern(std::string_view pattern, size_t max_count, size_t max_visits) const
+{
+    const std::u32string decoded_pattern = DecodeUtf8(pattern);
+    const size_t literal_length = std::min(decoded_pattern.find_first_of(U"*?"), decoded_pattern.size());
+
+    const Node* start = FindNode(decoded_pattern.substr(0, literal_length));
+    if(start == nullptr)
+    {
+        return {};
+    }
+
+    std::vector<uint32_t> term_ids;
+    std::vector<std::pair<const Node*, size_t>> stack = {{start, literal_length}};
+    size_t visits = 0;
+
+    while(!stack.empty() && visits < max_visits && term_ids.size() < max_count)
+    {
+        const auto [node, position] = stack.back();
+        stack.pop_back();
+        ++visits;
+
+        if(position == decoded_pattern.size())
+        {
+            if(node->is_terminal)
+            {
+                term_ids.push_back(node->term_begin);
+            }
+            continue;
+        }
+
+        const char32_t symbol = decoded_pattern[position];
+        const Node* children = nodes_.data() + node->first_child;
+
+        if(symbol == U'*')
+        {
+            stack.push_back({node, position + 1});
+            for(uint32_t i = node->child_count; i > 0; --i)
+            {
+                stack.push_back({children + i - 1, position});
+            }
+        }
+        else if(symbol == U'?')
+        {
+            for(uint32_t i = node->child_count; i > 0; --i)
+            {
+                stack.push_back({children + i - 1, position + 1});
+            }
+        }
+        else if(const Node* child = FindChild(*node, symbol); child != nullptr)
+        {
+            stack.push_back({child, position + 1});
+        }
+    }
+
+    std::sort(term_ids.begin(), term_ids.end());
+    term_ids.erase(std::unique(term_ids.begin(), term_ids.end()), term_ids.end());
+
+    std::vector<std::string_view> result;
+    result.reserve(term_ids.size());
+    for(const uint32_t term_id : term_ids)
+    {
+        result.push_back(terms_[term_id]);
+    }
+
+    return result;
+}
+
+std::vector<std::pair<std::string_view, int>> TermDictionary::FindFuzzy(std::string_view word, int max_distance, size_t max_count) const
+{
+    if(nodes_.empty())
+    {
+        return {};
+    }
+
+    FuzzySearch search{DecodeUtf8(word), max_distance, {}, 0, {}};
+
+    const size_t width = search.word.size() + 1;
+    search.rows.resize(width);
+    for(size_t i = 0; i < width; ++i)
+    {
+        search.rows[i] = static_cast<int>(i);
+    }
+
+    CollectFuzzy(nodes_.front(), 0, search);
+
+    std::sort(search.matches.begin(), search.matches.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.second < rhs.second || (lhs.second == rhs.second && lhs.first < rhs.first);
+    });
+    if(search.matches.size() > max_count)
+    {
+        search.matches.resize(max_count);
+    }
+
+    std::vector<std::pair<std::string_view, int>> result;
+    result.reserve(search.matches.size());
+    for(const auto& [term_id, distance] : search.matches)
+    {
+        result.push_back({terms_[term_id], distance});
+    }
+
+    return result;
+}
+
+void TermDictionary::CollectFuzzy(const Node& node, size_t depth, FuzzySearch& search) const
+{
+    const size_t width = search.word.size() + 1;
+    if(search.rows.size() < (depth + 2) * width)
+    {
+        search.rows.resize((depth + 2) * width);
+    }
+
+    for(uint32_t i = 0; i < node.child_count && search.visits < MAX_TERM_DICTIONARY_VISITS; ++i)
+    {
+        const Node& child = nodes_[node.first_child + i];
+        ++search.visits;
+
+        const int* previous = search.rows.data() + depth * width;
+        int* current = search.rows.data() + (depth + 1) * width;
+
+        current[0] = previous[0] + 1;
+        int row_min = current[0];
+        for(size_t j = 1; j < width; ++j)
+        {
+            const int substitution = previous[j - 1] + (search.word[j - 1] == child.label ? 0 : 1);
+            current[j] = std::min({previous[j] + 1, current[j - 1] + 1, substitution});
+            row_min = std::min(row_min, current[j]);
+        }
+
+        if(child.is_terminal && current[width - 1] <= search.max_distance)
+        {
+            search.matches.push_back({child.term_begin, current[width - 1]});
+        }
+
+        if(row_min <= search.max_distance)
+        {
+            CollectFuzzy(child, depth + 1, search);
+        }
+    }
+}
+
+const TermDictionary::Node* TermDictionary::FindChild(const Node& node, char32_t label) const
+{
+    const auto first = nodes_.begin() + node.first_child;
+    const auto last = first + node.child_count;
+    const auto it = std::lower_bound(first, last, label, [](const Node& child, char32_t value) {
+        return child.label < value;
+    });
+
+    return it != last && it->label == label ? &*it : nullptr;
+}
+
+const TermDictionary::Node* TermDictionary::FindNode(const std::u32string& prefix) const
+{
+    if(nodes_.empty())
+    {
+        return nullptr;
+    }
+
+    const Node* node = &nodes_.front();
+    for(const char32_t label : prefix)
+    {
+        node = FindChild(*node, label);
+        if(node == nullptr)
+        {
+            return nullptr;
+        }
+    }
+
+    return node;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+// Ограничение числа посещённых узлов по умолчанию при обходе по шаблону и нечётком поиске
+const size_t MAX_TERM_DICTIONARY_VISITS = 100000;
+
+// Неизменяемый словарь терминов: префиксное дерево по символам Unicode,
+// уложенное в один массив узлов в порядке обхода в ширину.
+// Дети узла лежат подряд и отсортированы по символу, а термины поддерева
+// образуют непрерывный диапазон в отсортированном списке терминов
+class TermDictionary
+{
+    public:
+        TermDictionary() = default;
+
+        // Термины должны быть отсортированы по возрастанию и не повторяться.
+        // Словарь хранит string_view, поэтому строки должны его пережить
+        explicit TermDictionary(std::vector<std::string_view> sorted_terms);
+
+        size_t size() const;
+        size_t GetMemoryUsage() const;
+
+        // Не более max_count терминов с заданным префиксом в лексикографическом порядке
+        std::vector<std::string_view> FindByPrefix(std::string_view prefix, size_t max_count) const;
+
+        // '*' соответствует любой последовательности символов, '?' — ровно одному символу.
+        // Обход останавливается после max_visits узлов, SIZE_MAX снимает ограничение
+        std::vector<std::string_view> FindByPattern(std::string_view pattern, size_t max_count, size_t max_visits = MAX_TERM_DICTIONARY_VISITS) const;
+
+        // Термины на расстоянии Левенштейна не больше max_distance в порядке возрастания расстояния.
+        // Автомат Левенштейна моделируется строками матрицы расстояний при обходе дерева в глубину
+        std::vector<std::pair<std::string_view, int>> FindFuzzy(std::string_view word, int max_distance, size_t max_count) const;
+
+    private:
+        struct Node
+        {
+            char32_t label;
+            uint32_t first_child;
+            uint32_t child_count;
+            uint32_t term_begin;
+            uint32_t term_end;
+            bool is_terminal;
+        };
+
+        std::vector<std::string_view> terms_;
+        std::vector<Node> nodes_;
+
+        const Node* FindChild(const Node& node, char32_t label) const;
+        const Node* FindNode(const std::u32string& prefix) const;
+
+        struct FuzzySearch
+        {
+            std::u32string word;
+            int max_distance;
+            std::vector<int> rows;
+            size_t visits;
+            std::vector<std::pair<uint32_t, int>> matches;
+        };
+
+        void CollectFuzzy(const Node& node, size_t depth, FuzzySearch& search) const;
+};
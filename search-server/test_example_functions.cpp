@@ -1,5 +1,18 @@
 #include "test_example_functions.h"
 
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <csignal>
+#endif
+
 using namespace std::literals;
 
 template <typename T>
@@ -196,6 +209,21 @@ void TestExcludingDocumentWithNegativeWordFromQueryResult()
         std::vector<Document> found_docs_3 = server.FindTopDocuments("cat -City -Big"s);
         ASSERT(found_docs_3.empty());
     }
+
+    {
+        SearchServer server;
+        server.AddDocument(1, content, DocumentStatus::ACTUAL, ratings);
+        server.AddDocument(2, "Small cat in the village"s, DocumentStatus::ACTUAL, ratings);
+        server.AddDocument(3, "Grey cat in the city"s, DocumentStatus::BANNED, ratings);
+
+        // Минус-слова исключают документы и в параллельной версии, и вместе с фильтром
+        std::vector<Document> found_docs_par = server.FindTopDocuments(std::execution::par, "cat -city"s);
+        ASSERT_EQUAL(found_docs_par.size(), 1);
+        ASSERT_EQUAL(found_docs_par[0].id, 2);
+
+        ASSERT(server.FindTopDocuments("cat -city"s, DocumentStatus::BANNED).empty());
+        ASSERT_EQUAL(server.FindTopDocuments("cat -village"s, [](int, DocumentStatus, int) { return true; }).size(), 2);
+    }
 }
 
 // Тест проверяет работу матчинга документов
@@ -231,6 +259,41 @@ void TestMatchDocument()
         tie(matching_words, document_status) = server.MatchDocument("кот -глаза"s, 3);
         ASSERT(matching_words.empty());
     }
+
+    // Пакетный матчинг совпадает с поштучным
+    {
+        SearchServer server;
+        server.AddDocument(1, "белый кот и модный ошейник"s, DocumentStatus::ACTUAL, {8, -3});
+        server.AddDocument(2, "пушистый кот пушистый хвост"s, DocumentStatus::BANNED, {7, 2, 7});
+        server.AddDocument(3, "ухоженный пёс выразительные глаза"s, DocumentStatus::ACTUAL, {5, -12, 2, 1});
+
+        const std::vector<int> document_ids = {3, 1, 2};
+        for(const std::string& query : {"пушистый кот -ошейник"s, "кот пёс хвост"s, "+кот пуш*"s})
+        {
+            const auto seq_results = server.MatchDocuments(query, document_ids);
+            const auto par_results = server.MatchDocuments(std::execution::par, query, document_ids);
+            ASSERT_EQUAL(seq_results.size(), document_ids.size());
+
+            for(size_t i = 0; i < document_ids.size(); ++i)
+            {
+                const auto [words, status] = server.MatchDocument(query, document_ids[i]);
+                ASSERT_EQUAL(std::get<0>(seq_results[i]), words);
+                ASSERT_EQUAL(std::get<0>(par_results[i]), words);
+                ASSERT(std::get<1>(par_results[i]) == status);
+            }
+        }
+
+        ASSERT_EQUAL(std::get<0>(server.MatchDocuments("пушистый кот -ошейник"s, {2, 1})[0]), (std::vector<std::string_view>{"кот"sv, "пушистый"sv}));
+
+        try
+        {
+            server.MatchDocuments(std::execution::par, "кот"s, {1, 42});
+            ASSERT_HINT(false, "unknown document id must be rejected"s);
+        }
+        catch(const std::out_of_range&)
+        {
+        }
+    }
 }
 
 // Тест проверяет корректность вычисления релевантности
@@ -376,17 +439,1978 @@ void TestPredicateFilter()
     ASSERT(result_7.size() == 1);
 }
 
+// Тест проверяет обязательные слова, группы ИЛИ и фразовые запросы
+void TestBooleanAndPhraseQuery()
+{
+    SearchServer server;
+    server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "cat with curly tail"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(3, "nasty dog with curly tail"s, DocumentStatus::ACTUAL, {3});
+    server.AddDocument(4, "white cat and yellow hat"s, DocumentStatus::ACTUAL, {4});
+
+    ASSERT_EQUAL(server.FindTopDocuments("curly"s).size(), 3);
+    ASSERT_EQUAL(server.FindTopDocuments("curly +cat"s).size(), 3);
+    ASSERT_EQUAL(server.FindTopDocuments("+curly +cat"s).size(), 2);
+    ASSERT_EQUAL(server.FindTopDocuments("+cat|dog +tail"s).size(), 3);
+    ASSERT_EQUAL(server.FindTopDocuments(std::execution::par, "+cat|dog +tail"s).size(), 3);
 
-template <typename T>
-void RunTestImpl(T func, const std::string& func_name)
+    const auto phrase_docs = server.FindTopDocuments("\"curly cat\""s);
+    ASSERT_EQUAL(phrase_docs.size(), 1);
+    ASSERT_EQUAL(phrase_docs[0].id, 1);
+
+    const auto curly_tail_docs = server.FindTopDocuments(std::execution::par, "\"curly tail\" -dog"s);
+    ASSERT_EQUAL(curly_tail_docs.size(), 2);
+
+    const auto [matched_words, status] = server.MatchDocument("\"curly cat\" tail"s, 2);
+    ASSERT(matched_words.empty());
+    const auto [phrase_words, phrase_status] = server.MatchDocument(std::execution::par, "\"curly cat\" tail"s, 1);
+    ASSERT_EQUAL(phrase_words.size(), 3);
+
+    ASSERT_EQUAL(IntersectSorted(std::vector<int>{1, 5, 9, 1000}, std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 11, 12, 13, 14, 15, 16, 17, 1000}), (std::vector<int>{1, 5, 1000}));
+
+    try
+    {
+        server.FindTopDocuments("\"curly cat"s);
+        ASSERT_HINT(false, "unclosed phrase must be rejected"s);
+    }
+    catch(const std::invalid_argument&)
+    {
+    }
+}
+// Тест проверяет раскрытие слов запроса по префиксу и шаблону
+void TestPrefixAndWildcardSearch()
 {
-    func();
-    std::cerr << func_name << " OK" << std::endl;
+    SearchServer server;
+    server.AddDocument(1, "curly cat"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "curtain call"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(3, "cut hat"s, DocumentStatus::ACTUAL, {3});
+    server.AddDocument(4, "пушистый кот"s, DocumentStatus::ACTUAL, {4});
+
+    ASSERT_EQUAL(server.FindTopDocuments("cur*"s).size(), 2);
+    ASSERT_EQUAL(server.FindTopDocuments("c?t"s).size(), 2);
+    ASSERT_EQUAL(server.FindTopDocuments("c*t"s).size(), 2);
+    ASSERT_EQUAL(server.FindTopDocuments(std::execution::par, "cu* -curtain"s).size(), 2);
+    ASSERT_EQUAL(server.FindTopDocuments("+cur* hat"s).size(), 2);
+    ASSERT_EQUAL(server.FindTopDocuments("пуш*"s).size(), 1);
+    ASSERT_EQUAL(server.FindTopDocuments("к?т"s).size(), 1);
+
+    // Точное совпадение весит больше, чем раскрытие по префиксу
+    server.AddDocument(5, "cur"s, DocumentStatus::ACTUAL, {5});
+    const auto found_docs = server.FindTopDocuments("cur*"s);
+    ASSERT_EQUAL(found_docs.size(), 3);
+    ASSERT_EQUAL(found_docs[0].id, 5);
+
+    const auto [matched_words, status] = server.MatchDocument("cur*"s, 1);
+    ASSERT_EQUAL(matched_words.size(), 1);
+    ASSERT_EQUAL(matched_words[0], "curly"s);
+
+    const TermDictionary dictionary({"cat"sv, "cattle"sv, "cut"sv, "dog"sv});
+    ASSERT_EQUAL(dictionary.FindByPrefix("cat"sv, 10).size(), 2);
+    ASSERT_EQUAL(dictionary.FindByPrefix("c"sv, 2).size(), 2);
+    ASSERT_EQUAL(dictionary.FindByPattern("*t"sv, 10).size(), 2);
+    ASSERT(dictionary.FindByPrefix("x"sv, 10).empty());
+    ASSERT_EQUAL(dictionary.FindByPrefix("c"sv, SIZE_MAX).size(), 3);
+    ASSERT(dictionary.FindByPattern("c?t"sv, 10, 2).empty());
+    ASSERT_EQUAL(dictionary.FindByPattern("c?t"sv, 10, SIZE_MAX).size(), 2);
+
+    // Минус-шаблоны и обязательные группы не ограничены MAX_TERM_EXPANSION_COUNT
+    SearchServer wide_server;
+    for(int id = 0; id < 100; ++id)
+    {
+        wide_server.AddDocument(id, "dog cat"s + (id < 10 ? "0"s : ""s) + std::to_string(id), DocumentStatus::ACTUAL, {1});
+    }
+    wide_server.AddDocument(100, "bird cat99"s, DocumentStatus::ACTUAL, {1});
+    ASSERT(wide_server.FindTopDocuments("dog -cat*"s).empty());
+    ASSERT(wide_server.FindTopDocuments("bird -cat?9"s).empty());
+    const auto group_docs = wide_server.FindTopDocuments("+cat* bird"s);
+    ASSERT_EQUAL(group_docs.size(), 5);
+    ASSERT_EQUAL(group_docs[0].id, 100);
+
+    // Полное раскрытие не ограничено и числом посещённых узлов словаря: "cutz" лежит за MAX_TERM_DICTIONARY_VISITS узлами
+    SearchServer large_server;
+    std::string large_text;
+    for(int i = 0; i < 120000; ++i)
+    {
+        const std::string number = std::to_string(i);
+        large_text += "cat"s + std::string(6 - number.size(), '0') + number + " "s;
+    }
+    large_server.AddDocument(1, large_text, DocumentStatus::ACTUAL, {1});
+    large_server.AddDocument(2, "dog cutz"s, DocumentStatus::ACTUAL, {1});
+    large_server.AddDocument(3, "bird"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_HINT(large_server.FindTopDocuments("dog -c?t*"s).empty(), "minus pattern must exclude terms beyond the visit limit"s);
+    const auto large_group_docs = large_server.FindTopDocuments("+c?t*z dog bird"s);
+    ASSERT_EQUAL(large_group_docs.size(), 1);
+    ASSERT_EQUAL(large_group_docs[0].id, 2);
 }
+// Тест проверяет нечёткий поиск слов с опечатками
+void TestFuzzySearch()
+{
+    SearchServer server;
+    server.AddDocument(1, "пушистый кот"s, DocumentStatus::ACTUAL, {5});
+    server.AddDocument(2, "ухоженный пёс"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(3, "curly cat"s, DocumentStatus::ACTUAL, {3});
 
-#define RUN_TEST(func) RunTestImpl((func), #func)
+    // Без нечёткого режима слова с опечатками ничего не находят
+    ASSERT(server.FindTopDocuments("пушстый"s).empty());
+
+    server.SetFuzzyMaxDistance(2);
+    const auto found_docs = server.FindTopDocuments("пушстый"s);
+    ASSERT_EQUAL(found_docs.size(), 1);
+    ASSERT_EQUAL(found_docs[0].id, 1);
+
+    ASSERT_EQUAL(server.FindTopDocuments("ухожeнный -кот"s).size(), 1);
+    ASSERT_EQUAL(server.FindTopDocuments(std::execution::par, "crly cta"s).size(), 1);
+    ASSERT_EQUAL(server.FindTopDocuments("+cta кот"s).size(), 1);
+
+    // Короткие слова не исправляются
+    ASSERT(server.FindTopDocuments("ct"s).empty());
+
+    const TermDictionary dictionary({"cat"sv, "cattle"sv, "cut"sv, "dog"sv});
+    const auto terms = dictionary.FindFuzzy("cot"sv, 1, 10);
+    ASSERT_EQUAL(terms.size(), 2);
+    ASSERT_EQUAL(terms[0].second, 1);
+    ASSERT_EQUAL(dictionary.FindFuzzy("cattle"sv, 0, 10).size(), 1);
+
+    try
+    {
+        server.SetFuzzyMaxDistance(3);
+        ASSERT_HINT(false, "distance above 2 must be rejected"s);
+    }
+    catch(const std::invalid_argument&)
+    {
+    }
+}
+// Тест проверяет формулы ранжирования BM25 и BM25F
+void TestRankers()
+{
+    SearchServer server;
+    server.AddDocument(1, "кот пёс"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "кот кот кот пёс попугай хомяк"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(3, "пёс"s, DocumentStatus::ACTUAL, {3});
+
+    const auto is_actual = [](int, DocumentStatus status, int) { return status == DocumentStatus::ACTUAL; };
+
+    // TF-IDF остаётся ранжированием по умолчанию
+    ASSERT_EQUAL(server.FindTopDocuments("кот"s, is_actual)[0].relevance, server.FindTopDocuments<TfIdfRanker>("кот"s, is_actual)[0].relevance);
+
+    const auto found_docs = server.FindTopDocuments<Bm25Ranker>("кот"s, is_actual);
+    ASSERT_EQUAL(found_docs.size(), 2);
+
+    const double average_length = (2.0 + 6.0 + 1.0) / 3.0;
+    const double idf = log(1.0 + (3.0 - 2.0 + 0.5) / (2.0 + 0.5));
+    const double norm_doc_2 = 1.2 * (1.0 - 0.75 + 0.75 * 6.0 / average_length);
+    const double relevance_doc_2 = idf * 3.0 * 2.2 / (3.0 + norm_doc_2);
+    const double norm_doc_1 = 1.2 * (1.0 - 0.75 + 0.75 * 2.0 / average_length);
+    const double relevance_doc_1 = idf * 1.0 * 2.2 / (1.0 + norm_doc_1);
+
+    ASSERT_EQUAL(found_docs[0].id, 2);
+    ASSERT(std::abs(found_docs[0].relevance - relevance_doc_2) < 1e-9);
+    ASSERT(std::abs(found_docs[1].relevance - relevance_doc_1) < 1e-9);
+
+    // С одним полем BM25F совпадает с BM25
+    const auto bm25f_docs = server.FindTopDocuments<Bm25FRanker>(std::execution::par, "кот"s, is_actual);
+    ASSERT(std::abs(bm25f_docs[0].relevance - relevance_doc_2) < 1e-9);
+}
+
+// Тест проверяет токенизацию, приведение регистра и стемминг
+void TestTokenization()
+{
+    const Tokenizer tokenizer;
+    std::string buffer;
+    const auto words = tokenizer.Tokenize("Кот,  пёс\tи «Ёж»—CAT! cur*"sv, buffer);
+    ASSERT_EQUAL(words, (std::vector<std::string_view>{"кот"sv, "пес"sv, "и"sv, "еж"sv, "cat"sv, "cur"sv}));
+    ASSERT_EQUAL(tokenizer.Tokenize("cur* c?t"sv, buffer, true), (std::vector<std::string_view>{"cur*"sv, "c?t"sv}));
+
+    const Tokenizer stemmer(true);
+    ASSERT_EQUAL(stemmer.Stem("книгами"sv), "книг"sv);
+    ASSERT_EQUAL(stemmer.Stem("кот"sv), "кот"sv);
+    ASSERT_EQUAL(stemmer.Stem("cats"sv), "cat"sv);
+
+    {
+        SearchServer server("И в"s);
+        server.AddDocument(1, "Белый КОТ и\tмодный ошейник."s, DocumentStatus::ACTUAL, {1});
+        server.AddDocument(2, "Пёс, ёж  и кот!"s, DocumentStatus::ACTUAL, {2});
+
+        ASSERT_EQUAL(server.FindTopDocuments("кот"s).size(), 2);
+        ASSERT_EQUAL(server.FindTopDocuments("ПЕС"s).size(), 1);
+        ASSERT_EQUAL(server.FindTopDocuments("кот -Ошейник,"s).size(), 1);
+        ASSERT(server.FindTopDocuments("и"s).empty());
+        ASSERT_EQUAL(server.GetWordFrequencies(1).size(), 4);
+
+        const auto [matched_words, status] = server.MatchDocument(std::execution::par, "КОТ Белый ёж"s, 1);
+        ASSERT_EQUAL(matched_words, (std::vector<std::string_view>{"белый"sv, "кот"sv}));
+    }
+
+    {
+        SearchServer server;
+        server.SetStemmingEnabled(true);
+        server.AddDocument(1, "читать книги"s, DocumentStatus::ACTUAL, {1});
+        ASSERT_EQUAL(server.FindTopDocuments("книгами"s).size(), 1);
+
+        try
+        {
+            server.SetStemmingEnabled(false);
+            ASSERT_HINT(false, "stemming cannot be switched after indexing"s);
+        }
+        catch(const std::logic_error&)
+        {
+        }
+    }
+}
+
+// Тест проверяет битовые карты и фильтрацию документов по индексам статусов и рейтингов
+void TestAttributeFilter()
+{
+    {
+        RoaringBitmap odd;
+        RoaringBitmap small;
+        for(uint32_t value = 1; value < 20000; value += 2)
+        {
+            odd.Add(value);
+        }
+        small.Add(3);
+        small.Add(4);
+        small.Add(70001);
+
+        ASSERT_EQUAL(odd.Cardinality(), 10000);
+        ASSERT((odd & small).ToVector() == std::vector<uint32_t>{3});
+        ASSERT_EQUAL((odd | small).Cardinality(), 10002);
+        ASSERT_EQUAL((odd - small).Cardinality(), 9999);
+
+        for(uint32_t value = 1; value < 20000; value += 4)
+        {
+            odd.Remove(value);
+        }
+        ASSERT_EQUAL(odd.Cardinality(), 5000);
+        ASSERT(odd.Contains(3) && !odd.Contains(5));
+    }
+
+    SearchServer server;
+    server.AddDocument(0, "белый кот"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(1, "чёрный кот"s, DocumentStatus::BANNED, {5});
+    server.AddDocument(2, "рыжий кот"s, DocumentStatus::ACTUAL, {7});
+    server.AddDocument(3, "кот и пёс"s, DocumentStatus::BANNED, {9});
+
+    const auto ids = [](const std::vector<Document>& documents) {
+        std::vector<int> result;
+        for(const Document& document : documents)
+        {
+            result.push_back(document.id);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    };
+
+    ASSERT_EQUAL(ids(server.FindTopDocuments("кот"s, DocumentStatus::BANNED)), (std::vector<int>{1, 3}));
+    ASSERT_EQUAL(ids(server.FindTopDocuments("кот"s, DocumentFilter{std::nullopt, 5, 7})), (std::vector<int>{1, 2}));
+    ASSERT_EQUAL(ids(server.FindTopDocuments(std::execution::par, "кот"s, DocumentFilter{DocumentStatus::ACTUAL, 2})), (std::vector<int>{2}));
+    ASSERT_EQUAL(ids(server.FindTopDocuments("кот"s, DocumentFilter{})).size(), 4);
+    ASSERT(server.FindTopDocuments("кот"s, DocumentFilter{DocumentStatus::REMOVED}).empty());
+
+    // Декларативный фильтр и лямбда дают одинаковую релевантность
+    const auto by_filter = server.FindTopDocuments<Bm25Ranker>("кот пёс"s, DocumentFilter{DocumentStatus::BANNED});
+    const auto by_lambda = server.FindTopDocuments<Bm25Ranker>("кот пёс"s, [](int, DocumentStatus status, int) { return status == DocumentStatus::BANNED; });
+    ASSERT_EQUAL(by_filter.size(), by_lambda.size());
+    ASSERT_EQUAL(by_filter[0].id, by_lambda[0].id);
+    ASSERT(std::abs(by_filter[0].relevance - by_lambda[0].relevance) < 1e-9);
+
+    server.RemoveDocument(3);
+    ASSERT_EQUAL(ids(server.FindTopDocuments("кот"s, DocumentStatus::BANNED)), (std::vector<int>{1}));
+    ASSERT(server.FindTopDocuments("кот"s, DocumentFilter{std::nullopt, 8}).empty());
+}
+
+// Тест проверяет частоты слов документа из прямого индекса
+void TestWordFrequencies()
+{
+    SearchServer server("и"s);
+    server.AddDocument(0, "кот и пёс и кот"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(1, "пёс"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(2, "кот пёс кот"s, DocumentStatus::ACTUAL, {3});
+
+    const auto frequencies = server.GetWordFrequencies(0);
+    ASSERT_EQUAL(frequencies.size(), 2);
+
+    std::map<std::string_view, double> word_to_freq;
+    for(const auto [word, freq] : frequencies)
+    {
+        word_to_freq[word] = freq;
+    }
+    ASSERT(std::abs(word_to_freq.at("кот"sv) - 2.0 / 3.0) < 1e-12);
+    ASSERT(std::abs(word_to_freq.at("пес"sv) - 1.0 / 3.0) < 1e-12);
+
+    server.RemoveDocument(1);
+    ASSERT_EQUAL(server.GetWordFrequencies(0).size(), 2);
+    ASSERT_EQUAL(server.FindTopDocuments("пёс"s).size(), 2);
+    ASSERT_EQUAL(std::get<0>(server.MatchDocument("пёс кот"s, 2)), (std::vector<std::string_view>{"кот"sv, "пес"sv}));
+}
+
+// Тест проверяет хранение TF с пониженной точностью
+void TestTermFreqPrecision()
+{
+    for(const double value : {1.0, 0.5, 1.0 / 3.0, 1.0 / 70.0, 1e-4})
+    {
+        ASSERT(std::abs(DecodeFloat16(EncodeFloat16(value)) - value) <= value / 2048.0);
+        ASSERT(std::abs(DecodeLogUint8(EncodeLogUint8(value)) - value) <= value * 0.023);
+    }
+
+    const auto fill_server = [](SearchServer& server) {
+        server.AddDocument(1, "белый кот и модный ошейник"s, DocumentStatus::ACTUAL, {8, -3});
+        server.AddDocument(2, "пушистый кот пушистый хвост"s, DocumentStatus::ACTUAL, {7, 2, 7});
+        server.AddDocument(3, "ухоженный пёс выразительные глаза"s, DocumentStatus::ACTUAL, {5, -12, 2, 1});
+    };
+
+    SearchServer exact_server;
+    fill_server(exact_server);
+    const auto exact_docs = exact_server.FindTopDocuments("пушистый ухоженный кот"s);
+
+    for(const TermFreqPrecision precision : {TermFreqPrecision::FLOAT16, TermFreqPrecision::UINT8})
+    {
+        SearchServer server;
+        server.SetTermFreqPrecision(precision);
+        fill_server(server);
+
+        const auto found_docs = server.FindTopDocuments("пушистый ухоженный кот"s);
+        ASSERT_EQUAL(found_docs.size(), exact_docs.size());
+        for(size_t i = 0; i < found_docs.size(); ++i)
+        {
+            ASSERT_EQUAL(found_docs[i].id, exact_docs[i].id);
+            ASSERT(std::abs(found_docs[i].relevance - exact_docs[i].relevance) <= exact_docs[i].relevance * 0.023);
+        }
+
+        try
+        {
+            server.SetTermFreqPrecision(TermFreqPrecision::EXACT);
+            ASSERT_HINT(false, "precision cannot be switched after indexing"s);
+        }
+        catch(const std::logic_error&)
+        {
+        }
+    }
+}
+
+void TestScoreKernel()
+{
+    std::vector<double> term_freqs;
+    std::vector<uint16_t> half_term_freqs;
+    for(int i = 1; i <= 37; ++i)
+    {
+        term_freqs.push_back(1.0 / i);
+        half_term_freqs.push_back(EncodeFloat16(1.0 / i));
+    }
+
+    std::vector<double> expected(term_freqs.size());
+    std::vector<double> expected_half(term_freqs.size());
+    ScaleTermFreqs(SimdLevel::SCALAR, term_freqs.data(), term_freqs.size(), 0.5, expected.data());
+    ScaleTermFreqs(SimdLevel::SCALAR, half_term_freqs.data(), half_term_freqs.size(), 0.5, expected_half.data());
+
+    for(const SimdLevel level : {SimdLevel::AVX2, SimdLevel::AVX512})
+    {
+        std::vector<double> out(term_freqs.size());
+        ScaleTermFreqs(level, term_freqs.data(), term_freqs.size(), 0.5, out.data());
+        ASSERT_EQUAL_HINT(out, expected, std::string(GetSimdLevelName(level)));
+        ScaleTermFreqs(level, half_term_freqs.data(), half_term_freqs.size(), 0.5, out.data());
+        ASSERT_EQUAL_HINT(out, expected_half, std::string(GetSimdLevelName(level)));
+    }
+
+    {
+        ScoreBuffer scores(5000);
+        const std::vector<int> ids = {3, 1500, 4999};
+        const std::vector<double> contributions = {1.0, 2.0, 3.0};
+        scores.Add(ids.data(), contributions.data(), ids.size());
+        scores.Add(3, 0.5);
+
+        std::vector<int> touched_ids;
+        std::vector<double> touched_scores;
+        scores.ForEach([&](int document_id, double score) {
+            touched_ids.push_back(document_id);
+            touched_scores.push_back(score);
+        });
+        ASSERT_EQUAL(touched_ids, ids);
+        ASSERT_EQUAL(touched_scores, std::vector<double>({1.5, 2.0, 3.0}));
+    }
+
+    {
+        SearchServer server;
+        server.SetExecutionThresholds({1, 1});
+        for(int id = 0; id < 3000; id += 7)
+        {
+            server.AddDocument(id, id % 2 ? "пушистый кот"s : "ухоженный пёс и кот"s, static_cast<DocumentStatus>(id % 3), {id % 10});
+        }
+
+        const auto seq_docs = server.FindTopDocuments(std::execution::seq, "пушистый кот -пёс"s, DocumentFilter{DocumentStatus::ACTUAL});
+        const auto par_docs = server.FindTopDocuments(std::execution::par, "пушистый кот -пёс"s, DocumentFilter{DocumentStatus::ACTUAL});
+        ASSERT(!seq_docs.empty());
+        ASSERT_EQUAL(seq_docs.size(), par_docs.size());
+        for(size_t i = 0; i < seq_docs.size(); ++i)
+        {
+            ASSERT_EQUAL(seq_docs[i].id, par_docs[i].id);
+            ASSERT(std::abs(seq_docs[i].relevance - par_docs[i].relevance) < 1e-9);
+        }
+
+        // Узкий фильтр вместе с обязательным словом обходит только свою часть пространства id
+        const DocumentFilter narrow_filter{DocumentStatus::BANNED, 4, 4};
+        const auto seq_required = server.FindTopDocuments(std::execution::seq, "+ухоженный кот"s, narrow_filter);
+        const auto par_required = server.FindTopDocuments(std::execution::par, "+ухоженный кот"s, narrow_filter);
+        ASSERT_EQUAL(seq_required.size(), 5u);
+        ASSERT_EQUAL(seq_required.size(), par_required.size());
+        for(size_t i = 0; i < seq_required.size(); ++i)
+        {
+            ASSERT_EQUAL(seq_required[i].id, par_required[i].id);
+            ASSERT_EQUAL(seq_required[i].rating, 4);
+        }
+
+        const auto predicate = [](int document_id, DocumentStatus, int) { return document_id % 3 == 0; };
+        const auto predicate_docs = server.FindTopDocuments("кот -пушистый"s, predicate);
+        ASSERT(!predicate_docs.empty());
+        for(const Document& document : predicate_docs)
+        {
+            ASSERT_EQUAL(document.id % 42, 0);
+        }
+    }
+
+    {
+        SparseScoreBuffer scores;
+        const std::vector<int> ids = {2000000000, 3};
+        const std::vector<double> contributions = {1.0, 2.0};
+        scores.Add(ids.data(), contributions.data(), ids.size());
+        scores.Add(3, 0.5);
+
+        using ScoreMap = std::map<int, double>;
+        ScoreMap touched;
+        scores.ForEach([&touched](int document_id, double score) {
+            touched[document_id] = score;
+        });
+        ASSERT_EQUAL(touched, (ScoreMap{{3, 2.5}, {2000000000, 1.0}}));
+    }
+
+    {
+        // Редкие id: буфер размером с максимальный id занял бы десятки мегабайт
+        SearchServer server;
+        server.SetExecutionThresholds({1, 1});
+        server.AddDocument(1, "пушистый кот"s, DocumentStatus::ACTUAL, {5});
+        server.AddDocument(2000000000, "пушистый пёс"s, DocumentStatus::ACTUAL, {2});
+        server.AddDocument(1500000000, "кот"s, DocumentStatus::ACTUAL, {3});
+
+        for(const auto& documents : {server.FindTopDocuments(std::execution::seq, "пушистый кот -пёс"s), server.FindTopDocuments(std::execution::par, "пушистый кот -пёс"s)})
+        {
+            ASSERT_EQUAL(documents.size(), 2u);
+            ASSERT_EQUAL(documents[0].id, 1);
+            ASSERT_EQUAL(documents[1].id, 1500000000);
+        }
+        const auto filtered = server.FindTopDocuments(std::execution::par, "пушистый"s, DocumentFilter{DocumentStatus::ACTUAL, 2, 2});
+        ASSERT_EQUAL(filtered.size(), 1u);
+        ASSERT_EQUAL(filtered[0].id, 2000000000);
+    }
+
+    {
+        RoaringBitmap bitmap;
+        for(uint32_t value = 0; value < 200000; value += 3)
+        {
+            bitmap.Add(value);
+        }
+        bitmap.Add(1u << 31);
+
+        std::vector<uint32_t> expected;
+        for(uint32_t value = 65532; value < 131075; value += 3)
+        {
+            expected.push_back(value);
+        }
+        std::vector<uint32_t> in_range;
+        bitmap.ForEachInRange(65530, 131075, [&in_range](uint32_t value) { in_range.push_back(value); });
+        ASSERT_EQUAL(in_range, expected);
+
+        in_range.clear();
+        bitmap.ForEachInRange(199990, uint64_t{1} << 32, [&in_range](uint32_t value) { in_range.push_back(value); });
+        ASSERT_EQUAL(in_range, (std::vector<uint32_t>{199992, 199995, 199998, 1u << 31}));
+    }
+}
+
+void TestQueryExecutor()
+{
+    SearchServer server;
+    for(int id = 0; id < 2000; ++id)
+    {
+        server.AddDocument(id, id % 3 ? "пушистый кот пушистый хвост"s : "ухоженный пёс и кот"s, DocumentStatus::ACTUAL, {id % 10});
+    }
+
+    QueryExecutor executor(server, 2);
+    ASSERT_EQUAL(executor.GetThreadCount(), 2u);
+
+    std::vector<std::future<SearchResult>> results;
+    const std::vector<std::string> queries = {"пушистый кот"s, "ухоженный пёс"s, "кот -хвост"s};
+    for(const std::string& query : queries)
+    {
+        results.push_back(executor.Submit(query, std::chrono::seconds(60)));
+    }
+
+    for(size_t i = 0; i < queries.size(); ++i)
+    {
+        const SearchResult result = results[i].get();
+        ASSERT(result.is_complete);
+        const auto expected = server.FindTopDocuments(queries[i]);
+        ASSERT_EQUAL(result.documents.size(), expected.size());
+        for(size_t j = 0; j < expected.size(); ++j)
+        {
+            ASSERT_EQUAL(result.documents[j].id, expected[j].id);
+        }
+    }
+
+    {
+        const SearchResult result = executor.Submit("пушистый кот"s, std::chrono::steady_clock::duration::zero()).get();
+        ASSERT_HINT(!result.is_complete, "expired deadline must stop the query"s);
+        ASSERT(result.documents.empty());
+    }
+
+    {
+        auto control = std::make_shared<QueryControl>();
+        control->Cancel();
+        const SearchResult result = executor.Submit("пушистый кот"s, DocumentFilter{}, control).get();
+        ASSERT(!result.is_complete);
+        ASSERT(control->WasStopped());
+    }
+
+    try
+    {
+        executor.Submit("пушистый кот"s, std::shared_ptr<QueryControl>());
+        ASSERT_HINT(false, "query without control must be rejected"s);
+    }
+    catch(const std::invalid_argument&)
+    {
+    }
+
+    {
+        QueryControl control;
+        const SearchResult result = server.FindTopDocuments("пушистый кот"s, DocumentFilter{}, control);
+        ASSERT(result.is_complete);
+        ASSERT_EQUAL(result.documents.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+    }
+}
+
+void TestAdmissionControl()
+{
+    SearchServer server;
+    for(int id = 0; id < 100; ++id)
+    {
+        server.AddDocument(id, id % 4 ? "пушистый кот пушистый хвост"s : "ухоженный пёс и кот"s, DocumentStatus::ACTUAL, {id % 10});
+    }
+    ASSERT_EQUAL(server.EstimateQueryCost("пушистый -пёс"s), 100u);
+    ASSERT_EQUAL(server.EstimateQueryCost("кот кот попугай"s), 100u);
+
+    {
+        AdmissionLimits limits;
+        limits.max_query_cost = 80;
+        limits.degraded_query_cost = 30;
+        RequestQueue queue(server, limits);
+
+        ASSERT(queue.HandleRequest("кот"s, RequestPriority::HIGH).outcome == RequestOutcome::REJECTED);
+        const RequestResult degraded = queue.HandleRequest("пушистый"s, RequestPriority::NORMAL);
+        ASSERT(degraded.outcome == RequestOutcome::DEGRADED);
+        ASSERT_EQUAL(degraded.search_result.documents.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+        ASSERT(queue.HandleRequest("ухоженный"s, RequestPriority::LOW).outcome == RequestOutcome::COMPLETED);
+        ASSERT(queue.AddFindRequest("кот"s).empty());
+
+        const AdmissionStats stats = queue.GetAdmissionStats();
+        ASSERT_EQUAL(stats.rejected_requests, 2u);
+        ASSERT_EQUAL(stats.degraded_requests, 1u);
+        ASSERT_EQUAL(stats.completed_requests, 1u);
+        ASSERT_EQUAL_HINT(queue.GetNoResultRequests(), 2, "rejected requests have no results"s);
+
+        // Запрос с ошибкой не считается ни выполненным, ни запросом без результатов
+        try
+        {
+            queue.HandleRequest("кот --пёс"s, RequestPriority::NORMAL);
+            ASSERT_HINT(false, "invalid query must be reported"s);
+        }
+        catch(const std::invalid_argument&)
+        {
+        }
+        ASSERT_EQUAL(queue.GetAdmissionStats().failed_requests, 1u);
+        ASSERT_EQUAL(queue.GetAdmissionStats().completed_requests, 1u);
+        ASSERT_EQUAL(queue.GetNoResultRequests(), 2);
+        ASSERT_EQUAL(queue.GetRequestStats().request_count, 4u);
+    }
+
+    {
+        // Слотов нет: запрос ждёт не дольше max_queue_time, а при полной очереди отклоняется сразу
+        AdmissionLimits limits;
+        limits.max_concurrent_requests = 0;
+        limits.max_queue_time = std::chrono::milliseconds(5);
+        RequestQueue queue(server, limits);
+
+        const RequestResult result = queue.HandleRequest("кот"s, RequestPriority::NORMAL);
+        ASSERT(result.outcome == RequestOutcome::REJECTED);
+        ASSERT(result.queue_time >= std::chrono::milliseconds(5));
+        // Запрос не разбирается, пока не получил слот
+        ASSERT(queue.HandleRequest("кот --пёс"s, RequestPriority::NORMAL).outcome == RequestOutcome::REJECTED);
+        ASSERT_EQUAL(queue.GetNoResultRequests(), 2);
+
+        limits.max_queued_requests = 0;
+        RequestQueue full_queue(server, limits);
+        ASSERT(full_queue.HandleRequest("кот"s, RequestPriority::HIGH).outcome == RequestOutcome::REJECTED);
+        ASSERT(full_queue.GetAdmissionStats().max_queue_time < std::chrono::milliseconds(5));
+    }
+
+    {
+        AdmissionLimits limits;
+        limits.max_concurrent_requests = 1;
+        RequestQueue queue(server, limits);
+
+        std::vector<std::thread> clients;
+        for(int i = 0; i < 4; ++i)
+        {
+            clients.emplace_back([&queue, i]() {
+                for(int j = 0; j < 10; ++j)
+                {
+                    queue.HandleRequest("пушистый кот"s, static_cast<RequestPriority>(i % 3));
+                }
+            });
+        }
+        for(std::thread& client : clients)
+        {
+            client.join();
+        }
+
+        ASSERT_EQUAL(queue.GetAdmissionStats().completed_requests, 40u);
+        ASSERT_EQUAL(queue.GetNoResultRequests(), 0);
+    }
+}
+
+void TestSlidingWindowStats()
+{
+    using namespace std::chrono;
+
+    const auto start = SlidingWindowStats::Clock::now();
+    SlidingWindowStats stats(seconds(10), 10, start);
+
+    stats.Record(0, start);
+    stats.Record(3, start);
+    stats.Record(100, start + seconds(4));
+    {
+        const WindowStatsSnapshot snapshot = stats.GetSnapshot(start + seconds(5));
+        ASSERT_EQUAL(snapshot.request_count, 3u);
+        ASSERT_EQUAL(snapshot.no_result_count, 1u);
+        ASSERT_EQUAL(snapshot.result_count_distribution[3], 1u);
+        ASSERT_EQUAL(snapshot.result_count_distribution[RESULT_COUNT_BIN_COUNT - 1], 1u);
+        // Окно ещё не заполнено: частота считается за 5 прошедших секунд, а не за все 10
+        ASSERT(std::abs(snapshot.queries_per_second - 0.6) < 1e-9);
+    }
+
+    // Интервал start выходит из окна, и его счётчики переиспользуются новыми записями
+    stats.Record(0, start + seconds(11));
+    {
+        const WindowStatsSnapshot snapshot = stats.GetSnapshot(start + seconds(11));
+        ASSERT_EQUAL(snapshot.request_count, 2u);
+        ASSERT_EQUAL(snapshot.no_result_count, 1u);
+        ASSERT(std::abs(snapshot.queries_per_second - 0.2) < 1e-9);
+    }
+
+    {
+        // Суточное окно сразу после создания: частота не занижена в 86400 / 2 раз
+        SlidingWindowStats daily_stats(hours(24), 1440, start);
+        for(int i = 0; i < 10; ++i)
+        {
+            daily_stats.Record(1, start);
+        }
+        ASSERT(std::abs(daily_stats.GetSnapshot(start + seconds(2)).queries_per_second - 5.0) < 1e-9);
+        ASSERT(std::abs(daily_stats.GetSnapshot(start).queries_per_second - 10.0) < 1e-9);
+    }
+    ASSERT_EQUAL(stats.GetSnapshot(start + seconds(30)).request_count, 0u);
+
+    {
+        SlidingWindowStats shared_stats(hours(1), 60);
+        std::vector<std::thread> threads;
+        for(int i = 0; i < 4; ++i)
+        {
+            threads.emplace_back([&shared_stats, i]() {
+                for(int j = 0; j < 10000; ++j)
+                {
+                    shared_stats.Record((i + j) % 2);
+                }
+            });
+        }
+        for(std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        const WindowStatsSnapshot snapshot = shared_stats.GetSnapshot();
+        ASSERT_EQUAL(snapshot.request_count, 40000u);
+        ASSERT_EQUAL(snapshot.no_result_count, 20000u);
+    }
+
+    try
+    {
+        SlidingWindowStats empty_stats(seconds(1), 0);
+        ASSERT_HINT(false, "window without intervals must be rejected"s);
+    }
+    catch(const std::invalid_argument&)
+    {
+    }
+}
+
+void TestExplainQuery()
+{
+    SearchServer server("и"s);
+    server.AddDocument(1, "белый кот и модный ошейник"s, DocumentStatus::ACTUAL, {8, -3});
+    server.AddDocument(2, "пушистый кот пушистый хвост"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    server.AddDocument(3, "ухоженный пёс выразительные глаза"s, DocumentStatus::ACTUAL, {5, -12, 2, 1});
+    server.AddDocument(4, "пушистый пёс"s, DocumentStatus::BANNED, {1});
+
+    const QueryPlan plan = server.ExplainQuery("пушистый кот -ошейник"s);
+    ASSERT_EQUAL(plan.terms.size(), 3u);
+    ASSERT_EQUAL(plan.terms[0].word, "кот"s);
+    ASSERT_EQUAL(plan.terms[0].posting_count, 2u);
+    ASSERT(std::abs(plan.terms[0].inverse_document_freq - std::log(2.0)) < COMPARISON_ERROR);
+    ASSERT_EQUAL(plan.terms[1].word, "пушистый"s);
+    ASSERT(plan.terms[2].kind == QueryTermKind::MINUS);
+    ASSERT_EQUAL(plan.estimated_cost, 5u);
+    ASSERT_EQUAL(plan.filtered_document_count, 3u);
+    ASSERT(plan.strategy == ExecutionStrategy::SEQUENTIAL);
+    ASSERT_EQUAL(plan.matched_document_count, 1u);
+
+    const auto expected = server.FindTopDocuments("пушистый кот -ошейник"s);
+    ASSERT_EQUAL(plan.documents.size(), expected.size());
+    ASSERT_EQUAL(plan.documents[0].id, expected[0].id);
+
+    std::ostringstream out;
+    out << plan;
+    ASSERT(out.str().find("+ кот: 2 postings"s) != std::string::npos);
+    ASSERT(out.str().find("- ошейник: 1 postings"s) != std::string::npos);
+
+    server.SetExecutionThresholds({4, 2});
+    ASSERT(server.ChooseExecutionStrategy(3) == ExecutionStrategy::SEQUENTIAL);
+    ASSERT(server.ChooseExecutionStrategy(4) == ExecutionStrategy::PARALLEL);
+    ASSERT(server.ExplainQuery("пушистый кот -ошейник"s).strategy == ExecutionStrategy::PARALLEL);
+}
+
+void TestExecutionThresholds()
+{
+    const ExecutionThresholds& calibrated = GetCalibratedExecutionThresholds();
+    if(std::thread::hardware_concurrency() <= 1)
+    {
+        ASSERT_EQUAL(calibrated.parallel_posting_count, SIZE_MAX);
+        ASSERT_EQUAL(calibrated.parallel_document_count, SIZE_MAX);
+    }
+    ASSERT(calibrated.parallel_posting_count > 0 && calibrated.parallel_document_count > 0);
+
+    const auto fill_server = [](SearchServer& server) {
+        for(int id = 0; id < 300; ++id)
+        {
+            server.AddDocument(id, id % 2 ? "пушистый кот пушистый хвост"s : "ухоженный пёс и кот"s, static_cast<DocumentStatus>(id % 2), {id % 10});
+        }
+    };
+
+    // Нулевые пороги включают параллельные ветви на любом объёме работы, результаты не должны меняться
+    SearchServer sequential_server;
+    SearchServer parallel_server;
+    sequential_server.SetExecutionThresholds({SIZE_MAX, SIZE_MAX});
+    parallel_server.SetExecutionThresholds({0, 0});
+    fill_server(sequential_server);
+    fill_server(parallel_server);
+
+    const auto ids = [](const std::vector<Document>& documents) {
+        std::vector<int> result;
+        for(const Document& document : documents)
+        {
+            result.push_back(document.id);
+        }
+        return result;
+    };
+    ASSERT_EQUAL(ids(parallel_server.FindTopDocuments("пушистый кот -пёс"s, DocumentStatus::IRRELEVANT)),
+                 ids(sequential_server.FindTopDocuments("пушистый кот -пёс"s, DocumentStatus::IRRELEVANT)));
+    ASSERT_EQUAL(ids(parallel_server.FindTopDocuments(std::execution::par, "кот"s)), ids(sequential_server.FindTopDocuments("кот"s)));
+
+    const std::vector<int> document_ids = {1, 2, 3, 4};
+    const auto parallel_matches = parallel_server.MatchDocuments("пушистый кот"s, document_ids);
+    const auto sequential_matches = sequential_server.MatchDocuments("пушистый кот"s, document_ids);
+    for(size_t i = 0; i < document_ids.size(); ++i)
+    {
+        ASSERT_EQUAL(std::get<0>(parallel_matches[i]), std::get<0>(sequential_matches[i]));
+    }
+
+    parallel_server.RemoveDocument(1);
+    sequential_server.RemoveDocument(std::execution::seq, 1);
+    ASSERT_EQUAL(parallel_server.GetDocumentCount(), sequential_server.GetDocumentCount());
+    ASSERT_EQUAL(ids(parallel_server.FindTopDocuments("хвост"s, DocumentStatus::IRRELEVANT)),
+                 ids(sequential_server.FindTopDocuments("хвост"s, DocumentStatus::IRRELEVANT)));
+}
+
+void TestMemoryStats()
+{
+    {
+        SearchServer server;
+        ASSERT_EQUAL(server.GetMemoryStats().GetTotalBytes(), 0u);
+    }
+
+    SearchServer server("и в на"s);
+    const MemoryStats empty_stats = server.GetMemoryStats();
+    ASSERT(empty_stats.stop_words_bytes > 0);
+    ASSERT_EQUAL(empty_stats.GetTotalBytes(), empty_stats.stop_words_bytes);
+
+    server.AddDocument(1, "белый кот и модный ошейник"s, DocumentStatus::ACTUAL, {8, -3});
+    server.AddDocument(2, "пушистый кот пушистый хвост"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    const MemoryStats stats = server.GetMemoryStats();
+    ASSERT(stats.term_dictionary_bytes > 0);
+    ASSERT(stats.inverted_index_bytes > 0);
+    ASSERT(stats.positional_index_bytes > 0);
+    ASSERT(stats.forward_index_bytes > 0);
+    ASSERT(stats.document_metadata_bytes > 0);
+    ASSERT_EQUAL(stats.stop_words_bytes, empty_stats.stop_words_bytes);
+
+    server.RemoveDocument(1);
+    const MemoryStats removed_stats = server.GetMemoryStats();
+    ASSERT(removed_stats.forward_index_bytes < stats.forward_index_bytes);
+    ASSERT(removed_stats.document_metadata_bytes < stats.document_metadata_bytes);
+    // Слова не удаляются из словаря вместе с документом
+    ASSERT_EQUAL(removed_stats.term_dictionary_bytes, stats.term_dictionary_bytes);
+
+    std::ostringstream out;
+    out << removed_stats;
+    ASSERT(out.str().find("total = "s + std::to_string(removed_stats.GetTotalBytes())) != std::string::npos);
+}
+
+void TestIndexAllocator()
+{
+    {
+        CountingMemoryResource upstream;
+        SlabMemoryResource slab(&upstream, &upstream);
+
+        void* small = slab.allocate(40);
+        ASSERT_EQUAL(slab.GetReservedBytes(), SLAB_CHUNK_SIZE);
+        slab.deallocate(small, 40);
+        // Освобождённый блок возвращается следующему запросу того же класса размеров
+        ASSERT_EQUAL(slab.allocate(48), small);
+
+        void* large = slab.allocate(SLAB_MAX_BLOCK_SIZE + 1);
+        ASSERT_EQUAL(upstream.GetAllocatedBytes(), SLAB_CHUNK_SIZE + SLAB_MAX_BLOCK_SIZE + 1);
+        slab.deallocate(large, SLAB_MAX_BLOCK_SIZE + 1);
+        ASSERT_EQUAL(upstream.GetAllocatedBytes(), SLAB_CHUNK_SIZE);
+
+        // Блоки одного класса не пересекаются
+        std::vector<char*> blocks;
+        for(int i = 0; i < 1000; ++i)
+        {
+            blocks.push_back(static_cast<char*>(slab.allocate(SLAB_MAX_BLOCK_SIZE)));
+        }
+        std::sort(blocks.begin(), blocks.end());
+        for(size_t i = 1; i < blocks.size(); ++i)
+        {
+            ASSERT(blocks[i] - blocks[i - 1] >= static_cast<std::ptrdiff_t>(SLAB_MAX_BLOCK_SIZE));
+        }
+    }
+
+    {
+        HugePageMemoryResource huge_pages;
+        void* pointer = huge_pages.allocate(100);
+        ASSERT_EQUAL(huge_pages.GetMappedBytes(), HUGE_PAGE_SIZE);
+#if defined(__linux__)
+        ASSERT_EQUAL_HINT(reinterpret_cast<uintptr_t>(pointer) % HUGE_PAGE_SIZE, 0u, "Mapping must be aligned for transparent huge pages"s);
+#endif
+        static_cast<char*>(pointer)[HUGE_PAGE_SIZE - 1] = 1;
+        huge_pages.deallocate(pointer, 100);
+        ASSERT_EQUAL(huge_pages.GetMappedBytes(), 0u);
+
+        void* first = huge_pages.allocate(HUGE_PAGE_SIZE + 1);
+        void* second = huge_pages.allocate(100);
+        ASSERT_EQUAL(huge_pages.GetMappedBytes(), 3 * HUGE_PAGE_SIZE);
+        static_cast<char*>(first)[2 * HUGE_PAGE_SIZE - 1] = 1;
+        static_cast<char*>(second)[HUGE_PAGE_SIZE - 1] = 1;
+        huge_pages.deallocate(first, HUGE_PAGE_SIZE + 1);
+        huge_pages.deallocate(second, 100);
+        ASSERT_EQUAL(huge_pages.GetMappedBytes(), 0u);
+    }
+
+    const auto fill_server = [](SearchServer& server) {
+        server.AddDocument(1, "белый кот и модный ошейник"s, DocumentStatus::ACTUAL, {8, -3});
+        server.AddDocument(2, "пушистый кот пушистый хвост"s, DocumentStatus::ACTUAL, {7, 2, 7});
+        server.AddDocument(3, "ухоженный пёс выразительные глаза"s, DocumentStatus::ACTUAL, {5, -12, 2, 1});
+        server.AddDocument(4, "ухоженный скворец евгений"s, DocumentStatus::BANNED, {9});
+        server.RemoveDocument(3);
+        server.AddDocument(5, "пушистый пёс и кот"s, DocumentStatus::ACTUAL, {1});
+    };
+
+    SearchServer heap_server("и в на"s);
+    fill_server(heap_server);
+    const std::vector<Document> expected = heap_server.FindTopDocuments("пушистый ухоженный кот -ошейник"s);
+    ASSERT(heap_server.GetIndexAllocator() == IndexAllocator::DEFAULT);
+
+    for(const IndexAllocator allocator : {IndexAllocator::SLAB, IndexAllocator::SLAB_HUGE_PAGES})
+    {
+        SearchServer server("и в на"s);
+        server.SetIndexAllocator(allocator);
+        ASSERT(server.GetIndexAllocator() == allocator);
+        fill_server(server);
+
+        const std::vector<Document> found = server.FindTopDocuments("пушистый ухоженный кот -ошейник"s);
+        ASSERT_EQUAL(found.size(), expected.size());
+        for(size_t i = 0; i < found.size(); ++i)
+        {
+            ASSERT_EQUAL(found[i].id, expected[i].id);
+            ASSERT(std::abs(found[i].relevance - expected[i].relevance) < 1e-12);
+        }
+        // Учёт памяти не зависит от источника
+        ASSERT_EQUAL(server.GetMemoryStats().GetTotalBytes(), heap_server.GetMemoryStats().GetTotalBytes());
+
+        try
+        {
+            server.SetIndexAllocator(IndexAllocator::DEFAULT);
+            ASSERT_HINT(false, "allocator change after AddDocument must be rejected"s);
+        }
+        catch(const std::logic_error&)
+        {
+        }
+    }
+}
+
+void TestCorpusReader()
+{
+    const std::string tsv = "1\tACTUAL\t8,-3\tбелый кот и модный ошейник\r\n"s
+                            "\n"s
+                            "2\tBANNED\t7 2 7\tпушистый кот\tпушистый хвост\n"s
+                            "3\tIRRELEVANT\t\tухоженный пёс"s;
+    const std::string jsonl = "{\"id\": 1, \"status\": \"ACTUAL\", \"ratings\": [8, -3], \"text\": \"белый кот и модный ошейник\"}\n"s
+                              "{\"text\": \"пушистый \\\"кот\\\"\\tпушистый \\u0445\\u0432\\u043Ets\", \"meta\": {\"tags\": [\"a\", \"}\"]}, \"id\": 2, \"status\": \"BANNED\", \"ratings\": [7, 2, 7]}\n"s
+                              "  \n"s
+                              "{\"id\": 3, \"status\": \"IRRELEVANT\", \"text\": \"ухоженный пёс\"}\n"s;
+
+    // Маленькие пакеты разбиваются на части по одной строке
+    for(const size_t batch_size : {size_t{1}, size_t{40}, CORPUS_BATCH_SIZE})
+    {
+        for(const auto& [format, data] : {std::pair{CorpusFormat::TSV, std::string_view(tsv)}, std::pair{CorpusFormat::JSONL, std::string_view(jsonl)}})
+        {
+            CorpusReader reader(data, format, batch_size);
+            std::vector<DocumentRecord> records;
+            std::vector<CorpusBatch> batches;
+            for(CorpusBatch batch; reader.ReadBatch(batch);)
+            {
+                records.insert(records.end(), batch.documents.begin(), batch.documents.end());
+                batches.push_back(std::move(batch));
+            }
+            ASSERT_EQUAL(reader.GetBytesRead(), data.size());
+
+            ASSERT_EQUAL(records.size(), 3u);
+            ASSERT_EQUAL(records[0].id, 1);
+            ASSERT(records[0].status == DocumentStatus::ACTUAL);
+            ASSERT_EQUAL(records[0].ratings, (std::vector<int>{8, -3}));
+            ASSERT_EQUAL(records[0].text, "белый кот и модный ошейник"sv);
+            ASSERT(records[1].status == DocumentStatus::BANNED);
+            ASSERT_EQUAL(records[1].ratings, (std::vector<int>{7, 2, 7}));
+            ASSERT_EQUAL(records[1].text, format == CorpusFormat::TSV ? "пушистый кот\tпушистый хвост"sv : "пушистый \"кот\"\tпушистый хвоts"sv);
+            ASSERT(records[2].ratings.empty());
+            ASSERT_EQUAL(records[2].text, "ухоженный пёс"sv);
+
+            // Тексты без экранирования не копируются
+            ASSERT(records[0].text.data() >= data.data() && records[0].text.data() < data.data() + data.size());
+        }
+    }
+
+    for(const std::string& malformed : {"1\tACTUAL\tкот\n"s, "x\tACTUAL\t\tкот\n"s, "1\tDELETED\t\tкот\n"s})
+    {
+        CorpusReader reader(malformed, CorpusFormat::TSV);
+        CorpusBatch batch;
+        try
+        {
+            reader.ReadBatch(batch);
+            ASSERT_HINT(false, "malformed TSV record must be rejected"s);
+        }
+        catch(const std::invalid_argument&)
+        {
+        }
+    }
+    for(const std::string& malformed : {"{\"id\": 1}\n"s, "{\"id\": 1, \"text\": \"кот}\n"s, "{\"id\": 1, \"text\": \"кот\"} x\n"s})
+    {
+        CorpusReader reader(malformed, CorpusFormat::JSONL);
+        CorpusBatch batch;
+        try
+        {
+            reader.ReadBatch(batch);
+            ASSERT_HINT(false, "malformed JSONL record must be rejected"s);
+        }
+        catch(const std::invalid_argument&)
+        {
+        }
+    }
+
+    const std::string path = (std::filesystem::temp_directory_path() / "search_server_test_corpus.tsv").string();
+    std::ofstream(path, std::ios::binary) << tsv;
+    SearchServer loaded_server("и в на"s);
+    ASSERT_EQUAL(LoadCorpus(loaded_server, path, CorpusFormat::TSV), 3u);
+    std::filesystem::remove(path);
+
+    SearchServer server("и в на"s);
+    server.AddDocument(1, "белый кот и модный ошейник"s, DocumentStatus::ACTUAL, {8, -3});
+    server.AddDocument(2, "пушистый кот\tпушистый хвост"s, DocumentStatus::BANNED, {7, 2, 7});
+    server.AddDocument(3, "ухоженный пёс"s, DocumentStatus::IRRELEVANT, {});
+    for(const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED, DocumentStatus::IRRELEVANT})
+    {
+        const std::vector<Document> expected = server.FindTopDocuments("пушистый кот пёс"s, status);
+        const std::vector<Document> found = loaded_server.FindTopDocuments("пушистый кот пёс"s, status);
+        ASSERT_EQUAL(found.size(), expected.size());
+        for(size_t i = 0; i < found.size(); ++i)
+        {
+            ASSERT_EQUAL(found[i].id, expected[i].id);
+            ASSERT_EQUAL(found[i].rating, expected[i].rating);
+            ASSERT(std::abs(found[i].relevance - expected[i].relevance) < 1e-12);
+        }
+    }
+
+    // Ошибка в пакете оставляет добавленными документы до неё
+    SearchServer batch_server;
+    try
+    {
+        batch_server.AddDocuments({{5, DocumentStatus::ACTUAL, {1}, "кот"sv}, {5, DocumentStatus::ACTUAL, {2}, "пёс"sv}});
+        ASSERT_HINT(false, "duplicate id in a batch must be rejected"s);
+    }
+    catch(const std::invalid_argument&)
+    {
+    }
+    ASSERT_EQUAL(batch_server.GetDocumentCount(), 1);
+}
+
+#if defined(__linux__)
+// Ограничивает размер файлов процесса: запись за пределом завершается ошибкой EFBIG вместо сигнала SIGXFSZ.
+// Прежний предел восстанавливается в деструкторе
+class FileSizeLimit
+{
+    public:
+        explicit FileSizeLimit(rlim_t limit)
+        {
+            getrlimit(RLIMIT_FSIZE, &previous_limit_);
+            previous_handler_ = std::signal(SIGXFSZ, SIG_IGN);
+            const rlimit new_limit{limit, previous_limit_.rlim_max};
+            setrlimit(RLIMIT_FSIZE, &new_limit);
+        }
+
+        ~FileSizeLimit()
+        {
+            setrlimit(RLIMIT_FSIZE, &previous_limit_);
+            std::signal(SIGXFSZ, previous_handler_);
+        }
+
+        FileSizeLimit(const FileSizeLimit&) = delete;
+        FileSizeLimit& operator=(const FileSizeLimit&) = delete;
+
+    private:
+        rlimit previous_limit_{};
+        void (*previous_handler_)(int) = SIG_DFL;
+};
+#endif
+
+void TestWriteAheadLog()
+{
+    ASSERT_EQUAL(ComputeCrc32("123456789"sv), 0xCBF43926u);
+
+    struct Mutation
+    {
+        bool is_add;
+        int id;
+        std::string text;
+        DocumentStatus status;
+        std::vector<int> ratings;
+    };
+    const std::vector<Mutation> mutations = {
+        {true, 1, "белый кот и модный ошейник"s, DocumentStatus::ACTUAL, {8, -3}},
+        {true, 2, "пушистый кот пушистый хвост"s, DocumentStatus::ACTUAL, {7, 2, 7}},
+        {false, 1, {}, {}, {}},
+        {true, 3, "ухоженный пёс выразительные глаза"s, DocumentStatus::ACTUAL, {}},
+        {true, 4, "ухоженный кот евгений"s, DocumentStatus::BANNED, {9}},
+        {false, 3, {}, {}, {}},
+    };
+    const auto apply = [](SearchServer& server, const Mutation& mutation) {
+        if(mutation.is_add)
+        {
+            server.AddDocument(mutation.id, mutation.text, mutation.status, mutation.ratings);
+        }
+        else
+        {
+            server.RemoveDocument(mutation.id);
+        }
+    };
+    const auto find_all = [](const SearchServer& server) {
+        return server.FindTopDocuments("кот пёс хвост"s, [](int, DocumentStatus, int) { return true; });
+    };
+
+    const std::string path = (std::filesystem::temp_directory_path() / "search_server_test.wal").string();
+    const std::string crash_path = path + ".crash"s;
+    std::filesystem::remove(path);
+
+    // Каждая запись фиксируется отдельно, размер файла после неё — граница записи
+    std::vector<size_t> record_ends = {0};
+    {
+        WriteAheadLog wal(path, {0, 0});
+        for(const Mutation& mutation : mutations)
+        {
+            if(mutation.is_add)
+            {
+                wal.LogAddDocument(mutation.id, mutation.text, mutation.status, mutation.ratings);
+            }
+            else
+            {
+                wal.LogRemoveDocument(mutation.id);
+            }
+            ASSERT_EQUAL(wal.GetPendingRecordCount(), 0u);
+            record_ends.push_back(std::filesystem::file_size(path));
+        }
+        ASSERT_EQUAL(wal.GetSyncCount(), mutations.size());
+    }
+
+    std::string log_data;
+    {
+        std::ifstream file(path, std::ios::binary);
+        log_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    ASSERT_EQUAL(log_data.size(), record_ends.back());
+
+    // Сбой после любого байта: восстанавливаются ровно целиком записанные изменения
+    for(size_t crash_offset = 0; crash_offset <= log_data.size(); ++crash_offset)
+    {
+        std::ofstream(crash_path, std::ios::binary | std::ios::trunc) << log_data.substr(0, crash_offset);
+
+        const size_t complete_count = std::upper_bound(record_ends.begin(), record_ends.end(), crash_offset) - record_ends.begin() - 1;
+        SearchServer expected_server;
+        for(size_t i = 0; i < complete_count; ++i)
+        {
+            apply(expected_server, mutations[i]);
+        }
+
+        SearchServer server;
+        const WalReplayStats stats = ReplayWriteAheadLog(crash_path, server);
+        ASSERT_EQUAL(stats.applied_records, complete_count);
+        ASSERT_EQUAL(stats.valid_bytes, record_ends[complete_count]);
+        ASSERT_EQUAL(stats.discarded_bytes, crash_offset - record_ends[complete_count]);
+        ASSERT_EQUAL(std::vector<int>(server.begin(), server.end()), std::vector<int>(expected_server.begin(), expected_server.end()));
+
+        const std::vector<Document> expected = find_all(expected_server);
+        const std::vector<Document> found = find_all(server);
+        ASSERT_EQUAL(found.size(), expected.size());
+        for(size_t i = 0; i < found.size(); ++i)
+        {
+            ASSERT_EQUAL(found[i].id, expected[i].id);
+            ASSERT_EQUAL(found[i].rating, expected[i].rating);
+            ASSERT(std::abs(found[i].relevance - expected[i].relevance) < 1e-12);
+        }
+    }
+
+    // Оборванный хвост отрезается при открытии, новые записи идут следом за целыми
+    std::ofstream(crash_path, std::ios::binary | std::ios::trunc) << log_data.substr(0, record_ends[4] + 5);
+    {
+        WriteAheadLog wal(crash_path);
+        ASSERT_EQUAL(std::filesystem::file_size(crash_path), record_ends[4]);
+        wal.LogRemoveDocument(2);
+    }
+    {
+        SearchServer server;
+        ASSERT_EQUAL(ReplayWriteAheadLog(crash_path, server).applied_records, 5u);
+        ASSERT_EQUAL(std::vector<int>(server.begin(), server.end()), (std::vector<int>{3}));
+    }
+
+    // Повреждённая запись в середине останавливает восстановление перед ней
+    std::string corrupted = log_data;
+    corrupted[record_ends[2] + 10] ^= 0x40;
+    std::ofstream(crash_path, std::ios::binary | std::ios::trunc) << corrupted;
+    {
+        SearchServer server;
+        const WalReplayStats stats = ReplayWriteAheadLog(crash_path, server);
+        ASSERT_EQUAL(stats.applied_records, 2u);
+        ASSERT_EQUAL(stats.discarded_bytes, log_data.size() - record_ends[2]);
+    }
+
+    // Групповая фиксация: записи ждут в буфере, пока группа не наберётся
+    {
+        WriteAheadLog wal(path, {3, 1024 * 1024});
+        wal.Truncate();
+        ASSERT_EQUAL(std::filesystem::file_size(path), 0u);
+
+        wal.LogAddDocument(1, "кот"sv, DocumentStatus::ACTUAL, {1});
+        wal.LogAddDocument(2, "пёс"sv, DocumentStatus::ACTUAL, {2});
+        ASSERT_EQUAL(wal.GetPendingRecordCount(), 2u);
+        ASSERT_EQUAL(std::filesystem::file_size(path), 0u);
+        wal.LogRemoveDocument(1);
+        ASSERT_EQUAL(wal.GetPendingRecordCount(), 0u);
+        ASSERT_EQUAL(wal.GetSyncCount(), 1u);
+
+        wal.LogAddDocument(3, "хвост"sv, DocumentStatus::ACTUAL, {});
+        wal.Sync();
+        ASSERT_EQUAL(wal.GetSyncCount(), 2u);
+    }
+    {
+        SearchServer server;
+        ASSERT_EQUAL(ReplayWriteAheadLog(path, server).applied_records, 4u);
+        ASSERT_EQUAL(std::vector<int>(server.begin(), server.end()), (std::vector<int>{2, 3}));
+    }
+
+#if defined(__linux__)
+    // Группа, записанная на диск частично, отрезается, и журнал больше не принимает записи.
+    // Иначе повторная запись буфера оставила бы оборванную запись перед следующими
+    std::filesystem::remove(path);
+    uintmax_t synced_size = 0;
+    {
+        WriteAheadLog wal(path, {0, 0});
+        wal.LogAddDocument(1, "кот"sv, DocumentStatus::ACTUAL, {1});
+        synced_size = std::filesystem::file_size(path);
+        {
+            const FileSizeLimit limit(synced_size + 10);
+            try
+            {
+                wal.LogAddDocument(2, "пушистый пёс с длинным хвостом"sv, DocumentStatus::ACTUAL, {2});
+                ASSERT_HINT(false, "failed write must be reported"s);
+            }
+            catch(const std::runtime_error&)
+            {
+            }
+        }
+        ASSERT(wal.IsFailed());
+        ASSERT_EQUAL(wal.GetPendingRecordCount(), 0u);
+        ASSERT_EQUAL(std::filesystem::file_size(path), synced_size);
+        try
+        {
+            wal.LogRemoveDocument(1);
+            ASSERT_HINT(false, "failed log must reject new records"s);
+        }
+        catch(const std::runtime_error&)
+        {
+        }
+    }
+    ASSERT_EQUAL(std::filesystem::file_size(path), synced_size);
+    {
+        WriteAheadLog wal(path);
+        wal.LogAddDocument(3, "хвост"sv, DocumentStatus::ACTUAL, {3});
+        wal.Sync();
+    }
+    {
+        SearchServer server;
+        const WalReplayStats stats = ReplayWriteAheadLog(path, server);
+        ASSERT_EQUAL(stats.applied_records, 2u);
+        ASSERT_EQUAL(stats.discarded_bytes, 0u);
+        ASSERT_EQUAL(std::vector<int>(server.begin(), server.end()), (std::vector<int>{1, 3}));
+    }
+#endif
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(crash_path);
+}
+
+void TestSearchService()
+{
+    const std::string pipelined = "POST /documents?id=1&status=ACTUAL&ratings=8,-3 HTTP/1.1\r\nContent-Length: 48\r\n\r\n"s
+                                  "белый кот и модный ошейник"s
+                                  "GET /search?query=%D0%BA%D0%BE%D1%82+-%D0%BE%D1%88%D0%B5%D0%B9%D0%BD%D0%B8%D0%BA HTTP/1.1\r\n"s
+                                  "connection: close\r\n\r\n"s
+                                  "GET /search?query=x HTTP/1.1\r\nContent-Length: 10\r\n\r\n123"s;
+    std::vector<HttpRequest> requests(3);
+    size_t parsed_size = ParseHttpRequest(pipelined, requests[0]);
+    ASSERT_EQUAL(requests[0].method, "POST"s);
+    ASSERT_EQUAL(requests[0].path, "/documents"s);
+    ASSERT_EQUAL(requests[0].params.at("ratings"s), "8,-3"s);
+    ASSERT_EQUAL(requests[0].body, "белый кот и модный ошейник"s);
+    ASSERT(requests[0].keep_alive);
+    const size_t second_size = ParseHttpRequest(std::string_view(pipelined).substr(parsed_size), requests[1]);
+    ASSERT(second_size > 0);
+    ASSERT_EQUAL(requests[1].params.at("query"s), "кот -ошейник"s);
+    ASSERT(!requests[1].keep_alive);
+    parsed_size += second_size;
+    // Тело третьего запроса пришло не целиком
+    ASSERT_EQUAL(ParseHttpRequest(std::string_view(pipelined).substr(parsed_size), requests[2]), 0u);
+
+    try
+    {
+        HttpRequest request;
+        ParseHttpRequest("GET /search HTTP/2\r\n\r\n"sv, request);
+        ASSERT_HINT(false, "unsupported HTTP version must be rejected"s);
+    }
+    catch(const std::invalid_argument&)
+    {
+    }
+    ASSERT_EQUAL(DecodeUrl(EncodeUrl("пушистый кот & 100%"sv)), "пушистый кот & 100%"s);
+
+    SearchServer server("и в на"s);
+    SearchService service(server);
+    const auto make_request = [](std::string method, std::string path, std::map<std::string, std::string, std::less<>> params, std::string body = {}) {
+        return HttpRequest{std::move(method), std::move(path), std::move(params), std::move(body), true};
+    };
+    const std::vector<HttpRequest> batch = {
+        make_request("GET"s, "/search"s, {{"query"s, "кот"s}}),
+        make_request("POST"s, "/documents"s, {{"id"s, "1"s}, {"ratings"s, "8,-3"s}}, "белый кот и модный ошейник"s),
+        make_request("POST"s, "/documents"s, {{"id"s, "2"s}, {"status"s, "BANNED"s}}, "пушистый кот"s),
+        make_request("GET"s, "/search"s, {{"query"s, "кот"s}}),
+        make_request("GET"s, "/match"s, {{"query"s, "модный \"кот\""s}, {"id"s, "1"s}}),
+        make_request("GET"s, "/search"s, {{"query"s, "кот"s}, {"status"s, "BANNED"s}}),
+        make_request("DELETE"s, "/documents"s, {{"id"s, "1"s}}),
+        make_request("GET"s, "/search"s, {{"query"s, "кот"s}}),
+        make_request("POST"s, "/documents"s, {{"id"s, "2"s}}, "пёс"s),
+        make_request("GET"s, "/match"s, {{"query"s, "кот"s}, {"id"s, "42"s}}),
+        make_request("GET"s, "/unknown"s, {}),
+        make_request("PUT"s, "/documents"s, {{"id"s, "3"s}}),
+    };
+    std::vector<const HttpRequest*> batch_pointers;
+    for(const HttpRequest& request : batch)
+    {
+        batch_pointers.push_back(&request);
+    }
+
+    // Чтения видят ровно те изменения, что стоят раньше них в пакете
+    const std::vector<HttpResponse> responses = service.HandleBatch(batch_pointers);
+    ASSERT_EQUAL(responses[0].body, "[]"s);
+    ASSERT_EQUAL(responses[1].body, "{\"id\": 1}"s);
+    ASSERT(responses[3].body.find("\"id\": 1,"s) != std::string::npos);
+    ASSERT(responses[3].body.find("\"rating\": 2}"s) != std::string::npos);
+    ASSERT_EQUAL(responses[4].body, "{\"words\": [\"кот\", \"модный\"], \"status\": \"ACTUAL\"}"s);
+    ASSERT(responses[5].body.find("\"id\": 2,"s) != std::string::npos);
+    ASSERT_EQUAL(responses[6].status, 200);
+    ASSERT_EQUAL(responses[7].body, "[]"s);
+    ASSERT_EQUAL(responses[8].status, 400);
+    ASSERT_EQUAL(responses[9].status, 404);
+    ASSERT_EQUAL(responses[10].status, 404);
+    ASSERT_EQUAL(responses[11].status, 405);
+    ASSERT_EQUAL(server.GetDocumentCount(), 1);
+
+    const std::string response = SerializeHttpResponse(responses[1], true);
+    ASSERT_EQUAL(response, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 9\r\nConnection: keep-alive\r\n\r\n{\"id\": 1}"s);
+
+#if defined(__linux__)
+    // Конвейер через сокет: три запроса одной записью, ответы в порядке запросов
+    HttpServer http_server(service, 0);
+    std::thread server_thread([&http_server]() {
+        http_server.Run();
+    });
+
+    const int client = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(http_server.GetPort());
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQUAL(connect(client, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+
+    const std::string client_requests = "POST /documents?id=5 HTTP/1.1\r\nContent-Length: 19\r\n\r\nчёрный кот"s
+                                        "GET /search?query=%D0%BA%D0%BE%D1%82 HTTP/1.1\r\n\r\n"s
+                                        "DELETE /documents?id=5 HTTP/1.1\r\nConnection: close\r\n\r\n"s;
+    ASSERT_EQUAL(send(client, client_requests.data(), client_requests.size(), 0), static_cast<ssize_t>(client_requests.size()));
+
+    // Сервер закрывает соединение после запроса с Connection: close
+    std::string client_input;
+    char buffer[4096];
+    for(ssize_t read_size; (read_size = recv(client, buffer, sizeof(buffer), 0)) > 0;)
+    {
+        client_input.append(buffer, read_size);
+    }
+    close(client);
+    http_server.Stop();
+    server_thread.join();
+
+    const size_t first = client_input.find("{\"id\": 5}"s);
+    const size_t second = client_input.find("[{\"id\": 5,"s);
+    const size_t third = client_input.find("Connection: close\r\n\r\n{\"id\": 5}"s);
+    ASSERT(first != std::string::npos && second != std::string::npos && third != std::string::npos);
+    ASSERT(first < second && second < third);
+    ASSERT_EQUAL(http_server.GetHandledRequestCount(), 3u);
+    ASSERT_EQUAL(server.GetDocumentCount(), 1);
+
+    // Журнал, который не может расти: не записанное в журнал изменение не применяется, ошибка фиксации пакета
+    // превращается в ответы 500 на его изменения, а индекс с незафиксированными изменениями больше не отдаётся
+    const std::string wal_path = (std::filesystem::temp_directory_path() / "search_service_test.wal").string();
+    std::filesystem::remove(wal_path);
+    SearchServer wal_server;
+    {
+        WriteAheadLog wal(wal_path, {0, 0});
+        SearchService wal_service(wal_server, &wal);
+        const FileSizeLimit limit(0);
+        ASSERT_EQUAL(wal_service.Handle(make_request("POST"s, "/documents"s, {{"id"s, "1"s}}, "кот"s)).status, 500);
+        ASSERT_EQUAL(wal_server.GetDocumentCount(), 0);
+        ASSERT_EQUAL(wal_service.Handle(make_request("GET"s, "/search"s, {{"query"s, "кот"s}})).status, 200);
+    }
+    ASSERT_EQUAL(std::filesystem::file_size(wal_path), 0u);
+    std::filesystem::remove(wal_path);
+    const HttpRequest add = make_request("POST"s, "/documents"s, {{"id"s, "2"s}}, "пёс"s);
+    const HttpRequest search = make_request("GET"s, "/search"s, {{"query"s, "пёс"s}});
+    {
+        WriteAheadLog wal(wal_path);
+        SearchService wal_service(wal_server, &wal);
+        const FileSizeLimit limit(0);
+        const HttpRequest bad_add = make_request("POST"s, "/documents"s, {{"id"s, "-2"s}}, "пёс"s);
+        const std::vector<HttpResponse> wal_responses = wal_service.HandleBatch({&search, &add, &bad_add, &search});
+        ASSERT_EQUAL(wal_responses[0].status, 200);
+        ASSERT_EQUAL(wal_responses[0].body, "[]"s);
+        ASSERT_EQUAL(wal_responses[1].status, 500);
+        ASSERT_EQUAL(wal_responses[2].status, 400);
+        ASSERT_HINT(wal_responses[3].status == 503, "read after a lost write must not see it"s);
+
+        ASSERT_EQUAL(wal_service.Handle(search).status, 503);
+        ASSERT_HINT(wal_service.Handle(add).status == 503, "retried write must not hit a duplicate id"s);
+    }
+    {
+        // После перезапуска индекс восстанавливается по журналу без потерянного изменения
+        SearchServer restored_server;
+        ASSERT_EQUAL(ReplayWriteAheadLog(wal_path, restored_server).applied_records, 0u);
+        WriteAheadLog wal(wal_path);
+        SearchService restored_service(restored_server, &wal);
+        ASSERT_EQUAL(restored_service.Handle(add).status, 200);
+        ASSERT_EQUAL(restored_service.Handle(search).status, 200);
+        ASSERT_EQUAL(restored_server.GetDocumentCount(), 1);
+    }
+    std::filesystem::remove(wal_path);
+#endif
+}
+
+void TestResultCursors()
+{
+    SearchServer server;
+    // Одинаковые тексты и рейтинги дают равную релевантность, порядок таких документов задаёт id
+    for(int id = 0; id < 60; ++id)
+    {
+        const std::string text = id % 3 == 0 ? "пушистый кот"s : (id % 3 == 1 ? "кот и пёс"s : "скворец и кот в саду"s);
+        server.AddDocument(id, text, DocumentStatus::ACTUAL, {id % 4});
+    }
+    server.AddDocument(100, "скворец"s, DocumentStatus::ACTUAL, {1});
+
+    const std::vector<Document> expected = server.FindRankedDocuments("кот"s, DocumentFilter{DocumentStatus::ACTUAL}, 1000);
+    ASSERT_EQUAL(expected.size(), 60u);
+    ASSERT_EQUAL(server.FindRankedDocuments("кот"s, DocumentFilter{DocumentStatus::ACTUAL}, 5).size(), 5u);
+    const std::vector<Document> top = server.FindTopDocuments("кот"s);
+    for(size_t i = 0; i < top.size(); ++i)
+    {
+        ASSERT_EQUAL(top[i].id, expected[i].id);
+    }
+
+    // Сравнение с погрешностью образует цикл на цепочке близких релевантностей, точный ключ — нет
+    const Document high{1, 1.4e-6, 0};
+    const Document middle{2, 0.7e-6, 1};
+    const Document low{3, 0.0, 2};
+    ASSERT(SearchServer::IsRankedBefore(high, low) && SearchServer::IsRankedBefore(low, middle) && SearchServer::IsRankedBefore(middle, high));
+    ASSERT(SearchServer::IsRankedStrictlyBefore(high, middle) && SearchServer::IsRankedStrictlyBefore(middle, low));
+    ASSERT(!SearchServer::IsRankedStrictlyBefore(low, high));
+    ASSERT(SearchServer::IsRankedStrictlyBefore(Document{1, 0.5, 3}, Document{2, 0.5, 2}));
+    ASSERT(SearchServer::IsRankedStrictlyBefore(Document{1, 0.5, 2}, Document{2, 0.5, 2}));
+    ASSERT(!SearchServer::IsRankedStrictlyBefore(Document{1, 0.5, 2}, Document{1, 0.5, 2}));
+
+    const auto collect_ids = [](ResultCursors& cursors, ResultPage page, size_t page_size) {
+        std::vector<int> ids;
+        while(true)
+        {
+            for(const Document& document : page.documents)
+            {
+                ids.push_back(document.id);
+            }
+            if(page.next_cursor.empty())
+            {
+                return ids;
+            }
+            page = cursors.Next(page.next_cursor, page_size);
+        }
+    };
+    std::vector<int> expected_ids;
+    for(const Document& document : expected)
+    {
+        expected_ids.push_back(document.id);
+    }
+
+    // Страницы внутри одного окна и с повторным выполнением запроса на границах окон
+    for(const size_t max_candidates : {size_t{1000}, size_t{7}, size_t{1}})
+    {
+        for(const size_t page_size : {size_t{1}, size_t{5}, size_t{10}, size_t{60}, size_t{100}})
+        {
+            ResultCursors cursors(server, {max_candidates, 16, std::chrono::seconds(60)});
+            ASSERT_EQUAL_HINT(collect_ids(cursors, cursors.Open("кот"s, page_size), page_size), expected_ids, "Pages must concatenate to the full ranking"s);
+            ASSERT_EQUAL_HINT(cursors.GetOpenCursorCount(), 0u, "The last page closes the cursor"s);
+        }
+    }
+
+    {
+        ResultCursors cursors(server, {7, 16, std::chrono::seconds(60)});
+        ASSERT(cursors.Open("скворец"s, 50).next_cursor.empty());
+        ASSERT(cursors.Open("слон"s, 5).documents.empty());
+
+        const ResultPage banned = cursors.Open("кот"s, [](int, DocumentStatus, int rating) { return rating == 0; }, 100);
+        ASSERT_EQUAL(banned.documents.size(), 15u);
+
+        try
+        {
+            cursors.Open("кот"s, 0);
+            ASSERT_HINT(false, "Zero page size must be rejected"s);
+        }
+        catch(const std::invalid_argument&)
+        {
+        }
+    }
+
+    // Изменение индекса между страницами: документы не повторяются, курсор помечается устаревшим
+    {
+        SearchServer changing_server;
+        for(int id = 0; id < 20; ++id)
+        {
+            changing_server.AddDocument(id, "кот"s, DocumentStatus::ACTUAL, {20 - id});
+        }
+        ResultCursors cursors(changing_server, {4, 16, std::chrono::seconds(60)});
+        ResultPage page = cursors.Open("кот"s, 5);
+        ASSERT(!page.is_stale);
+        ASSERT_EQUAL(page.documents.back().id, 4);
+
+        changing_server.RemoveDocument(7);
+        changing_server.AddDocument(50, "кот"s, DocumentStatus::ACTUAL, {100});
+        page = cursors.Next(page.next_cursor, 5);
+        ASSERT(page.is_stale);
+        std::vector<int> ids;
+        for(const Document& document : page.documents)
+        {
+            ids.push_back(document.id);
+        }
+        ASSERT_EQUAL(ids, (std::vector<int>{5, 6, 8, 9, 10}));
+    }
+
+    // Вытеснение давно не использованных курсоров и закрытие по простою
+    {
+        ResultCursors cursors(server, {10, 2, std::chrono::seconds(60)});
+        const std::string first = cursors.Open("кот"s, 5).next_cursor;
+        const std::string second = cursors.Open("кот"s, 5).next_cursor;
+        ASSERT(!first.empty() && first != second);
+        cursors.Next(first, 5);
+        const std::string third = cursors.Open("кот"s, 5).next_cursor;
+        ASSERT_EQUAL(cursors.GetOpenCursorCount(), 2u);
+        ASSERT_EQUAL(cursors.Next(first, 5).documents.size(), 5u);
+        ASSERT_EQUAL(cursors.Next(third, 5).documents.size(), 5u);
+        try
+        {
+            cursors.Next(second, 5);
+            ASSERT_HINT(false, "Evicted cursor must be rejected"s);
+        }
+        catch(const std::out_of_range&)
+        {
+        }
+
+        cursors.Close(first);
+        ASSERT_EQUAL(cursors.GetOpenCursorCount(), 1u);
+
+        ResultCursors expiring_cursors(server, {10, 2, std::chrono::milliseconds(0)});
+        const std::string expired = expiring_cursors.Open("кот"s, 5).next_cursor;
+        try
+        {
+            expiring_cursors.Next(expired, 5);
+            ASSERT_HINT(false, "Idle cursor must expire"s);
+        }
+        catch(const std::out_of_range&)
+        {
+        }
+    }
+}
+
+// Функция TestSearchServer является точкой входа для запуска тестов
+void TestParallelIndexBuild()
+{
+    const std::vector<std::string> texts = {"белый кот и модный ошейник"s, "пушистый кот пушистый хвост"s, "ухоженный пёс выразительные глаза"s,
+                                            "модный ошейник у ухоженный пёс"s, "и в"s, "кот кот кот"s, "скворец евгений и белый пёс"s};
+    std::vector<DocumentRecord> records;
+    // id идут не по порядку, чтобы части строились по отсортированному корпусу
+    for(int i = 0; i < 40; ++i)
+    {
+        const int id = (i * 17) % 40 + 3;
+        records.push_back({id, static_cast<DocumentStatus>(i % 3), {i % 5, 1}, texts[i % texts.size()]});
+    }
+
+    SearchServer expected("и в"s);
+    for(const DocumentRecord& record : records)
+    {
+        expected.AddDocument(record.id, record.text, record.status, record.ratings);
+    }
+
+    const std::vector<std::string> queries = {"пушистый кот"s, "ухоженный -пёс"s, "\"модный ошейник\""s, "кот* глаза"s, "+белый пёс"s};
+    // Нулевые пороги включают параллельное построение и на одном ядре
+    for(const auto& [partition_count, parallel_document_count] : {std::pair{size_t{0}, SIZE_MAX}, std::pair{size_t{1}, SIZE_MAX}, std::pair{size_t{3}, SIZE_MAX},
+                                                                   std::pair{size_t{100}, SIZE_MAX}, std::pair{size_t{0}, size_t{0}}, std::pair{size_t{7}, size_t{0}}})
+    {
+        SearchServer server("и в"s);
+        server.SetExecutionThresholds({SIZE_MAX, parallel_document_count});
+        server.BuildIndex(records, partition_count);
+
+        ASSERT_EQUAL(server.GetDocumentCount(), expected.GetDocumentCount());
+        ASSERT_EQUAL(std::vector<int>(server.begin(), server.end()), std::vector<int>(expected.begin(), expected.end()));
+        for(const int id : expected)
+        {
+            const WordFrequencies expected_frequencies = expected.GetWordFrequencies(id);
+            const WordFrequencies frequencies = server.GetWordFrequencies(id);
+            using FrequencyMap = std::map<std::string_view, double>;
+            ASSERT_EQUAL(FrequencyMap(frequencies.begin(), frequencies.end()), FrequencyMap(expected_frequencies.begin(), expected_frequencies.end()));
+        }
+        for(const std::string& query : queries)
+        {
+            for(const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED})
+            {
+                const auto found = server.FindRankedDocuments(query, DocumentFilter{status}, 100);
+                const auto expected_found = expected.FindRankedDocuments(query, DocumentFilter{status}, 100);
+                ASSERT_EQUAL_HINT(found.size(), expected_found.size(), "Parallel build must rank like serial insertion"s);
+                for(size_t i = 0; i < found.size(); ++i)
+                {
+                    ASSERT_EQUAL(found[i].id, expected_found[i].id);
+                    ASSERT(std::abs(found[i].relevance - expected_found[i].relevance) < 1e-9);
+                    ASSERT_EQUAL(found[i].rating, expected_found[i].rating);
+                }
+            }
+            ASSERT_EQUAL(std::get<0>(server.MatchDocument(query, 3)), std::get<0>(expected.MatchDocument(query, 3)));
+        }
+
+        // Построенный индекс изменяется как обычно
+        server.RemoveDocument(3);
+        server.AddDocument(1, "пушистый скворец"s, DocumentStatus::ACTUAL, {});
+        ASSERT_EQUAL(server.FindTopDocuments("скворец"s)[0].id, 1);
+    }
+
+    {
+        SearchServer server;
+        server.SetPositionalIndexEnabled(false);
+        server.SetTermFreqPrecision(TermFreqPrecision::UINT8);
+        server.BuildIndex(records, 4);
+        ASSERT_EQUAL(server.FindTopDocuments("пушистый"s).size(), 2u);
+    }
+
+    SearchServer server;
+    std::vector<DocumentRecord> invalid_records = records;
+    invalid_records.push_back({records[5].id, DocumentStatus::ACTUAL, {}, "кот"sv});
+    try
+    {
+        server.BuildIndex(invalid_records, 3);
+        ASSERT_HINT(false, "Duplicate id must be rejected"s);
+    }
+    catch(const std::invalid_argument&)
+    {
+    }
+    invalid_records.back() = {100, DocumentStatus::ACTUAL, {}, "к\x12от"sv};
+    try
+    {
+        server.BuildIndex(invalid_records, 3);
+        ASSERT_HINT(false, "Invalid text must be rejected"s);
+    }
+    catch(const std::invalid_argument&)
+    {
+    }
+    ASSERT_EQUAL(server.GetDocumentCount(), 0);
+
+    server.BuildIndex(records, 3);
+    try
+    {
+        server.BuildIndex(records, 3);
+        ASSERT_HINT(false, "Build into a non-empty server must be rejected"s);
+    }
+    catch(const std::logic_error&)
+    {
+    }
+}
+
+void TestStopWordChange()
+{
+    {
+        std::vector<std::string> words;
+        for(int i = 0; i < 500; ++i)
+        {
+            words.push_back("w"s + std::to_string(i * 7));
+        }
+        const StopWordSet stop_words(std::vector<std::string_view>(words.begin(), words.end()));
+        ASSERT_EQUAL(stop_words.size(), 500u);
+        for(int i = 0; i < 3500; ++i)
+        {
+            ASSERT_EQUAL_HINT(stop_words.Contains("w"s + std::to_string(i)), i % 7 == 0, "Every stop word and only them must be found"s);
+        }
+        ASSERT(!stop_words.Contains(""sv));
+        ASSERT(!StopWordSet().Contains("w0"sv));
+    }
+
+    const std::map<int, std::string> texts = {{1, "белый кот и модный ошейник"s}, {2, "пушистый кот пушистый хвост"s},
+                                              {3, "ухоженный пёс и выразительные глаза"s}, {4, "кот и пёс в модный ошейник"s}, {5, "и и и"s}};
+    // Перестроенный индекс должен совпадать с индексом, сразу построенным с новыми стоп-словами
+    const auto assert_same_index = [&texts](const SearchServer& server, const SearchServer& expected) {
+        using FrequencyMap = std::map<std::string_view, double>;
+        for(const auto& [id, text] : texts)
+        {
+            const WordFrequencies frequencies = server.GetWordFrequencies(id);
+            const WordFrequencies expected_frequencies = expected.GetWordFrequencies(id);
+            ASSERT_EQUAL(FrequencyMap(frequencies.begin(), frequencies.end()), FrequencyMap(expected_frequencies.begin(), expected_frequencies.end()));
+        }
+        for(const std::string& query : {"кот пушистый"s, "\"модный ошейник\""s, "\"пёс модный\""s, "и пёс"s, "ошейник"s})
+        {
+            for(const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED})
+            {
+                const auto found = server.FindRankedDocuments(query, DocumentFilter{status}, 10);
+                const auto expected_found = expected.FindRankedDocuments(query, DocumentFilter{status}, 10);
+                ASSERT_EQUAL(found.size(), expected_found.size());
+                for(size_t i = 0; i < found.size(); ++i)
+                {
+                    ASSERT_EQUAL(found[i].id, expected_found[i].id);
+                    ASSERT(std::abs(found[i].relevance - expected_found[i].relevance) < 1e-9);
+                }
+            }
+        }
+    };
+
+    const auto add_documents = [&texts](SearchServer& server) {
+        for(const auto& [id, text] : texts)
+        {
+            server.AddDocument(id, text, id % 2 == 0 ? DocumentStatus::ACTUAL : DocumentStatus::BANNED, {id});
+        }
+    };
+    const auto assert_same_index_as_built = [&](const SearchServer& server, const std::string& stop_words) {
+        SearchServer expected(stop_words);
+        add_documents(expected);
+        assert_same_index(server, expected);
+    };
+    // Новые стоп-слова удаляются из документов по индексу, шагами
+    {
+        SearchServer server("и"s);
+        add_documents(server);
+        server.ChangeStopWords("и кот в"s);
+        ASSERT_EQUAL(server.GetStopWordRebuildBacklog(), 3u);
+        ASSERT(server.FindTopDocuments("кот"s, DocumentStatus::BANNED).empty());
+
+        server.RemoveDocument(2);
+        ASSERT_EQUAL(server.RebuildStopWords(1), 2u);
+        ASSERT_EQUAL(server.RebuildStopWords(), 0u);
+        server.AddDocument(2, texts.at(2), DocumentStatus::ACTUAL, {2});
+        assert_same_index_as_built(server, "и кот в"s);
+
+        server.SetStopWords("пушистый"s);
+        ASSERT_EQUAL(server.GetStopWordRebuildBacklog(), 0u);
+        assert_same_index_as_built(server, "и кот в пушистый"s);
+    }
+
+    // Вернуть стоп-слово в документы можно только по их текстам
+    {
+        SearchServer server("и кот"s);
+        add_documents(server);
+        try
+        {
+            server.ChangeStopWords("и"s);
+            ASSERT_HINT(false, "Removing a stop word without document texts must be rejected"s);
+        }
+        catch(const std::logic_error&)
+        {
+        }
+        ASSERT(server.FindTopDocuments("кот"s).empty());
+
+        server.ChangeStopWords("и"s, [&texts](int id) { return texts.at(id); });
+        ASSERT_EQUAL(server.GetStopWordRebuildBacklog(), texts.size());
+        server.RebuildStopWords();
+        assert_same_index_as_built(server, "и"s);
+    }
+
+    // При стемминге тексты нужны, только если основа нового стоп-слова есть в индексе
+    {
+        SearchServer server;
+        server.SetStemmingEnabled(true);
+        server.AddDocument(1, "running dogs quickly"s, DocumentStatus::ACTUAL, {1});
+        server.SetStopWords("the"s);
+        ASSERT_EQUAL(server.FindTopDocuments("dogs"s).size(), 1u);
+        try
+        {
+            server.SetStopWords("dog"s);
+            ASSERT_HINT(false, "A stop word whose stem is indexed needs document texts"s);
+        }
+        catch(const std::logic_error&)
+        {
+        }
+        ASSERT_EQUAL(server.FindTopDocuments("dogs"s).size(), 1u);
+    }
+
+    // Переиндексация по текстам: сбой источника текстов не теряет документ, а сама перестройка
+    // не считается добавлением документов
+    {
+        SearchServer server("и кот"s);
+        add_documents(server);
+        const uint64_t version_before = server.GetIndexVersion();
+
+        bool is_source_broken = true;
+        server.ChangeStopWords("и"s, [&texts, &is_source_broken](int id) {
+            if(is_source_broken)
+            {
+                throw std::runtime_error("text storage is unavailable");
+            }
+            return id == 1 ? "белый\x01кот"s : texts.at(id);
+        });
+        try
+        {
+            server.RebuildStopWords(1);
+            ASSERT_HINT(false, "Text source failure must be reported"s);
+        }
+        catch(const std::runtime_error&)
+        {
+        }
+        ASSERT_EQUAL(server.GetDocumentCount(), static_cast<int>(texts.size()));
+        ASSERT_EQUAL(server.GetStopWordRebuildBacklog(), texts.size());
+
+        is_source_broken = false;
+        try
+        {
+            server.RebuildStopWords(1);
+            ASSERT_HINT(false, "Invalid document text must be rejected"s);
+        }
+        catch(const std::invalid_argument&)
+        {
+        }
+        ASSERT_EQUAL(server.GetDocumentCount(), static_cast<int>(texts.size()));
+        const auto [matched_words, status] = server.MatchDocument("белый"s, 1);
+        ASSERT_EQUAL(matched_words.size(), 1u);
+        ASSERT(status == DocumentStatus::BANNED);
+        ASSERT_EQUAL(server.GetIndexVersion(), version_before);
+    }
+    {
+        SearchServer server("и кот"s);
+        add_documents(server);
+        const uint64_t added_before = server.GetIndexStats().vocabulary_growth.back().added_document_count;
+        const uint64_t version_before = server.GetIndexVersion();
+        server.ChangeStopWords("и"s, [&texts](int id) { return texts.at(id); });
+        server.RebuildStopWords();
+        ASSERT_EQUAL(server.GetIndexStats().vocabulary_growth.back().added_document_count, added_before);
+        ASSERT_EQUAL(server.GetIndexVersion(), version_before + texts.size());
+        assert_same_index_as_built(server, "и"s);
+    }
+}
+
+void TestIndexStats()
+{
+    {
+        SpaceSavingSketch sketch(3);
+        std::map<std::string, uint64_t> true_weights;
+        for(int i = 0; i < 200; ++i)
+        {
+            const std::string item = i % 2 == 0 ? "a"s : (i % 5 == 1 ? "b"s : "x"s + std::to_string(i));
+            const uint64_t weight = item == "a"s ? 3 : 1;
+            sketch.Add(item, weight);
+            true_weights[item] += weight;
+        }
+
+        const std::vector<HeavyHitter> top = sketch.GetTop(10);
+        ASSERT_EQUAL(top.size(), 3u);
+        // Только вес "a" больше total_weight / capacity, остальные места делят редкие элементы
+        ASSERT_EQUAL(top[0].item, "a"s);
+        for(const HeavyHitter& hitter : top)
+        {
+            ASSERT_HINT(hitter.weight - hitter.error <= true_weights[hitter.item] && true_weights[hitter.item] <= hitter.weight, "True weight must lie within the error bound"s);
+        }
+        ASSERT_EQUAL(sketch.GetTotalWeight(), 400u);
+        SpaceSavingSketch disabled(0);
+        disabled.Add("a"sv);
+        ASSERT(disabled.GetTop(1).empty());
+
+        // Слияние: элементу, которого нет в заполненном скетче, достаётся минимальный счётчик этого скетча
+        SpaceSavingSketch lhs(2);
+        lhs.Add("x"sv, 5);
+        lhs.Add("y"sv, 1);
+        SpaceSavingSketch rhs(2);
+        rhs.Add("x"sv, 2);
+        rhs.Add("z"sv, 4);
+        lhs.Merge(rhs);
+        const std::vector<HeavyHitter> merged = lhs.GetTop(10);
+        ASSERT_EQUAL(merged.size(), 2u);
+        ASSERT_EQUAL(merged[0].item, "x"s);
+        ASSERT_EQUAL(merged[0].weight, 7u);
+        ASSERT_EQUAL(merged[0].error, 0u);
+        ASSERT_EQUAL(merged[1].item, "z"s);
+        ASSERT_EQUAL(merged[1].weight, 5u);
+        ASSERT_EQUAL(merged[1].error, 1u);
+        ASSERT_EQUAL(lhs.GetTotalWeight(), 12u);
+    }
+
+    SearchServer server("и"s);
+    server.AddDocument(1, "белый кот и модный ошейник"s, DocumentStatus::ACTUAL, {8, -3});
+    server.AddDocument(2, "пушистый кот пушистый хвост"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    server.AddDocument(3, "ухоженный пёс выразительные глаза"s, DocumentStatus::ACTUAL, {5, -12, 2, 1});
+    server.AddDocument(4, "кот и пёс"s, DocumentStatus::ACTUAL, {9});
+
+    IndexStats stats = server.GetIndexStats(2);
+    ASSERT_EQUAL(stats.document_count, 4u);
+    ASSERT_EQUAL(stats.vocabulary_size, 10u);
+    ASSERT_EQUAL(stats.live_term_count, 10u);
+    ASSERT_EQUAL(stats.posting_count, 13u);
+    // Восемь слов в одном документе, пёс в двух, кот в трёх
+    ASSERT_EQUAL(stats.document_frequency_histogram, (std::vector<size_t>{8, 2}));
+    ASSERT_EQUAL(stats.heaviest_terms.size(), 2u);
+    ASSERT_EQUAL(stats.heaviest_terms[0].word, "кот"s);
+    ASSERT_EQUAL(stats.heaviest_terms[0].document_count, 3u);
+    ASSERT_EQUAL(stats.heaviest_terms[1].word, "пес"s);
+    ASSERT(stats.costliest_query_terms.empty());
+    ASSERT_EQUAL(stats.vocabulary_growth.size(), 1u);
+    ASSERT_EQUAL(stats.vocabulary_growth[0].added_document_count, 4u);
+
+    // Вес слова запроса — длина его постингов, поэтому частый короткий запрос легче редкого дорогого
+    for(int i = 0; i < 2; ++i)
+    {
+        server.FindTopDocuments("кот хвост слон"s);
+    }
+    for(int i = 0; i < 5; ++i)
+    {
+        server.FindTopDocuments("хвост -глаза"s);
+    }
+    stats = server.GetIndexStats(3);
+    ASSERT_EQUAL(stats.costliest_query_terms.size(), 3u);
+    ASSERT_EQUAL(stats.costliest_query_terms[0].item, "хвост"s);
+    ASSERT_EQUAL(stats.costliest_query_terms[0].weight, 7u);
+    ASSERT_EQUAL(stats.costliest_query_terms[1].item, "кот"s);
+    ASSERT_EQUAL(stats.costliest_query_terms[1].weight, 6u);
+    ASSERT_EQUAL(stats.costliest_query_terms[2].item, "глаза"s);
+    ASSERT_EQUAL(stats.total_query_posting_count, 18u);
+
+    // Запросы из разных потоков попадают в разные скетчи, GetIndexStats сливает их
+    {
+        std::vector<std::thread> threads;
+        for(int i = 0; i < 4; ++i)
+        {
+            threads.emplace_back([&server]() {
+                for(int j = 0; j < 50; ++j)
+                {
+                    server.FindTopDocuments("пёс"s);
+                }
+            });
+        }
+        for(std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+    stats = server.GetIndexStats(1);
+    ASSERT_EQUAL(stats.costliest_query_terms[0].item, "пес"s);
+    ASSERT_EQUAL(stats.costliest_query_terms[0].weight, 400u);
+    ASSERT_EQUAL(stats.total_query_posting_count, 418u);
+
+    // Окна курсора продолжают один запрос и учитываются один раз
+    {
+        ResultCursors cursors(server, CursorLimits{1});
+        ResultPage page = cursors.Open("кот"s, 1);
+        while(!page.next_cursor.empty())
+        {
+            page = cursors.Next(page.next_cursor, 1);
+        }
+    }
+    ASSERT_EQUAL(server.GetIndexStats().total_query_posting_count, 421u);
+
+    server.RemoveDocument(2);
+    stats = server.GetIndexStats();
+    ASSERT_EQUAL(stats.vocabulary_size, 10u);
+    ASSERT_EQUAL(stats.live_term_count, 8u);
+
+    // Рост словаря записывается каждые VOCABULARY_SAMPLE_INTERVAL документов
+    for(int id = 10; id < 10 + 2500; ++id)
+    {
+        server.AddDocument(id, "слово"s + std::to_string(id % 1200), DocumentStatus::ACTUAL, {});
+    }
+    stats = server.GetIndexStats();
+    ASSERT_EQUAL(stats.vocabulary_growth.size(), 3u);
+    ASSERT_EQUAL(stats.vocabulary_growth[0].added_document_count, VOCABULARY_SAMPLE_INTERVAL);
+    ASSERT_EQUAL(stats.vocabulary_growth[0].vocabulary_size, 10u + 996u);
+    ASSERT_EQUAL(stats.vocabulary_growth[1].vocabulary_size, 10u + 1200u);
+    ASSERT_EQUAL(stats.vocabulary_growth[2].added_document_count, 2504u);
+
+    SearchService service(server);
+    const HttpResponse response = service.Handle(HttpRequest{"GET"s, "/stats"s, {{"top"s, "1"s}}, ""s, true});
+    ASSERT_EQUAL(response.status, 200);
+    ASSERT(response.body.find("\"document_count\": 2503"s) != std::string::npos);
+    ASSERT(response.body.find("\"costliest_query_terms\": [{\"word\": \"пес\", \"posting_count\": 400"s) != std::string::npos);
+    ASSERT_EQUAL(service.Handle(HttpRequest{"GET"s, "/stats"s, {{"top"s, "-1"s}}, ""s, true}).status, 400);
+}
+
+template <typename T>
+void RunTestImpl(T func, const std::string& func_name)
+{
+    func();
+    std::cerr << func_name << " OK" << std::endl;
+}
+
+#define RUN_TEST(func) RunTestImpl((func), #func)
 
-// Функция TestSearchServer является точкой входа для запуска тестов
 void TestSearchServer()
 {
     RUN_TEST(TestAddDocumentContent);
@@ -399,6 +2423,29 @@ void TestSearchServer()
     RUN_TEST(TestRatingDocuments);
     RUN_TEST(TestStatusFilter);
     RUN_TEST(TestPredicateFilter);
+    RUN_TEST(TestBooleanAndPhraseQuery);
+    RUN_TEST(TestPrefixAndWildcardSearch);
+    RUN_TEST(TestFuzzySearch);
+    RUN_TEST(TestRankers);
+    RUN_TEST(TestTokenization);
+    RUN_TEST(TestAttributeFilter);
+    RUN_TEST(TestWordFrequencies);
+    RUN_TEST(TestTermFreqPrecision);
+    RUN_TEST(TestScoreKernel);
+    RUN_TEST(TestQueryExecutor);
+    RUN_TEST(TestAdmissionControl);
+    RUN_TEST(TestSlidingWindowStats);
+    RUN_TEST(TestExplainQuery);
+    RUN_TEST(TestExecutionThresholds);
+    RUN_TEST(TestMemoryStats);
+    RUN_TEST(TestIndexAllocator);
+    RUN_TEST(TestCorpusReader);
+    RUN_TEST(TestWriteAheadLog);
+    RUN_TEST(TestSearchService);
+    RUN_TEST(TestResultCursors);
+    RUN_TEST(TestParallelIndexBuild);
+    RUN_TEST(TestStopWordChange);
+    RUN_TEST(TestIndexStats);
 
     std::cout << "Search server testing finished"s << std::endl;
 }
@@ -5,7 +5,15 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <sstream>
 #include "search_server.h"
+#include "query_executor.h"
+#include "request_queue.h"
+#include "corpus_reader.h"
+#include "write_ahead_log.h"
+#include "search_service.h"
+#include "http_server.h"
+#include "result_cursors.h"
 
 template <typename T>
 std::ostream& operator<<(std::ostream& out, const std::vector<T>& items);
@@ -39,6 +47,29 @@ void TestRelevanceSorting();
 void TestRatingDocuments();
 void TestStatusFilter();
 void TestPredicateFilter();
+void TestBooleanAndPhraseQuery();
+void TestPrefixAndWildcardSearch();
+void TestFuzzySearch();
+void TestRankers();
+void TestTokenization();
+void TestAttributeFilter();
+void TestWordFrequencies();
+void TestTermFreqPrecision();
+void TestScoreKernel();
+void TestQueryExecutor();
+void TestAdmissionControl();
+void TestSlidingWindowStats();
+void TestExplainQuery();
+void TestExecutionThresholds();
+void TestMemoryStats();
+void TestIndexAllocator();
+void TestCorpusReader();
+void TestWriteAheadLog();
+void TestSearchService();
+void TestResultCursors();
+void TestParallelIndexBuild();
+void TestStopWordChange();
+void TestIndexStats();
 
 template <typename T>
 void RunTestImpl(T func, const std::string& func_name);
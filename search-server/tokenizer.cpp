@@ -0,0 +1,255 @@
+#include "tokenizer.h"
+#include "string_processing.h"
+
+#include <array>
+#include <utility>
+
+using namespace std::literals;
+
+namespace
+{
+    enum class ByteClass : unsigned char
+    {
+        SEPARATOR,
+        WORD,
+        WILDCARD,
+        MULTIBYTE,
+    };
+
+    constexpr std::array<ByteClass, 256> MakeByteClasses()
+    {
+        std::array<ByteClass, 256> classes{};
+        for(int c = 0; c < 256; ++c)
+        {
+            if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_')
+            {
+                classes[c] = ByteClass::WORD;
+            }
+            else if(c == '*' || c == '?')
+            {
+                classes[c] = ByteClass::WILDCARD;
+            }
+            else if(c >= 0x80)
+            {
+                classes[c] = ByteClass::MULTIBYTE;
+            }
+            else
+            {
+                classes[c] = ByteClass::SEPARATOR;
+            }
+        }
+
+        return classes;
+    }
+
+    constexpr std::array<char, 128> MakeAsciiLower()
+    {
+        std::array<char, 128> lower{};
+        for(int c = 0; c < 128; ++c)
+        {
+            lower[c] = static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+        }
+
+        return lower;
+    }
+
+    constexpr std::array<unsigned char, 256> MakeSequenceLengths()
+    {
+        std::array<unsigned char, 256> lengths{};
+        for(int c = 0; c < 256; ++c)
+        {
+            lengths[c] = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+        }
+
+        return lengths;
+    }
+
+    constexpr std::array<ByteClass, 256> BYTE_CLASSES = MakeByteClasses();
+    constexpr std::array<char, 128> ASCII_LOWER = MakeAsciiLower();
+    constexpr std::array<unsigned char, 256> SEQUENCE_LENGTHS = MakeSequenceLengths();
+
+    // Знаки препинания и пробелы вне ASCII: U+0080–U+00BF, U+2000–U+206F, U+3000–U+303F
+    bool IsMultibyteSeparator(unsigned char lead, unsigned char second)
+    {
+        return (lead == 0xC2) || (lead == 0xE2 && (second == 0x80 || second == 0x81)) || (lead == 0xE3 && second == 0x80);
+    }
+
+    // Кириллица занимает два байта с ведущим 0xD0 или 0xD1
+    void AppendFoldedCyrillic(unsigned char lead, unsigned char second, std::string& buffer)
+    {
+        if(lead == 0xD0 && second == 0x81)
+        {
+            // Ё -> е
+            second = 0xB5;
+        }
+        else if(lead == 0xD1 && second == 0x91)
+        {
+            // ё -> е
+            lead = 0xD0;
+            second = 0xB5;
+        }
+        else if(lead == 0xD0 && second < 0x90)
+        {
+            // Ѐ–Џ -> ѐ–џ
+            lead = 0xD1;
+            second += 0x10;
+        }
+        else if(lead == 0xD0 && second < 0xA0)
+        {
+            // А–П -> а–п
+            second += 0x20;
+        }
+        else if(lead == 0xD0 && second < 0xB0)
+        {
+            // Р–Я -> р–я
+            lead = 0xD1;
+            second -= 0x20;
+        }
+
+        buffer.push_back(static_cast<char>(lead));
+        buffer.push_back(static_cast<char>(second));
+    }
+
+    // Окончания упорядочены по убыванию длины, чтобы отсекалось самое длинное из подходящих
+    const std::array STEM_SUFFIXES = {
+        "иями"sv, "ами"sv, "ями"sv, "ого"sv, "его"sv, "ому"sv, "ему"sv, "ыми"sv, "ими"sv,
+        "ing"sv,
+        "ой"sv, "ей"sv, "ий"sv, "ый"sv, "ая"sv, "яя"sv, "ое"sv, "ее"sv, "ые"sv, "ие"sv,
+        "ах"sv, "ях"sv, "ов"sv, "ев"sv, "ом"sv, "ем"sv, "ам"sv, "ям"sv, "ую"sv, "юю"sv,
+        "ed"sv, "es"sv,
+        "а"sv, "я"sv, "о"sv, "е"sv, "ы"sv, "и"sv, "у"sv, "ю"sv, "ь"sv,
+        "s"sv,
+    };
+}
+
+Tokenizer::Tokenizer(bool stemming_enabled) : stemming_enabled_(stemming_enabled)
+{
+}
+
+bool Tokenizer::IsStemmingEnabled() const
+{
+    return stemming_enabled_;
+}
+
+void Tokenizer::SetStemmingEnabled(bool enabled)
+{
+    stemming_enabled_ = enabled;
+}
+
+std::vector<std::string_view> Tokenizer::Tokenize(std::string_view text, std::string& buffer, bool keep_wildcards) const
+{
+    buffer.clear();
+    buffer.reserve(text.size());
+
+    std::vector<std::pair<size_t, size_t>> bounds;
+    size_t word_begin = 0;
+    bool in_word = false;
+
+    const auto finish_word = [&]() {
+        if(in_word)
+        {
+            bounds.push_back({word_begin, buffer.size() - word_begin});
+            in_word = false;
+        }
+    };
+
+    const auto start_word = [&]() {
+        if(!in_word)
+        {
+            word_begin = buffer.size();
+            in_word = true;
+        }
+    };
+
+    for(size_t i = 0; i < text.size();)
+    {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+
+        switch(BYTE_CLASSES[c])
+        {
+            case ByteClass::WORD:
+                start_word();
+                buffer.push_back(ASCII_LOWER[c]);
+                ++i;
+                break;
+
+            case ByteClass::WILDCARD:
+                if(keep_wildcards)
+                {
+                    start_word();
+                    buffer.push_back(static_cast<char>(c));
+                }
+                else
+                {
+                    finish_word();
+                }
+                ++i;
+                break;
+
+            case ByteClass::SEPARATOR:
+                finish_word();
+                ++i;
+                break;
+
+            case ByteClass::MULTIBYTE:
+            {
+                const size_t length = SEQUENCE_LENGTHS[c];
+                const unsigned char second = i + 1 < text.size() ? static_cast<unsigned char>(text[i + 1]) : 0;
+                if(length == 1 || i + length > text.size() || (second & 0xC0) != 0x80)
+                {
+                    // Байт продолжения или испорченная последовательность копируются как есть
+                    start_word();
+                    buffer.push_back(static_cast<char>(c));
+                    ++i;
+                    break;
+                }
+
+                if(IsMultibyteSeparator(c, second))
+                {
+                    finish_word();
+                }
+                else if(c == 0xD0 || c == 0xD1)
+                {
+                    start_word();
+                    AppendFoldedCyrillic(c, second, buffer);
+                }
+                else
+                {
+                    start_word();
+                    buffer.append(text.substr(i, length));
+                }
+                i += length;
+                break;
+            }
+        }
+    }
+    finish_word();
+
+    std::vector<std::string_view> words;
+    words.reserve(bounds.size());
+    for(const auto& [begin, length] : bounds)
+    {
+        words.push_back(std::string_view(buffer).substr(begin, length));
+    }
+
+    return words;
+}
+
+std::string_view Tokenizer::Stem(std::string_view word) const
+{
+    if(!stemming_enabled_ || word.find_first_of("*?") != word.npos)
+    {
+        return word;
+    }
+
+    for(std::string_view suffix : STEM_SUFFIXES)
+    {
+        if(word.size() > suffix.size() && word.substr(word.size() - suffix.size()) == suffix
+           && CountUtf8Chars(word.substr(0, word.size() - suffix.size())) >= MIN_STEM_LENGTH)
+        {
+            return word.substr(0, word.size() - suffix.size());
+        }
+    }
+
+    return word;
+}
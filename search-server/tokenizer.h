@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Стемминг не укорачивает слово меньше чем до MIN_STEM_LENGTH символов
+const size_t MIN_STEM_LENGTH = 3;
+
+// Разбиение текста UTF-8 на слова по пробельным символам и знакам препинания
+// с приведением к нижнему регистру (латиница и кириллица, ё приводится к е).
+// Классы байтов и регистр берутся из таблиц. Стемминг отсекает окончания и применяется
+// после проверки на стоп-слово, поэтому стоп-слова задаются в полной форме
+class Tokenizer
+{
+    public:
+        explicit Tokenizer(bool stemming_enabled = false);
+
+        bool IsStemmingEnabled() const;
+        void SetStemmingEnabled(bool enabled);
+
+        // Нормализованные слова записываются в buffer, возвращаемые string_view указывают в него.
+        // При keep_wildcards символы '*' и '?' считаются частью слова
+        std::vector<std::string_view> Tokenize(std::string_view text, std::string& buffer, bool keep_wildcards = false) const;
+
+        // Основа слова — его префикс. Без стемминга и для шаблонов с '*' или '?' слово возвращается целиком
+        std::string_view Stem(std::string_view word) const;
+
+    private:
+        bool stemming_enabled_;
+};
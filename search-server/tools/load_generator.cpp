@@ -0,0 +1,290 @@
+// Нагрузочный клиент для search_service: наполняет индекс случайными документами и замеряет QPS и хвосты задержки
+// поисковых запросов. Каждое соединение держит до depth запросов в конвейере.
+// Собирается так же, как tools/search_service.cpp.
+//
+// load_generator [--host 127.0.0.1] [--port 8080] [--connections 8] [--depth 4] [--duration 10]
+//                [--documents 10000] [--dictionary 20000]
+
+#include "../search_service.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std::literals;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    struct Options
+    {
+        std::string host = "127.0.0.1"s;
+        uint16_t port = 8080;
+        int connections = 8;
+        int depth = 4;
+        double duration_seconds = 10.0;
+        int documents = 10000;
+        int dictionary_size = 20000;
+    };
+
+    std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count)
+    {
+        std::vector<std::string> words(word_count);
+        for(std::string& word : words)
+        {
+            const int length = std::uniform_int_distribution(1, 10)(generator);
+            for(int i = 0; i < length; ++i)
+            {
+                word.push_back(std::uniform_int_distribution('a', 'z')(generator));
+            }
+        }
+
+        return words;
+    }
+
+    std::string GenerateText(std::mt19937& generator, const std::vector<std::string>& dictionary, int word_count)
+    {
+        std::string text;
+        for(int i = 0; i < word_count; ++i)
+        {
+            if(i > 0)
+            {
+                text.push_back(' ');
+            }
+            text += dictionary[std::uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)];
+        }
+
+        return text;
+    }
+
+    class Connection
+    {
+        public:
+            Connection(const std::string& host, uint16_t port)
+            {
+                sockaddr_in address{};
+                address.sin_family = AF_INET;
+                address.sin_port = htons(port);
+                socket_ = socket(AF_INET, SOCK_STREAM, 0);
+                if(socket_ < 0 || inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1
+                   || connect(socket_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+                {
+                    throw std::runtime_error("Не удалось подключиться к "s + host + ":"s + std::to_string(port));
+                }
+                const int enable = 1;
+                setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+            }
+
+            ~Connection()
+            {
+                close(socket_);
+            }
+
+            Connection(const Connection&) = delete;
+            Connection& operator=(const Connection&) = delete;
+
+            void Send(std::string_view data)
+            {
+                while(!data.empty())
+                {
+                    const ssize_t written = send(socket_, data.data(), data.size(), MSG_NOSIGNAL);
+                    if(written <= 0)
+                    {
+                        throw std::runtime_error("Соединение закрыто сервером"s);
+                    }
+                    data.remove_prefix(written);
+                }
+            }
+
+            // Читает один ответ и возвращает его код
+            int ReadResponse()
+            {
+                while(true)
+                {
+                    const size_t header_end = input_.find("\r\n\r\n"sv);
+                    if(header_end != std::string::npos)
+                    {
+                        const size_t length_begin = input_.find("Content-Length: "sv);
+                        const size_t body_length = length_begin < header_end ? std::stoul(input_.substr(length_begin + 16)) : 0;
+                        if(input_.size() >= header_end + 4 + body_length)
+                        {
+                            const int status = std::stoi(input_.substr(input_.find(' ') + 1, 3));
+                            input_.erase(0, header_end + 4 + body_length);
+                            return status;
+                        }
+                    }
+
+                    char buffer[64 * 1024];
+                    const ssize_t read_size = recv(socket_, buffer, sizeof(buffer), 0);
+                    if(read_size <= 0)
+                    {
+                        throw std::runtime_error("Соединение закрыто сервером"s);
+                    }
+                    input_.append(buffer, read_size);
+                }
+            }
+
+        private:
+            int socket_ = -1;
+            std::string input_;
+    };
+
+    std::string MakeSearchRequest(const std::string& query)
+    {
+        return "GET /search?query="s + EncodeUrl(query) + " HTTP/1.1\r\nHost: localhost\r\n\r\n"s;
+    }
+
+    void LoadDocuments(const Options& options, const std::vector<std::string>& dictionary, std::mt19937& generator)
+    {
+        Connection connection(options.host, options.port);
+        const int batch_size = std::max(options.depth, 1) * 16;
+        const auto start = Clock::now();
+
+        for(int first = 0; first < options.documents; first += batch_size)
+        {
+            const int last = std::min(first + batch_size, options.documents);
+            std::string requests;
+            for(int id = first; id < last; ++id)
+            {
+                const std::string text = GenerateText(generator, dictionary, 100);
+                requests += "POST /documents?id="s + std::to_string(id) + "&ratings=1,2,3 HTTP/1.1\r\nContent-Length: "s
+                    + std::to_string(text.size()) + "\r\n\r\n"s + text;
+            }
+            connection.Send(requests);
+            for(int id = first; id < last; ++id)
+            {
+                if(connection.ReadResponse() != 200)
+                {
+                    throw std::runtime_error("Документ "s + std::to_string(id) + " не добавлен"s);
+                }
+            }
+        }
+
+        const std::chrono::duration<double> duration = Clock::now() - start;
+        std::cerr << "Added "sv << options.documents << " documents: "sv << options.documents / duration.count() << " documents/s"sv << std::endl;
+    }
+
+    double GetPercentile(const std::vector<double>& sorted_latencies, double percentile)
+    {
+        if(sorted_latencies.empty())
+        {
+            return 0.0;
+        }
+
+        const size_t index = static_cast<size_t>(percentile / 100.0 * (sorted_latencies.size() - 1) + 0.5);
+        return sorted_latencies[index];
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    for(int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string_view option = argv[i];
+        const std::string value = argv[i + 1];
+        if(option == "--host"sv)
+        {
+            options.host = value;
+        }
+        else if(option == "--port"sv)
+        {
+            options.port = static_cast<uint16_t>(std::stoi(value));
+        }
+        else if(option == "--connections"sv)
+        {
+            options.connections = std::stoi(value);
+        }
+        else if(option == "--depth"sv)
+        {
+            options.depth = std::stoi(value);
+        }
+        else if(option == "--duration"sv)
+        {
+            options.duration_seconds = std::stod(value);
+        }
+        else if(option == "--documents"sv)
+        {
+            options.documents = std::stoi(value);
+        }
+        else if(option == "--dictionary"sv)
+        {
+            options.dictionary_size = std::stoi(value);
+        }
+        else
+        {
+            std::cerr << "Unknown option "sv << option << std::endl;
+            return 1;
+        }
+    }
+
+    std::mt19937 generator;
+    const std::vector<std::string> dictionary = GenerateDictionary(generator, options.dictionary_size);
+    LoadDocuments(options, dictionary, generator);
+
+    std::mutex latencies_mutex;
+    std::vector<double> latencies;
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration_seconds));
+
+    std::vector<std::thread> threads;
+    for(int connection_index = 0; connection_index < options.connections; ++connection_index)
+    {
+        threads.emplace_back([&, connection_index]() {
+            std::mt19937 query_generator(connection_index);
+            Connection connection(options.host, options.port);
+            std::deque<Clock::time_point> send_times;
+            std::vector<double> connection_latencies;
+
+            const auto send_query = [&]() {
+                connection.Send(MakeSearchRequest(GenerateText(query_generator, dictionary, 3)));
+                send_times.push_back(Clock::now());
+            };
+
+            for(int i = 0; i < options.depth; ++i)
+            {
+                send_query();
+            }
+            while(!send_times.empty())
+            {
+                connection.ReadResponse();
+                const std::chrono::duration<double, std::micro> latency = Clock::now() - send_times.front();
+                connection_latencies.push_back(latency.count());
+                send_times.pop_front();
+                if(Clock::now() < deadline)
+                {
+                    send_query();
+                }
+            }
+
+            std::lock_guard guard(latencies_mutex);
+            latencies.insert(latencies.end(), connection_latencies.begin(), connection_latencies.end());
+        });
+    }
+    for(std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    const std::chrono::duration<double> duration = Clock::now() - start;
+    std::sort(latencies.begin(), latencies.end());
+    std::cerr << "Queries: "sv << latencies.size() << ", QPS "sv << latencies.size() / duration.count()
+              << ", latency us: p50 "sv << GetPercentile(latencies, 50) << ", p90 "sv << GetPercentile(latencies, 90)
+              << ", p99 "sv << GetPercentile(latencies, 99) << ", p99.9 "sv << GetPercentile(latencies, 99.9)
+              << ", max "sv << (latencies.empty() ? 0.0 : latencies.back()) << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+// HTTP-сервис поиска поверх SearchServer, см. search_service.h и http_server.h.
+// Собирается из этого файла и всех .cpp каталога search-server, кроме main.cpp, test_example_functions.cpp
+// и benchmark_functions.cpp, с -ltbb.
+//
+// search_service [--port N] [--address A] [--stop-words "..."] [--corpus PATH --format tsv|jsonl] [--wal PATH]
+//
+// Корпус загружается при запуске, затем из журнала восстанавливаются изменения, сделанные после его загрузки.
+// С журналом каждое изменение через HTTP фиксируется в нём до отправки ответа
+
+#include "../corpus_reader.h"
+#include "../http_server.h"
+#include "../search_service.h"
+#include "../write_ahead_log.h"
+
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace std::literals;
+
+namespace
+{
+    HttpServer* running_server = nullptr;
+
+    void StopOnSignal(int)
+    {
+        if(running_server != nullptr)
+        {
+            running_server->Stop();
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    uint16_t port = 8080;
+    std::string address = "127.0.0.1"s;
+    std::string stop_words;
+    std::string corpus_path;
+    CorpusFormat corpus_format = CorpusFormat::TSV;
+    std::string wal_path;
+
+    for(int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string_view option = argv[i];
+        const std::string value = argv[i + 1];
+        if(option == "--port"sv)
+        {
+            port = static_cast<uint16_t>(std::stoi(value));
+        }
+        else if(option == "--address"sv)
+        {
+            address = value;
+        }
+        else if(option == "--stop-words"sv)
+        {
+            stop_words = value;
+        }
+        else if(option == "--corpus"sv)
+        {
+            corpus_path = value;
+        }
+        else if(option == "--format"sv)
+        {
+            corpus_format = value == "jsonl"sv ? CorpusFormat::JSONL : CorpusFormat::TSV;
+        }
+        else if(option == "--wal"sv)
+        {
+            wal_path = value;
+        }
+        else
+        {
+            std::cerr << "Unknown option "sv << option << std::endl;
+            return 1;
+        }
+    }
+
+    SearchServer search_server(stop_words);
+    if(!corpus_path.empty())
+    {
+        std::cerr << "Loaded "sv << LoadCorpus(search_server, corpus_path, corpus_format) << " documents from "sv << corpus_path << std::endl;
+    }
+
+    std::unique_ptr<WriteAheadLog> wal;
+    if(!wal_path.empty())
+    {
+        const WalReplayStats stats = ReplayWriteAheadLog(wal_path, search_server);
+        std::cerr << "Replayed "sv << stats.applied_records << " log records, discarded "sv << stats.discarded_bytes << " bytes"sv << std::endl;
+        wal = std::make_unique<WriteAheadLog>(wal_path);
+    }
+
+    SearchService service(search_server, wal.get());
+    HttpServer server(service, port, address);
+    running_server = &server;
+    std::signal(SIGINT, StopOnSignal);
+    std::signal(SIGTERM, StopOnSignal);
+
+    std::cerr << "Listening on "sv << address << ':' << server.GetPort() << std::endl;
+    server.Run();
+    std::cerr << "Handled "sv << server.GetHandledRequestCount() << " requests in "sv << server.GetBatchCount() << " batches"sv << std::endl;
+
+    return 0;
+}
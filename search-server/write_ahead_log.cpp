@@ -0,0 +1,351 @@
+#include "write_ahead_log.h"
+#include "corpus_reader.h"
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <unistd.h>
+#define HAS_FDATASYNC
+#endif
+
+using namespace std::literals;
+
+namespace
+{
+    const size_t WAL_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+    std::array<uint32_t, 256> MakeCrc32Table()
+    {
+        std::array<uint32_t, 256> table{};
+        for(uint32_t byte = 0; byte < 256; ++byte)
+        {
+            uint32_t crc = byte;
+            for(int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320u : 0u);
+            }
+            table[byte] = crc;
+        }
+
+        return table;
+    }
+
+    const std::array<uint32_t, 256> CRC32_TABLE = MakeCrc32Table();
+
+    template <typename T>
+    void AppendValue(std::string& out, T value)
+    {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        out.append(bytes, sizeof(T));
+    }
+
+    // Читает значение и сдвигает data. При нехватке байтов возвращает false
+    template <typename T>
+    bool ReadValue(std::string_view& data, T& value)
+    {
+        if(data.size() < sizeof(T))
+        {
+            return false;
+        }
+        std::memcpy(&value, data.data(), sizeof(T));
+        data.remove_prefix(sizeof(T));
+        return true;
+    }
+
+    struct WalRecord
+    {
+        WalRecordType type;
+        int document_id;
+        DocumentStatus status;
+        std::vector<int> ratings;
+        std::string_view text;
+    };
+
+    bool ParseWalBody(std::string_view body, WalRecord& record)
+    {
+        uint8_t type = 0;
+        if(!ReadValue(body, type) || !ReadValue(body, record.document_id))
+        {
+            return false;
+        }
+        record.type = static_cast<WalRecordType>(type);
+
+        if(record.type == WalRecordType::REMOVE_DOCUMENT)
+        {
+            return body.empty();
+        }
+        if(record.type != WalRecordType::ADD_DOCUMENT)
+        {
+            return false;
+        }
+
+        uint8_t status = 0;
+        uint32_t rating_count = 0;
+        if(!ReadValue(body, status) || status > static_cast<uint8_t>(DocumentStatus::REMOVED) || !ReadValue(body, rating_count)
+           || rating_count > body.size() / sizeof(int))
+        {
+            return false;
+        }
+        record.status = static_cast<DocumentStatus>(status);
+
+        record.ratings.resize(rating_count);
+        for(int& rating : record.ratings)
+        {
+            ReadValue(body, rating);
+        }
+
+        uint32_t text_length = 0;
+        if(!ReadValue(body, text_length) || text_length != body.size())
+        {
+            return false;
+        }
+        record.text = body;
+
+        return true;
+    }
+
+    // Вызывает function для записей журнала до первой оборванной или повреждённой и возвращает длину корректной части
+    template <typename Function>
+    size_t ForEachWalRecord(std::string_view data, Function function)
+    {
+        size_t valid_bytes = 0;
+        std::string_view rest = data;
+        WalRecord record;
+
+        while(true)
+        {
+            uint32_t body_length = 0;
+            uint32_t crc = 0;
+            if(!ReadValue(rest, body_length) || !ReadValue(rest, crc) || body_length > rest.size())
+            {
+                break;
+            }
+
+            const std::string_view body = rest.substr(0, body_length);
+            if(ComputeCrc32(body) != crc || !ParseWalBody(body, record))
+            {
+                break;
+            }
+
+            function(record);
+            rest.remove_prefix(body_length);
+            valid_bytes += WAL_HEADER_SIZE + body_length;
+        }
+
+        return valid_bytes;
+    }
+}
+
+uint32_t ComputeCrc32(std::string_view data, uint32_t crc)
+{
+    crc = ~crc;
+    for(const char c : data)
+    {
+        crc = CRC32_TABLE[(crc ^ static_cast<uint8_t>(c)) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& path, const WalSyncPolicy& sync_policy) : path_(path), sync_policy_(sync_policy)
+{
+    if(std::filesystem::exists(path_))
+    {
+        size_t valid_bytes = 0;
+        {
+            const MappedFile file(path_);
+            valid_bytes = ForEachWalRecord(file.GetData(), [](const WalRecord&) {});
+        }
+        if(valid_bytes != std::filesystem::file_size(path_))
+        {
+            std::filesystem::resize_file(path_, valid_bytes);
+        }
+        synced_size_ = valid_bytes;
+    }
+
+    file_ = std::fopen(path_.c_str(), "ab");
+    if(file_ == nullptr)
+    {
+        throw std::runtime_error("Не удалось открыть журнал "s + path_);
+    }
+}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    try
+    {
+        Sync();
+    }
+    catch(...)
+    {
+    }
+    if(file_ != nullptr)
+    {
+        std::fclose(file_);
+    }
+}
+
+void WriteAheadLog::LogAddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings)
+{
+    std::string body;
+    body.reserve(sizeof(uint8_t) + sizeof(uint32_t) * 2 + ratings.size() * sizeof(int) + document.size());
+    AppendValue(body, static_cast<uint8_t>(status));
+    AppendValue(body, static_cast<uint32_t>(ratings.size()));
+    for(const int rating : ratings)
+    {
+        AppendValue(body, rating);
+    }
+    AppendValue(body, static_cast<uint32_t>(document.size()));
+    body.append(document);
+
+    Append(WalRecordType::ADD_DOCUMENT, document_id, body);
+}
+
+void WriteAheadLog::LogRemoveDocument(int document_id)
+{
+    Append(WalRecordType::REMOVE_DOCUMENT, document_id, {});
+}
+
+void WriteAheadLog::Sync()
+{
+    std::lock_guard guard(mutex_);
+    SyncLocked();
+}
+
+void WriteAheadLog::Truncate()
+{
+    std::lock_guard guard(mutex_);
+    ThrowIfFailedLocked();
+    buffer_.clear();
+    pending_records_ = 0;
+
+    std::fflush(file_);
+    std::filesystem::resize_file(path_, 0);
+    synced_size_ = 0;
+}
+
+size_t WriteAheadLog::GetPendingRecordCount() const
+{
+    std::lock_guard guard(mutex_);
+    return pending_records_;
+}
+
+size_t WriteAheadLog::GetSyncCount() const
+{
+    std::lock_guard guard(mutex_);
+    return sync_count_;
+}
+
+bool WriteAheadLog::IsFailed() const
+{
+    std::lock_guard guard(mutex_);
+    return is_failed_;
+}
+
+void WriteAheadLog::Append(WalRecordType type, int document_id, std::string_view body)
+{
+    std::string record_body;
+    record_body.reserve(sizeof(uint8_t) + sizeof(int) + body.size());
+    AppendValue(record_body, static_cast<uint8_t>(type));
+    AppendValue(record_body, document_id);
+    record_body.append(body);
+
+    std::lock_guard guard(mutex_);
+    ThrowIfFailedLocked();
+    AppendValue(buffer_, static_cast<uint32_t>(record_body.size()));
+    AppendValue(buffer_, ComputeCrc32(record_body));
+    buffer_.append(record_body);
+    ++pending_records_;
+
+    if(pending_records_ >= sync_policy_.max_pending_records || buffer_.size() >= sync_policy_.max_pending_bytes)
+    {
+        SyncLocked();
+    }
+}
+
+void WriteAheadLog::SyncLocked()
+{
+    ThrowIfFailedLocked();
+    if(pending_records_ == 0)
+    {
+        return;
+    }
+
+    if(std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size() || std::fflush(file_) != 0)
+    {
+        FailLocked();
+        throw std::runtime_error("Не удалось записать журнал "s + path_);
+    }
+#ifdef HAS_FDATASYNC
+    if(fdatasync(fileno(file_)) != 0)
+    {
+        FailLocked();
+        throw std::runtime_error("Не удалось сбросить журнал на диск "s + path_);
+    }
+#endif
+
+    synced_size_ += buffer_.size();
+    buffer_.clear();
+    pending_records_ = 0;
+    ++sync_count_;
+}
+
+// Начало группы могло попасть в файл. Если бы буфер записывался повторно, оборванная запись оказалась бы
+// в середине журнала, и при открытии отрезались бы все сохранённые после неё записи.
+// Файл закрывается раньше обрезки, потому что fclose дописывает остаток буфера stdio
+void WriteAheadLog::FailLocked()
+{
+    is_failed_ = true;
+    buffer_.clear();
+    pending_records_ = 0;
+
+    std::fclose(file_);
+    file_ = nullptr;
+    std::error_code error;
+    std::filesystem::resize_file(path_, synced_size_, error);
+}
+
+void WriteAheadLog::ThrowIfFailedLocked() const
+{
+    if(is_failed_)
+    {
+        throw std::runtime_error("Журнал "s + path_ + " недоступен после ошибки записи"s);
+    }
+}
+
+WalReplayStats ReplayWriteAheadLog(const std::string& path, SearchServer& search_server)
+{
+    WalReplayStats stats;
+    if(!std::filesystem::exists(path))
+    {
+        return stats;
+    }
+
+    const MappedFile file(path);
+    std::vector<DocumentRecord> added_documents;
+    const auto flush_added_documents = [&search_server, &added_documents]() {
+        search_server.AddDocuments(added_documents);
+        added_documents.clear();
+    };
+
+    stats.valid_bytes = ForEachWalRecord(file.GetData(), [&](const WalRecord& record) {
+        if(record.type == WalRecordType::ADD_DOCUMENT)
+        {
+            added_documents.push_back({record.document_id, record.status, record.ratings, record.text});
+        }
+        else
+        {
+            flush_added_documents();
+            search_server.RemoveDocument(record.document_id);
+        }
+        ++stats.applied_records;
+    });
+    flush_added_documents();
+
+    stats.discarded_bytes = file.GetData().size() - stats.valid_bytes;
+    return stats;
+}
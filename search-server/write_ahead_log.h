@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "document.h"
+#include "search_server.h"
+
+// Журнал изменений индекса. Запись — заголовок из длины и CRC-32 тела, затем тело: тип изменения,
+// id и для добавления статус, рейтинги и текст. Числа хранятся в порядке байтов little-endian.
+// Запись с неверной длиной или контрольной суммой считается оборванной при сбое,
+// она и всё после неё отбрасываются
+enum class WalRecordType : uint8_t
+{
+    ADD_DOCUMENT = 1,
+    REMOVE_DOCUMENT = 2,
+};
+
+// Групповая фиксация: записи копятся в буфере и сбрасываются на диск одним write и fsync,
+// когда накопилось max_pending_records записей или max_pending_bytes байт. Нули фиксируют каждую запись
+struct WalSyncPolicy
+{
+    size_t max_pending_records = 64;
+    size_t max_pending_bytes = 1024 * 1024;
+};
+
+struct WalReplayStats
+{
+    size_t applied_records = 0;
+    size_t valid_bytes = 0;
+    // Байты оборванной или повреждённой записи в конце журнала
+    size_t discarded_bytes = 0;
+};
+
+uint32_t ComputeCrc32(std::string_view data, uint32_t crc = 0);
+
+// Журнал открывается на дозапись. Оборванный хвост, оставшийся от сбоя, отрезается при открытии.
+// Методы потокобезопасны. Изменение считается сохранённым после фиксации, то есть после Sync
+// или после того, как группа, в которую попала запись, сброшена на диск.
+// Если фиксация не удалась, файл обрезается до конца последней успешной группы, несохранённые записи
+// отбрасываются, и журнал переходит в состояние ошибки: все следующие вызовы бросают исключение
+class WriteAheadLog
+{
+    public:
+        explicit WriteAheadLog(const std::string& path, const WalSyncPolicy& sync_policy = {});
+        ~WriteAheadLog();
+
+        WriteAheadLog(const WriteAheadLog&) = delete;
+        WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+        void LogAddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+        void LogRemoveDocument(int document_id);
+
+        // Сбрасывает накопленные записи на диск и дожидается fsync
+        void Sync();
+        // Очищает журнал, например после сохранения полного снимка индекса
+        void Truncate();
+
+        size_t GetPendingRecordCount() const;
+        size_t GetSyncCount() const;
+        bool IsFailed() const;
+
+    private:
+        std::string path_;
+        WalSyncPolicy sync_policy_;
+        std::FILE* file_ = nullptr;
+        mutable std::mutex mutex_;
+        std::string buffer_;
+        size_t pending_records_ = 0;
+        size_t sync_count_ = 0;
+        // Размер файла после последней успешной фиксации
+        uintmax_t synced_size_ = 0;
+        bool is_failed_ = false;
+
+        void Append(WalRecordType type, int document_id, std::string_view body);
+        void SyncLocked();
+        void FailLocked();
+        void ThrowIfFailedLocked() const;
+};
+
+// Применяет к серверу изменения из журнала по порядку. Подряд идущие добавления передаются
+// в AddDocuments пакетом, тексты читаются прямо из отображённого в память файла.
+// Отсутствующий файл считается пустым журналом
+WalReplayStats ReplayWriteAheadLog(const std::string& path, SearchServer& search_server);